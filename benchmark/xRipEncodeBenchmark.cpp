@@ -0,0 +1,588 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "xArchiveFile.h"
+#include "xMovieFile.h"
+#include "xAudioFile.h"
+#include "xLogSink.h"
+#include "xRipEncodeConfiguration.h"
+
+#include <archive.h>
+#include <archive_entry.h>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTemporaryDir>
+#include <QEventLoop>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QTextStream>
+#include <QtEndian>
+#include <QMap>
+#include <QDebug>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cstring>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/channel_layout.h>
+}
+
+// The synthetic audio is CD quality.
+const int xRipEncodeBenchmark_SampleRate { 44100 };
+const int xRipEncodeBenchmark_Channels { 2 };
+const int xRipEncodeBenchmark_BytesPerFrame { xRipEncodeBenchmark_Channels*2 };
+// Frames generated at once for the fixtures.
+const int xRipEncodeBenchmark_BlockFrames { 4096 };
+// Maximal time in ms to wait for the completion of a stage.
+const int xRipEncodeBenchmark_Timeout { 600000 };
+// Artist and album matching the Bandcamp tag lookup scheme.
+const QString xRipEncodeBenchmark_Artist { "Benchmark Artist" };
+const QString xRipEncodeBenchmark_Album { "Benchmark Album" };
+
+// The AVChannelLayout API replaces the channel masks with FFmpeg 5.1.
+#define xRipEncodeBenchmark_ChannelLayoutAPI (LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(59, 24, 100))
+
+/**
+ * @class xRipEncodeBenchmark
+ *
+ * @note Repeatable benchmark of the archive file analysis, tag lookup and
+ * extraction, the movie file analysis and extraction and the flac encoding.
+ * The fixtures (wav files, zip and tar archive, mkv file with chapters) are
+ * generated deterministically, the results of different revisions can
+ * therefore be compared. The movie file analysis requires ffprobe and the
+ * encoding requires flac as configured in xRipEncode.
+ */
+class xRipEncodeBenchmark {
+public:
+    /**
+     * Constructor.
+     *
+     * @param directory the working directory for the fixtures and outputs.
+     * @param tracks the number of tracks of each fixture.
+     * @param seconds the length of each track in seconds.
+     */
+    xRipEncodeBenchmark(const QString& directory, int tracks, int seconds);
+    /**
+     * Generate the wav files, the archives and the movie file.
+     *
+     * @return true if all fixtures were created, false otherwise.
+     */
+    bool createFixtures();
+    /**
+     * Run all stages once.
+     *
+     * @return true if all stages completed, false otherwise.
+     */
+    bool run();
+    /**
+     * Print the minimum and median time and the throughput of each stage.
+     */
+    void report() const;
+
+private:
+    /**
+     * Generate the interleaved 16 bit samples for the given frames.
+     *
+     * @param frame the first frame.
+     * @param frames the number of frames.
+     * @return the samples as byte array.
+     */
+    [[nodiscard]] QByteArray samples(qint64 frame, int frames) const;
+    /**
+     * Write one track as wav file.
+     *
+     * @param fileName the path of the wav file.
+     * @param track the track index (starting with 0).
+     * @return true if successful, false otherwise.
+     */
+    bool writeWav(const QString& fileName, int track) const;
+    /**
+     * Write the wav files into a zip or tar archive.
+     *
+     * @param fileName the path of the archive.
+     * @param zip create a zip archive if true, a tar archive otherwise.
+     * @return true if successful, false otherwise.
+     */
+    bool writeArchive(const QString& fileName, bool zip) const;
+    /**
+     * Write all tracks as PCM stream into a mkv file with one chapter per track.
+     *
+     * @param fileName the path of the mkv file.
+     * @return true if successful, false otherwise.
+     */
+    bool writeMovie(const QString& fileName) const;
+    /**
+     * Benchmark the analysis, tag lookup and extraction of an archive file.
+     *
+     * @param archiveFileName the path of the archive.
+     * @param format the archive format used in the stage names.
+     * @return true if successful, false otherwise.
+     */
+    bool benchmarkArchive(const QString& archiveFileName, const QString& format);
+    /**
+     * Benchmark the analysis and extraction of the movie file followed by the encoding.
+     *
+     * @return true if successful, false otherwise.
+     */
+    bool benchmarkMovie();
+    /**
+     * Benchmark the flac encoding of the given files. The files are deleted afterwards.
+     *
+     * @param files the audio file objects to encode.
+     * @return true if successful, false otherwise.
+     */
+    bool benchmarkEncoding(const QList<xAudioFile*>& files);
+    /**
+     * Start a stage and wait for the signal marking its end.
+     *
+     * @param sender the object emitting the signal.
+     * @param signal the signal emitted at the end of the stage.
+     * @param start the function starting the stage.
+     * @param abortOnError stop waiting on the first "[error]" message if true.
+     * @return true if the signal was received, false otherwise.
+     */
+    template<typename Sender, typename Signal>
+    bool wait(Sender* sender, Signal signal, const std::function<void()>& start, bool abortOnError);
+    /**
+     * Print "[timing]" and "[error]" messages of the benchmarked objects.
+     *
+     * @param msg the message as string.
+     */
+    void message(const QString& msg);
+    /**
+     * Record the time of a stage.
+     *
+     * @param stage the name of the stage.
+     * @param ms the time in milliseconds.
+     * @param bytes the number of bytes processed, 0 if not applicable.
+     */
+    void measure(const QString& stage, qint64 ms, qint64 bytes);
+
+    QString fixtureDirectory;
+    QString tempDirectory;
+    QString encodingDirectory;
+    int benchmarkTracks;
+    int benchmarkSeconds;
+    QStringList wavFileNames;
+    QStringList stages;
+    QMap<QString,QList<qint64>> stageTimes;
+    QMap<QString,qint64> stageBytes;
+    QEventLoop* waitLoop;
+    bool waitError;
+    bool waitAbortOnError;
+};
+
+xRipEncodeBenchmark::xRipEncodeBenchmark(const QString& directory, int tracks, int seconds):
+        fixtureDirectory(directory+"/fixtures"),
+        tempDirectory(directory+"/temp"),
+        encodingDirectory(directory+"/encoding"),
+        benchmarkTracks(tracks),
+        benchmarkSeconds(seconds),
+        waitLoop(nullptr),
+        waitError(false),
+        waitAbortOnError(false) {
+    QDir().mkpath(fixtureDirectory);
+    QDir().mkpath(tempDirectory);
+    QDir().mkpath(encodingDirectory);
+    xRipEncodeConfiguration::configuration()->setTempDirectory(tempDirectory);
+    xRipEncodeConfiguration::configuration()->setEncodingDirectory(encodingDirectory);
+    // Use the internal demuxer. No mkvmerge required.
+    xRipEncodeConfiguration::configuration()->setMovieFileDemux(true);
+}
+
+bool xRipEncodeBenchmark::createFixtures() {
+    QElapsedTimer fixtureTimer;
+    fixtureTimer.start();
+    for (auto track = 0; track < benchmarkTracks; ++track) {
+        auto wavFileName = QString("%1/%2 - %3 - %4 Track %5.wav").arg(fixtureDirectory).arg(xRipEncodeBenchmark_Artist).
+                arg(xRipEncodeBenchmark_Album).arg(track+1, 2, 10, QChar('0')).arg(track+1);
+        if (!writeWav(wavFileName, track)) {
+            return false;
+        }
+        wavFileNames.push_back(wavFileName);
+    }
+    if ((!writeArchive(fixtureDirectory+"/benchmark.zip", true)) || (!writeArchive(fixtureDirectory+"/benchmark.tar", false)) ||
+        (!writeMovie(fixtureDirectory+"/benchmark.mkv"))) {
+        return false;
+    }
+    QTextStream(stdout) << "fixtures: " << benchmarkTracks << " tracks of " << benchmarkSeconds << " s in "
+                        << fixtureTimer.elapsed() << " ms" << Qt::endl;
+    return true;
+}
+
+bool xRipEncodeBenchmark::run() {
+    return benchmarkArchive(fixtureDirectory+"/benchmark.zip", "zip") &&
+           benchmarkArchive(fixtureDirectory+"/benchmark.tar", "tar") && benchmarkMovie();
+}
+
+void xRipEncodeBenchmark::report() const {
+    QTextStream out(stdout);
+    out << "stage,bytes,min_ms,median_ms,median_mb_s" << Qt::endl;
+    for (const auto& stage : stages) {
+        auto times = stageTimes[stage];
+        std::sort(times.begin(), times.end());
+        auto median = times[times.count()/2];
+        auto bytes = stageBytes.value(stage, 0);
+        out << stage << "," << bytes << "," << times.first() << "," << median << ","
+            << QString::number(xLogSink::throughput(bytes, median), 'f', 2) << Qt::endl;
+    }
+}
+
+QByteArray xRipEncodeBenchmark::samples(qint64 frame, int frames) const {
+    QByteArray data(frames*xRipEncodeBenchmark_BytesPerFrame, 0);
+    auto output = reinterpret_cast<qint16*>(data.data());
+    for (auto i = 0; i < frames; ++i, ++frame) {
+        // A different tone for each track with some deterministic noise. Pure tones compress too well.
+        auto track = frame/(static_cast<qint64>(benchmarkSeconds)*xRipEncodeBenchmark_SampleRate);
+        auto time = static_cast<double>(frame)/xRipEncodeBenchmark_SampleRate;
+        auto noise = static_cast<int>((static_cast<quint32>(frame)*1103515245u+12345u) >> 22) - 512;
+        for (auto c = 0; c < xRipEncodeBenchmark_Channels; ++c) {
+            auto tone = 8000.0*std::sin(2.0*M_PI*(220.0*static_cast<double>(1+track%7))*time+c*M_PI/3.0);
+            output[i*xRipEncodeBenchmark_Channels+c] = qToLittleEndian(static_cast<qint16>(tone+noise));
+        }
+    }
+    return data;
+}
+
+bool xRipEncodeBenchmark::writeWav(const QString& fileName, int track) const {
+    QFile wavFile(fileName);
+    if (!wavFile.open(QIODevice::WriteOnly)) {
+        qCritical() << "xRipEncodeBenchmark::writeWav: unable to open: " << fileName;
+        return false;
+    }
+    auto frames = static_cast<qint64>(benchmarkSeconds)*xRipEncodeBenchmark_SampleRate;
+    auto byteCount = static_cast<quint32>(frames*xRipEncodeBenchmark_BytesPerFrame);
+    QDataStream wavFileStream(&wavFile);
+    wavFileStream.setByteOrder(QDataStream::LittleEndian);
+    wavFileStream.writeRawData("RIFF", 4);
+    wavFileStream << quint32(byteCount+44-8);
+    wavFileStream.writeRawData("WAVEfmt ", 8);
+    wavFileStream << quint32(16) << quint16(1) << quint16(xRipEncodeBenchmark_Channels);
+    wavFileStream << quint32(xRipEncodeBenchmark_SampleRate) << quint32(xRipEncodeBenchmark_SampleRate*xRipEncodeBenchmark_BytesPerFrame);
+    wavFileStream << quint16(xRipEncodeBenchmark_BytesPerFrame) << quint16(16);
+    wavFileStream.writeRawData("data", 4);
+    wavFileStream << byteCount;
+    auto firstFrame = track*frames;
+    for (qint64 frame = 0; frame < frames; frame += xRipEncodeBenchmark_BlockFrames) {
+        auto data = samples(firstFrame+frame, static_cast<int>(std::min<qint64>(xRipEncodeBenchmark_BlockFrames, frames-frame)));
+        wavFileStream.writeRawData(data.constData(), data.size());
+    }
+    return wavFileStream.status() == QDataStream::Ok;
+}
+
+bool xRipEncodeBenchmark::writeArchive(const QString& fileName, bool zip) const {
+    auto archiveFile = archive_write_new();
+    if (zip) {
+        archive_write_set_format_zip(archiveFile);
+    } else {
+        archive_write_set_format_pax_restricted(archiveFile);
+    }
+    if (archive_write_open_filename(archiveFile, fileName.toStdString().c_str()) != ARCHIVE_OK) {
+        qCritical() << "xRipEncodeBenchmark::writeArchive: unable to open: " << fileName << ": " << archive_error_string(archiveFile);
+        archive_write_free(archiveFile);
+        return false;
+    }
+    auto written = true;
+    for (const auto& wavFileName : wavFileNames) {
+        QFile wavFile(wavFileName);
+        if (!wavFile.open(QIODevice::ReadOnly)) {
+            written = false;
+            break;
+        }
+        auto archiveEntry = archive_entry_new();
+        archive_entry_set_pathname(archiveEntry, QFileInfo(wavFileName).fileName().toStdString().c_str());
+        archive_entry_set_size(archiveEntry, wavFile.size());
+        archive_entry_set_filetype(archiveEntry, AE_IFREG);
+        archive_entry_set_perm(archiveEntry, 0644);
+        written = (archive_write_header(archiveFile, archiveEntry) == ARCHIVE_OK);
+        while ((written) && (!wavFile.atEnd())) {
+            auto data = wavFile.read(xRipEncodeBenchmark_BlockFrames*xRipEncodeBenchmark_BytesPerFrame);
+            written = (archive_write_data(archiveFile, data.constData(), data.size()) == data.size());
+        }
+        archive_entry_free(archiveEntry);
+        if (!written) {
+            qCritical() << "xRipEncodeBenchmark::writeArchive: unable to write: " << wavFileName << ": " << archive_error_string(archiveFile);
+            break;
+        }
+    }
+    archive_write_close(archiveFile);
+    archive_write_free(archiveFile);
+    return written;
+}
+
+bool xRipEncodeBenchmark::writeMovie(const QString& fileName) const {
+    AVFormatContext* formatContext = nullptr;
+    if (avformat_alloc_output_context2(&formatContext, nullptr, "matroska", fileName.toStdString().c_str()) < 0) {
+        qCritical() << "xRipEncodeBenchmark::writeMovie: no matroska muxer";
+        return false;
+    }
+    auto stream = avformat_new_stream(formatContext, nullptr);
+    if (!stream) {
+        avformat_free_context(formatContext);
+        return false;
+    }
+    stream->time_base = AVRational{ 1, xRipEncodeBenchmark_SampleRate };
+    stream->codecpar->codec_type = AVMEDIA_TYPE_AUDIO;
+    stream->codecpar->codec_id = AV_CODEC_ID_PCM_S16LE;
+    stream->codecpar->sample_rate = xRipEncodeBenchmark_SampleRate;
+#if xRipEncodeBenchmark_ChannelLayoutAPI
+    av_channel_layout_default(&stream->codecpar->ch_layout, xRipEncodeBenchmark_Channels);
+#else
+    stream->codecpar->channels = xRipEncodeBenchmark_Channels;
+    stream->codecpar->channel_layout = static_cast<uint64_t>(av_get_default_channel_layout(xRipEncodeBenchmark_Channels));
+#endif
+    stream->codecpar->bits_per_coded_sample = 16;
+    stream->codecpar->block_align = xRipEncodeBenchmark_BytesPerFrame;
+    stream->codecpar->bit_rate = static_cast<int64_t>(xRipEncodeBenchmark_SampleRate)*xRipEncodeBenchmark_BytesPerFrame*8;
+    // One chapter per track. The chapters are freed with the format context.
+    formatContext->chapters = static_cast<AVChapter**>(av_calloc(benchmarkTracks, sizeof(AVChapter*)));
+    for (auto track = 0; (formatContext->chapters) && (track < benchmarkTracks); ++track) {
+        auto chapter = static_cast<AVChapter*>(av_mallocz(sizeof(AVChapter)));
+        if (!chapter) {
+            break;
+        }
+        chapter->id = track+1;
+        chapter->time_base = AVRational{ 1, 1000 };
+        chapter->start = static_cast<int64_t>(track)*benchmarkSeconds*1000;
+        chapter->end = static_cast<int64_t>(track+1)*benchmarkSeconds*1000;
+        av_dict_set(&chapter->metadata, "title", QString("Track %1").arg(track+1).toStdString().c_str(), 0);
+        formatContext->chapters[track] = chapter;
+        formatContext->nb_chapters = track+1;
+    }
+    if ((static_cast<int>(formatContext->nb_chapters) != benchmarkTracks) ||
+        (avio_open(&formatContext->pb, fileName.toStdString().c_str(), AVIO_FLAG_WRITE) < 0)) {
+        qCritical() << "xRipEncodeBenchmark::writeMovie: unable to open: " << fileName;
+        avformat_free_context(formatContext);
+        return false;
+    }
+    auto written = (avformat_write_header(formatContext, nullptr) >= 0);
+    auto packet = av_packet_alloc();
+    auto frames = static_cast<qint64>(benchmarkTracks)*benchmarkSeconds*xRipEncodeBenchmark_SampleRate;
+    for (qint64 frame = 0; (written) && (frame < frames); frame += xRipEncodeBenchmark_BlockFrames) {
+        auto blockFrames = static_cast<int>(std::min<qint64>(xRipEncodeBenchmark_BlockFrames, frames-frame));
+        auto data = samples(frame, blockFrames);
+        if (av_new_packet(packet, data.size()) < 0) {
+            written = false;
+            break;
+        }
+        std::memcpy(packet->data, data.constData(), data.size());
+        packet->pts = packet->dts = frame;
+        packet->duration = blockFrames;
+        packet->stream_index = stream->index;
+        av_packet_rescale_ts(packet, AVRational{ 1, xRipEncodeBenchmark_SampleRate }, stream->time_base);
+        written = (av_interleaved_write_frame(formatContext, packet) >= 0);
+    }
+    av_packet_free(&packet);
+    if ((av_write_trailer(formatContext) < 0) || (!written)) {
+        qCritical() << "xRipEncodeBenchmark::writeMovie: unable to write: " << fileName;
+        written = false;
+    }
+    avio_closep(&formatContext->pb);
+    avformat_free_context(formatContext);
+    return written;
+}
+
+bool xRipEncodeBenchmark::benchmarkArchive(const QString& archiveFileName, const QString& format) {
+    xArchiveFile archiveFile;
+    QObject::connect(&archiveFile, &xArchiveFile::messages, QCoreApplication::instance(), [this](const QString& msg, quint64 jobId) {
+        Q_UNUSED(jobId)
+        message(msg);
+    });
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+    if (!wait(&archiveFile, &xArchiveFile::archivedFiles, [&]() { archiveFile.analyze(archiveFileName); }, true)) {
+        return false;
+    }
+    measure(QString("analyze (%1)").arg(format), stageTimer.elapsed(), 0);
+    stageTimer.restart();
+    auto tags = archiveFile.extractTags(xArchiveFileSchemes::AutoDetect);
+    measure(QString("lookup (%1)").arg(format), stageTimer.elapsed(), 0);
+    if (tags.trackName.count() != benchmarkTracks) {
+        qCritical() << "xRipEncodeBenchmark::benchmarkArchive: tag lookup failed: " << archiveFileName;
+        return false;
+    }
+    QList<std::tuple<int,QString,QString>> tracks;
+    qint64 bytes = 0;
+    for (auto track = 0; track < benchmarkTracks; ++track) {
+        tracks.push_back(std::make_tuple(track+1, QString("%1").arg(track+1, 2, 10, QChar('0')), tags.trackName[track]));
+        bytes += tags.trackSize[track];
+    }
+    auto files = xArchiveFile::createAudioFiles(tags.artist, tags.album, tracks, tags.trackDisc, "", 0, 1);
+    QList<xAudioFile*> extractedFiles;
+    QObject::connect(&archiveFile, &xArchiveFile::audioFiles, [&extractedFiles](const QList<xAudioFile*>& audioFiles) {
+        extractedFiles = audioFiles;
+    });
+    archiveFile.queueExtract(files);
+    stageTimer.restart();
+    if (!wait(&archiveFile, &QThread::finished, [&]() { archiveFile.start(); }, false)) {
+        return false;
+    }
+    measure(QString("extract (%1)").arg(format), stageTimer.elapsed(), bytes);
+    auto extracted = (extractedFiles.count() == benchmarkTracks);
+    // Remove the extracted files from the temp directory.
+    qDeleteAll(extractedFiles);
+    return extracted;
+}
+
+bool xRipEncodeBenchmark::benchmarkMovie() {
+    xMovieFile movieFile;
+    QObject::connect(&movieFile, &xMovieFile::messages, QCoreApplication::instance(), [this](const QString& msg, quint64 jobId) {
+        Q_UNUSED(jobId)
+        message(msg);
+    });
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+    if (!wait(&movieFile, &xMovieFile::trackLengths, [&]() { movieFile.analyze(fixtureDirectory+"/benchmark.mkv"); }, true)) {
+        return false;
+    }
+    measure("analyze (mkv)", stageTimer.elapsed(), 0);
+    if (movieFile.getTracks() != benchmarkTracks) {
+        qCritical() << "xRipEncodeBenchmark::benchmarkMovie: unexpected number of chapters: " << movieFile.getTracks();
+        return false;
+    }
+    QList<xAudioFile*> files;
+    for (auto track = 0; track < benchmarkTracks; ++track) {
+        auto trackNr = QString("%1").arg(track+1, 2, 10, QChar('0'));
+        files.push_back(new xAudioFileWav(QString("%1/movie %2.wav").arg(tempDirectory).arg(trackNr), track+1,
+                                          xRipEncodeBenchmark_Artist, xRipEncodeBenchmark_Album, trackNr,
+                                          QString("Track %1").arg(track+1), "", 0, 2));
+    }
+    QList<xAudioFile*> extractedFiles;
+    QObject::connect(&movieFile, &xMovieFile::audioFiles, [&extractedFiles](const QList<xAudioFile*>& audioFiles) {
+        extractedFiles = audioFiles;
+    });
+    movieFile.queueRip(files, 0, false);
+    stageTimer.restart();
+    if (!wait(&movieFile, &QThread::finished, [&]() { movieFile.start(); }, false)) {
+        return false;
+    }
+    measure("extract (mkv)", stageTimer.elapsed(),
+            static_cast<qint64>(benchmarkTracks)*benchmarkSeconds*xRipEncodeBenchmark_SampleRate*xRipEncodeBenchmark_BytesPerFrame);
+    if (extractedFiles.count() != benchmarkTracks) {
+        qDeleteAll(extractedFiles);
+        return false;
+    }
+    return benchmarkEncoding(extractedFiles);
+}
+
+bool xRipEncodeBenchmark::benchmarkEncoding(const QList<xAudioFile*>& files) {
+    QList<std::pair<xAudioFile*,QString>> encodingFiles;
+    qint64 bytes = 0;
+    for (const auto& file : files) {
+        encodingFiles.push_back(std::make_pair(file, QString("%1/%2.flac").arg(encodingDirectory).arg(file->getTrackNr())));
+        bytes += QFileInfo(file->getFileName()).size();
+    }
+    xAudioFileEncoding encoding(encodingFiles, true);
+    QObject::connect(&encoding, &xAudioFileEncoding::messages, QCoreApplication::instance(), [this](const QString& msg) {
+        message(msg);
+    });
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+    auto encoded = wait(&encoding, &QThread::finished, [&]() { encoding.start(); }, false) && (encoding.getFailed().isEmpty());
+    measure("encode (flac)", stageTimer.elapsed(), bytes);
+    // Remove the inputs and the outputs for the next round.
+    qDeleteAll(files);
+    for (const auto& encodingFile : encodingFiles) {
+        QFile::remove(encodingFile.second);
+    }
+    return encoded;
+}
+
+template<typename Sender, typename Signal>
+bool xRipEncodeBenchmark::wait(Sender* sender, Signal signal, const std::function<void()>& start, bool abortOnError) {
+    QEventLoop loop;
+    QTimer timeout;
+    auto received = false;
+    timeout.setSingleShot(true);
+    QObject::connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+    QObject::connect(sender, signal, &loop, [&loop, &received]() {
+        received = true;
+        loop.quit();
+    });
+    waitLoop = &loop;
+    waitError = false;
+    waitAbortOnError = abortOnError;
+    timeout.start(xRipEncodeBenchmark_Timeout);
+    start();
+    // The signal may already be emitted while starting.
+    if (!received) {
+        loop.exec();
+    }
+    waitLoop = nullptr;
+    if (!received) {
+        qCritical() << "xRipEncodeBenchmark::wait: stage " << ((waitError) ? "failed" : "timed out");
+    }
+    return received;
+}
+
+void xRipEncodeBenchmark::message(const QString& msg) {
+    if ((msg.startsWith("[timing]")) || (msg.startsWith("[error]"))) {
+        QTextStream(stdout) << "  " << msg << Qt::endl;
+    }
+    if ((msg.startsWith("[error]")) && (waitLoop) && (waitAbortOnError)) {
+        waitError = true;
+        waitLoop->quit();
+    }
+}
+
+void xRipEncodeBenchmark::measure(const QString& stage, qint64 ms, qint64 bytes) {
+    if (!stageTimes.contains(stage)) {
+        stages.push_back(stage);
+    }
+    stageTimes[stage].push_back(ms);
+    stageBytes[stage] = bytes;
+    QTextStream(stdout) << stage << ": " << ms << " ms" << Qt::endl;
+}
+
+int main(int argc, char* argv[]) {
+    QCoreApplication benchmarkApp(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmark of the xRipEncode extraction and encoding using synthetic fixtures.");
+    parser.addHelpOption();
+    QCommandLineOption tracksOption("tracks", "Number of tracks of each fixture.", "tracks", "12");
+    QCommandLineOption secondsOption("seconds", "Length of each track in seconds.", "seconds", "30");
+    QCommandLineOption roundsOption("rounds", "Number of rounds.", "rounds", "3");
+    parser.addOptions({ tracksOption, secondsOption, roundsOption });
+    parser.process(benchmarkApp);
+    auto tracks = std::clamp(parser.value(tracksOption).toInt(), 1, 99);
+    auto seconds = std::max(parser.value(secondsOption).toInt(), 1);
+    auto rounds = std::max(parser.value(roundsOption).toInt(), 1);
+    QTemporaryDir benchmarkDirectory;
+    if (!benchmarkDirectory.isValid()) {
+        qCritical() << "xRipEncodeBenchmark: unable to create the working directory";
+        return 1;
+    }
+    // Keep the user settings untouched. Set before the configuration is created.
+    qputenv("XDG_CONFIG_HOME", QString(benchmarkDirectory.path()+"/config").toUtf8());
+    xRipEncodeBenchmark benchmark(benchmarkDirectory.path(), tracks, seconds);
+    if (!benchmark.createFixtures()) {
+        return 1;
+    }
+    for (auto round = 0; round < rounds; ++round) {
+        QTextStream(stdout) << "round " << round+1 << "/" << rounds << Qt::endl;
+        if (!benchmark.run()) {
+            return 1;
+        }
+    }
+    benchmark.report();
+    return 0;
+}
@@ -0,0 +1,124 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "xArchiveFileBatch.h"
+#include "xRipEncodeConfiguration.h"
+
+#include <archive.h>
+#include <archive_entry.h>
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QSignalSpy>
+
+// Maximal time in ms to wait for the batch import.
+const int xArchiveFileBatchTest_Timeout { 30000 };
+
+/**
+ * @class xArchiveFileBatchTest
+ *
+ * @note Import two archive files back to back through the single xArchiveFile
+ * of the batch. The audio files of the first job are deleted before the second
+ * archive is extracted, as done by the encoding.
+ */
+class xArchiveFileBatchTest:public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void twoArchives();
+
+private:
+    /**
+     * Write a tar archive with dummy flac files.
+     *
+     * @param fileName the path of the archive.
+     * @param entries the path names of the archived files.
+     */
+    static void writeArchive(const QString& fileName, const QStringList& entries);
+
+    QTemporaryDir testDirectory;
+};
+
+void xArchiveFileBatchTest::initTestCase() {
+    QVERIFY(testDirectory.isValid());
+    // Keep the user settings untouched. Set before the configuration is created.
+    qputenv("XDG_CONFIG_HOME", QString(testDirectory.path()+"/config").toUtf8());
+    QVERIFY(QDir().mkpath(testDirectory.path()+"/archives"));
+    QVERIFY(QDir().mkpath(testDirectory.path()+"/temp"));
+    xRipEncodeConfiguration::configuration()->setTempDirectory(testDirectory.path()+"/temp");
+    xRipEncodeConfiguration::configuration()->setFileNameFormat("(artist) - (album) - (tracknr) (trackname)");
+}
+
+void xArchiveFileBatchTest::twoArchives() {
+    // Bandcamp scheme. Different number of tracks to detect entries left over from the first archive.
+    writeArchive(testDirectory.path()+"/archives/1.tar", { "Artist - First - 01 One.flac", "Artist - First - 02 Two.flac",
+                                                           "Artist - First - 03 Three.flac" });
+    writeArchive(testDirectory.path()+"/archives/2.tar", { "Artist - Second - 01 Four.flac", "Artist - Second - 02 Five.flac" });
+    xArchiveFileBatch batch;
+    QList<QStringList> albums;
+    QList<quint64> jobIds;
+    QStringList errors;
+    connect(&batch, &xArchiveFileBatch::messages, this, [&errors](const QString& msg, quint64 jobId) {
+        Q_UNUSED(jobId)
+        if (msg.startsWith("[error]")) {
+            errors.push_back(msg);
+        }
+    });
+    connect(&batch, &xArchiveFileBatch::audioFiles, this, [&](const QList<xAudioFile*>& files) {
+        QStringList trackNames;
+        for (const auto& file : files) {
+            trackNames.push_back(file->getAlbum()+"/"+file->getTrackName());
+            QCOMPARE(file->getJobId(), files.first()->getJobId());
+            QVERIFY(QFile::exists(file->getFileName()));
+        }
+        albums.push_back(trackNames);
+        jobIds.push_back(files.first()->getJobId());
+        // The encoding deletes the audio file objects before the next archive is extracted.
+        qDeleteAll(files);
+        batch.dequeued(jobIds.last());
+    });
+    QSignalSpy finishedSpy(&batch, &xArchiveFileBatch::finished);
+    QVERIFY(batch.start(testDirectory.path()+"/archives"));
+    QVERIFY(finishedSpy.wait(xArchiveFileBatchTest_Timeout));
+    QVERIFY2(errors.isEmpty(), qPrintable(errors.join('\n')));
+    QCOMPARE(albums.count(), 2);
+    QCOMPARE(albums[0], QStringList({ "First/One", "First/Two", "First/Three" }));
+    QCOMPARE(albums[1], QStringList({ "Second/Four", "Second/Five" }));
+    QVERIFY(jobIds[0] != jobIds[1]);
+}
+
+void xArchiveFileBatchTest::writeArchive(const QString& fileName, const QStringList& entries) {
+    auto archiveFile = archive_write_new();
+    archive_write_set_format_pax_restricted(archiveFile);
+    QCOMPARE(archive_write_open_filename(archiveFile, fileName.toStdString().c_str()), ARCHIVE_OK);
+    // The content is not decoded. Flac files are extracted without conversion.
+    const QByteArray data("fLaC dummy audio data");
+    for (const auto& entry : entries) {
+        auto archiveEntry = archive_entry_new();
+        archive_entry_set_pathname(archiveEntry, entry.toStdString().c_str());
+        archive_entry_set_size(archiveEntry, data.size());
+        archive_entry_set_filetype(archiveEntry, AE_IFREG);
+        archive_entry_set_perm(archiveEntry, 0644);
+        QCOMPARE(archive_write_header(archiveFile, archiveEntry), ARCHIVE_OK);
+        QCOMPARE(archive_write_data(archiveFile, data.constData(), data.size()), static_cast<la_ssize_t>(data.size()));
+        archive_entry_free(archiveEntry);
+    }
+    archive_write_close(archiveFile);
+    archive_write_free(archiveFile);
+}
+
+QTEST_GUILESS_MAIN(xArchiveFileBatchTest)
+
+#include "xArchiveFileBatchTest.moc"
@@ -40,6 +40,9 @@ xApplication::xApplication(QWidget* parent, Qt::WindowFlags flags):
     connect(movieFileWidget, &xMainMovieFileWidget::audioFiles, encodingWidget, &xMainEncodingWidget::audioFiles);
     connect(audioCDWidget, &xMainAudioCDWidget::audioFiles, encodingWidget, &xMainEncodingWidget::audioFiles);
     connect(archiveFileWidget, &xMainArchiveFileWidget::audioFiles, encodingWidget, &xMainEncodingWidget::audioFiles);
+    // Batch imported archive files are encoded while the next archive file is extracted.
+    connect(archiveFileWidget, &xMainArchiveFileWidget::batchAudioFiles, encodingWidget, &xMainEncodingWidget::batchAudioFiles);
+    connect(encodingWidget, &xMainEncodingWidget::batchDequeued, archiveFileWidget, &xMainArchiveFileWidget::batchDequeued);
     // Set central widget
     setCentralWidget(mainView);
     // Create Menu
@@ -13,72 +13,206 @@
  */
 
 #include "xArchiveFile.h"
+#include "xMovieFileDemux.h"
+#include "xTempSpace.h"
+#include "xLogSink.h"
+#include "xRipEncodeConfiguration.h"
+#include "xFileNameTemplate.h"
 
 #include <archive.h>
 #include <archive_entry.h>
 
-#include <QRegularExpression>
+#include <QFile>
+#include <QFileInfo>
 #include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
 
-// Currently supported lookup schemes.
-const QStringList xArchiveFile::TagLookupSchemes { "Qobuz", "7Digital", "Bandcamp", "HighResAudio", "HDtracks" };
+// Name filters of the supported archive files. Compression filters are detected by libarchive.
+const QStringList xArchiveFile::ArchiveFileNameFilters { "*.tar", "*.zip", "*.7z", "*.rar", "*.tar.zst", "*.tzst",
+                                                         "*.tar.xz", "*.txz", "*.tar.gz", "*.tgz", "*.tar.bz2" };
+// Suffixes of the supported audio files. All files except flac files are converted.
+// The m4a files are only converted if they contain ALAC, lossy codecs are rejected.
+const QStringList xArchiveFile_AudioFileSuffixes { "flac", "wav", "aif", "aiff", "m4a", "dsf", "dff" };
+// Number of archived files reported at once during the analysis.
+const int xArchiveFileAnalyze_BatchSize { 64 };
+// Maximal time in between two reports during the analysis.
+const qint64 xArchiveFileAnalyze_BatchInterval { 200 };
 
-xArchiveFile::xArchiveFile(QObject *parent):
-        QThread(parent) {
-}
-
-int xArchiveFile::getFiles() const {
-    return archiveFileNames.count();
+/**
+ * xArchiveFileAnalyze
+ *
+ * This class scans the archive file in a separate thread and reports
+ * the supported audio files in batches.
+ */
+xArchiveFileAnalyze::xArchiveFileAnalyze(const QString& file, QObject* parent):
+        QThread(parent),
+        archiveFileName(file),
+        archiveFileError(false) {
 }
 
-const QString& xArchiveFile::getFileName() const {
-    return archiveFileName;
+bool xArchiveFileAnalyze::hasError() const {
+    return archiveFileError;
 }
 
-void xArchiveFile::analyze(const QString& file) {
-    // Save file name.
-    archiveFileName = file;
-    // Clear file names and file sizes.
-    archiveFileNames.clear();
-    archiveFileSizes.clear();
-    // Use libarchive to scan archive file.
-    struct archive* archiveFile;
+void xArchiveFileAnalyze::run() {
     struct archive_entry* archiveEntry;
     int result;
-    // Setup libarchive to read archives.
-    archiveFile = archive_read_new();
-    archive_read_support_filter_all(archiveFile);
-    archive_read_support_format_all(archiveFile);
-    result = archive_read_open_filename(archiveFile, archiveFileName.toStdString().c_str(), 16384);
-    if (result != ARCHIVE_OK) {
+    auto archiveFile = xArchiveFile::openArchive(archiveFileName);
+    if (!archiveFile) {
         emit messages(QString("[error] unable to open the archive: %1").arg(archiveFileName));
+        archiveFileError = true;
         return;
     }
+    QVector<QString> batchFileNames;
+    QVector<qint64> batchFileSizes;
+    QStringList batchMessages;
+    QElapsedTimer batchTimer;
+    batchTimer.start();
     while ((result = archive_read_next_header(archiveFile, &archiveEntry)) != ARCHIVE_EOF) {
-        // Clear archived file names if error in archive file.
         if (result != ARCHIVE_OK) {
-            archiveFileNames.clear();
-            archiveFileSizes.clear();
             emit messages(QString("[error] error reading file: %1").arg(archiveFileName));
+            archiveFileError = true;
             break;
         }
         // Do we have a regular file.
         if (archive_entry_filetype(archiveEntry) & AE_IFREG) {
             auto fileName = QString(archive_entry_pathname(archiveEntry));
-            emit messages("[analyze] "+fileName);
-            if (validOutputFile(fileName)) {
-                archiveFileNames.push_back(fileName);
-                archiveFileSizes.push_back(archive_entry_size(archiveEntry));
+            batchMessages.push_back("[analyze] "+fileName);
+            if (xArchiveFile::validOutputFile(fileName)) {
+                batchFileNames.push_back(fileName);
+                batchFileSizes.push_back(archive_entry_size(archiveEntry));
+            }
+        }
+        // Report the current batch.
+        if ((batchFileNames.count() >= xArchiveFileAnalyze_BatchSize) ||
+            ((!batchMessages.isEmpty()) && (batchTimer.elapsed() >= xArchiveFileAnalyze_BatchInterval))) {
+            emit messages(batchMessages.join('\n'));
+            if (!batchFileNames.isEmpty()) {
+                emit archivedFiles(batchFileNames, batchFileSizes);
             }
+            batchFileNames.clear();
+            batchFileSizes.clear();
+            batchMessages.clear();
+            batchTimer.restart();
         }
         archive_read_data_skip(archiveFile);
     }
     archive_read_close(archiveFile);
     archive_read_free(archiveFile);
+    if (!archiveFileError) {
+        if (!batchMessages.isEmpty()) {
+            emit messages(batchMessages.join('\n'));
+        }
+        if (!batchFileNames.isEmpty()) {
+            emit archivedFiles(batchFileNames, batchFileSizes);
+        }
+    }
+}
+
+/**
+ * xArchiveFile
+ *
+ * This class handles the analysis, the tag lookup and the extraction of archive files.
+ */
+xArchiveFile::xArchiveFile(QObject *parent):
+        QThread(parent),
+        archiveFileAnalyzer(nullptr),
+        extractJobId(0) {
+}
+
+xArchiveFile::~xArchiveFile() {
+    if (archiveFileAnalyzer) {
+        archiveFileAnalyzer->wait();
+    }
+    // Abort the wait for temp space on shutdown.
+    requestInterruption();
+    wait();
+}
+
+int xArchiveFile::getFiles() const {
+    return archiveFileNames.count();
+}
+
+const QString& xArchiveFile::getFileName() const {
+    return archiveFileName;
+}
+
+struct archive* xArchiveFile::openArchive(const QString& fileName) {
+    auto archiveFile = archive_read_new();
+    archive_read_support_filter_all(archiveFile);
+    if (fileName.endsWith(".zip", Qt::CaseInsensitive)) {
+        // Use the central directory instead of scanning through the local headers.
+        archive_read_support_format_zip_seekable(archiveFile);
+    } else {
+        archive_read_support_format_all(archiveFile);
+    }
+    if (archive_read_open_filename(archiveFile, fileName.toStdString().c_str(), 16384) != ARCHIVE_OK) {
+        archive_read_free(archiveFile);
+        return nullptr;
+    }
+    return archiveFile;
+}
+
+bool xArchiveFile::isAnalyzing() const {
+    return archiveFileAnalyzer != nullptr;
+}
+
+void xArchiveFile::analyze(const QString& file) {
+    if (archiveFileAnalyzer) {
+        emit messages("[analyze] analysis already in progress", 0);
+        return;
+    }
+    // Measure the time required to scan the archive.
+    archiveFileAnalyzeTimer.start();
+    // Save file name.
+    archiveFileName = file;
+    // Clear file names, file sizes and track numbers.
+    archiveFileNames.clear();
+    archiveFileSizes.clear();
+    archiveFileTrackNrs.clear();
+    archiveFileAnalyzer = new xArchiveFileAnalyze(archiveFileName, this);
+    connect(archiveFileAnalyzer, &xArchiveFileAnalyze::archivedFiles, this, &xArchiveFile::analyzeBatch);
+    connect(archiveFileAnalyzer, &xArchiveFileAnalyze::messages, this, [this](const QString& msg) {
+        emit messages(msg, 0);
+    });
+    connect(archiveFileAnalyzer, &xArchiveFileAnalyze::finished, this, &xArchiveFile::analyzeFinished);
+    archiveFileAnalyzer->start();
+}
+
+void xArchiveFile::analyzeBatch(const QVector<QString>& fileNames, const QVector<qint64>& fileSizes) {
+    archiveFileNames.append(fileNames);
+    archiveFileSizes.append(fileSizes);
+    emit archivedFilesAppend(fileNames, fileSizes);
+}
+
+void xArchiveFile::analyzeFinished() {
+    if (!archiveFileAnalyzer) {
+        return;
+    }
+    // Clear archived file names if error in archive file.
+    if (archiveFileAnalyzer->hasError()) {
+        archiveFileNames.clear();
+        archiveFileSizes.clear();
+    }
+    archiveFileAnalyzer->deleteLater();
+    archiveFileAnalyzer = nullptr;
+    emit messages(QString("[timing] analyze: %1 files in %2 ms").arg(archiveFileNames.count()).
+            arg(archiveFileAnalyzeTimer.elapsed()), 0);
     emit archivedFiles(archiveFileNames, archiveFileSizes);
 }
 
 void xArchiveFile::queueExtract(const QList<xAudioFile*>& files) {
+    // Index of the archived file for each track number. Avoid a linear search for large box sets.
+    QVector<int> archiveFileIndex(archiveFileTrackNrs.count(), -1);
+    for (auto index = 0; index < archiveFileTrackNrs.count(); ++index) {
+        auto trackNr = archiveFileTrackNrs[index]-1;
+        if ((trackNr >= 0) && (trackNr < archiveFileIndex.count())) {
+            archiveFileIndex[trackNr] = index;
+        }
+    }
     for (const auto& file : files) {
         // audio track nr start with index 1.
         auto trackNr = file->getAudioTrackNr() - 1;
@@ -89,7 +223,7 @@ void xArchiveFile::queueExtract(const QList<xAudioFile*>& files) {
         auto archivFileNameIndex = trackNr;
         if (!archiveFileTrackNrs.empty()) {
             // Find the index of the the track number.
-            archivFileNameIndex = archiveFileTrackNrs.indexOf(archivFileNameIndex+1);
+            archivFileNameIndex = archiveFileIndex.value(archivFileNameIndex, -1);
             if ((archivFileNameIndex < 0) || (archivFileNameIndex >= archiveFileNames.count())) {
                 qCritical() << "Illegal track lookup: " << trackNr << "," << archivFileNameIndex;
                 continue;
@@ -100,20 +234,98 @@ void xArchiveFile::queueExtract(const QList<xAudioFile*>& files) {
     }
 }
 
+QList<xAudioFile*> xArchiveFile::createAudioFiles(const QString& artist, const QString& album,
+                                                 const QList<std::tuple<int,QString,QString>>& tracks,
+                                                 const QVector<int>& trackDiscs, const QString& tag, int tagId, quint64 jobId) {
+    auto tempDirectory = xRipEncodeConfiguration::configuration()->getTempDirectory();
+    xFileNameTemplate fileNameTemplate(xRipEncodeConfiguration::configuration()->getFileNameFormat());
+    fileNameTemplate.setValue(xFileNameTemplate::FieldArtist, artist);
+    fileNameTemplate.setValue(xFileNameTemplate::FieldAlbum, album);
+    // The tag should contain any separators such as a space.
+    fileNameTemplate.setValue(xFileNameTemplate::FieldTag, tag);
+    fileNameTemplate.setValue(xFileNameTemplate::FieldCodec, "flac");
+    QList<xAudioFile*> files;
+    QString trackFileName;
+    for (const auto& track : tracks) {
+        // Audio track numbers start with index 1.
+        auto trackIndex = std::get<0>(track)-1;
+        auto trackDisc = ((trackIndex >= 0) && (trackIndex < trackDiscs.count())) ?
+                QString::number(trackDiscs[trackIndex]) : QString();
+        fileNameTemplate.setValue(xFileNameTemplate::FieldTrackNr, std::get<1>(track));
+        fileNameTemplate.setValue(xFileNameTemplate::FieldTrackName, std::get<2>(track));
+        fileNameTemplate.setValue(xFileNameTemplate::FieldDisc, trackDisc);
+        fileNameTemplate.render(trackFileName);
+        if (!trackFileName.endsWith(".flac")) {
+            trackFileName.append(".flac");
+        }
+        auto file = new xAudioFileFlac(tempDirectory+"/"+trackFileName, std::get<0>(track), artist, album,
+                                       std::get<1>(track), std::get<2>(track), tag, tagId, jobId);
+        file->setCodec("flac");
+        if (!trackDisc.isEmpty()) {
+            file->setDisc(trackDisc);
+        }
+        files.push_back(file);
+    }
+    return files;
+}
+
 void xArchiveFile::run() {
     QList<xAudioFile*> files;
+    QList<std::pair<xAudioFile*,QString>> convertFiles;
+    // Measure the extract throughput.
+    QElapsedTimer extractTimer;
+    qint64 extractBytes = 0;
+    extractTimer.start();
     // Use libarchive to scan archive file.
     struct archive* archiveFile;
     struct archive* outputFile;
     struct archive_entry* archiveEntry;
     int result;
-
-    archiveFile = archive_read_new();
-    archive_read_support_filter_all(archiveFile);
-    archive_read_support_format_all(archiveFile);
-    result = archive_read_open_filename(archiveFile, archiveFileName.toStdString().c_str(), 16384);
-    if (result != ARCHIVE_OK) {
+    // All queued audio files belong to the same extract job.
+    extractJobId = (queue.isEmpty()) ? 0 : queue.first().audioFile->getJobId();
+    // Validate the archived files before anything is extracted.
+    if (xRipEncodeConfiguration::configuration()->getArchiveFileIntegrityScan()) {
+        auto failures = integrityScan();
+        if (!failures.isEmpty()) {
+            for (const auto& failure : failures) {
+                emit messages(QString("[error] integrity check failed: %1").arg(failure), extractJobId);
+            }
+            emit messages(QString("[error] %1 corrupt archived files, nothing extracted: %2").arg(failures.count()).arg(archiveFileName), extractJobId);
+            clearQueue({});
+            return;
+        }
+    }
+    // Reserve the temp space for the extracted files. Files other than flac need space for the
+    // extracted and the converted file.
+    QList<std::pair<QString,qint64>> extractFileSizes;
+    qint64 extractFileSizeTotal = 0;
+    for (const auto& queueEntry : queue) {
+        auto index = archiveFileNames.indexOf(queueEntry.archiveFileName);
+        auto size = (index >= 0) ? archiveFileSizes[index] : 0;
+        auto suffix = QFileInfo(queueEntry.archiveFileName).suffix().toLower();
+        extractFileSizes.push_back({ queueEntry.audioFile->getFileName(), size });
+        if (suffix != "flac") {
+            extractFileSizes.push_back({ queueEntry.audioFile->getFileName()+"."+suffix, size });
+        }
+    }
+    for (const auto& file : extractFileSizes) {
+        extractFileSizeTotal += file.second;
+    }
+    if (!xTempSpace::tempSpace()->available(extractFileSizeTotal)) {
+        emit messages(QString("[temp] waiting for temp space: %1 MB reserved").arg(xTempSpace::tempSpace()->reserved()/(1024*1024)), extractJobId);
+    }
+    if (!xTempSpace::tempSpace()->reserve(extractFileSizes)) {
+        emit messages("[abort] waiting for temp space canceled", extractJobId);
+        clearQueue({});
+        return;
+    }
+    archiveFile = openArchive(archiveFileName);
+    if (!archiveFile) {
         qCritical() << "xArchiveFile::extract: unable to open the archive: " << archiveFileName;
+        for (const auto& file : extractFileSizes) {
+            xTempSpace::tempSpace()->release(file.first);
+        }
+        clearQueue({});
         return;
     }
     outputFile = archive_write_disk_new();
@@ -129,195 +341,82 @@ void xArchiveFile::run() {
             qWarning() << "xArchiveFile::extract: skipping over: " << archive_entry_pathname(archiveEntry);
             continue;
         }
-        emit messages("[extract] "+queueEntry->getFileName());
-        archive_entry_set_pathname(archiveEntry, queueEntry->getFileName().toStdString().c_str());
+        emit messages("[extract] "+queueEntry->getFileName(), extractJobId);
+        // Audio files other than flac are extracted next to the output file and converted afterwards.
+        auto suffix = QFileInfo(archive_entry_pathname(archiveEntry)).suffix().toLower();
+        auto extractFileName = queueEntry->getFileName();
+        if (suffix != "flac") {
+            extractFileName.append("."+suffix);
+        }
+        archive_entry_set_pathname(archiveEntry, extractFileName.toStdString().c_str());
         if (archive_write_header(outputFile, archiveEntry) != ARCHIVE_OK) {
-            emit messages(QString("[error] unable to write output file header: %1").arg(archive_error_string(outputFile)));
+            emit messages(QString("[error] unable to write output file header: %1").arg(archive_error_string(outputFile)), extractJobId);
         } else {
             result = extractOutputFile(archiveFile, outputFile);
             if (result != ARCHIVE_OK) {
-                emit messages(QString("[error] unable to extract output file: %1").arg(archive_error_string(archiveFile)));
+                emit messages(QString("[error] unable to extract output file: %1").arg(archive_error_string(archiveFile)), extractJobId);
                 break;
             }
-            emit extractProgress(queueEntry->getAudioTrackNr(), 100);
-            files.push_back(queueEntry);
+            extractBytes += archive_entry_size(archiveEntry);
+            if (extractFileName != queueEntry->getFileName()) {
+                emit extractProgress(queueEntry->getAudioTrackNr(), 50);
+                convertFiles.push_back(std::make_pair(queueEntry, extractFileName));
+            } else {
+                emit extractProgress(queueEntry->getAudioTrackNr(), 100);
+                files.push_back(queueEntry);
+            }
         }
     }
     archive_read_close(archiveFile);
     archive_read_free(archiveFile);
     archive_write_close(outputFile);
     archive_write_free(outputFile);
-    // Emit extracted audio files. Transfer to encoding view.
-    emit audioFiles(files);
-}
-
-xArchiveFileTags xArchiveFile::extractTags(const QString& scheme) {
-    if (scheme.compare(TagLookupSchemes[0], Qt::CaseInsensitive) == 0) {
-        return extractTagsFromQobuz();
-    }
-    if (scheme.compare(TagLookupSchemes[1], Qt::CaseInsensitive) == 0) {
-        return extractTagsFrom7Digital();
-    }
-    if (scheme.compare(TagLookupSchemes[2], Qt::CaseInsensitive) == 0) {
-        return extractTagsFromBandcamp();
-    }
-    // No valid scheme found. Return an empty structure.
-    return xArchiveFileTags{ "", "", {}, {}, 0 };
-}
-
-xArchiveFileTags xArchiveFile::extractTagsFromQobuz() {
-    // Parse the file names in order to determine artist, album, track nr and track name.
-    // Keep in mind that the names within the archive are not necessarily sorted.
-    QRegularExpression qobuzRegExp(R"((?<artist>.*?)-(?<album>.*)/(?<disc>\d\d)-(?<nr>\d+)-(?<name>.*))");
-    QRegularExpressionMatch qobuzMatch;
-    xArchiveFileTags qobuzTags;
-    // Determine the number of (relevant) files in the archive.
-    auto files = archiveFileNames.count();
-    // Unordered vector of track names based on their position in the archive file.
-    QVector<QString> trackName(files);
-    // Qobuz uses [disc number]-[track nr] which we need to convert to an absolute track number.
-    // Therefore we need to know the max number of tracks per disc.
-    QVector<int> discMax(files+1, 0);
-    // Index translation to get from archived file name to desired output file name.
-    archiveFileTrackNrs.resize(files);
-    for (auto index = 0; index < files; ++index) {
-        qobuzMatch = qobuzRegExp.match(archiveFileNames[index].toLower());
-        if (qobuzMatch.hasMatch()) {
-            auto disc = qobuzMatch.captured("disc").toInt();
-            auto nr = qobuzMatch.captured("nr").toInt();
-            if (discMax[disc] < nr) {
-                discMax[disc] = nr;
-            }
-            archiveFileTrackNrs[index] = ((disc-1) * 1000) + nr;
-            qobuzTags.artist = qobuzMatch.captured("artist");
-            qobuzTags.artist.replace("_", " ");
-            qobuzTags.album = qobuzMatch.captured("album");
-            qobuzTags.album.replace("_", " ");
-            trackName[index] = qobuzMatch.captured("name");
-            trackName[index].replace("_", " ");
-            if (trackName[index].startsWith(qobuzTags.artist)) {
-                // Remove artist in track name plus the "-".
-                trackName[index].remove(0, qobuzTags.artist.size()+1);
-            }
-            if (trackName[index].contains("-smr.flac") || trackName[index].contains("-smrp.flac")) {
-                // We have an HD album if track name contains "-smr" or "-smrp".
-                qobuzTags.bitsPerSample = 24;
-                trackName[index].replace("-smrp.flac", ".flac");
-                trackName[index].replace("-smr.flac", ".flac");
-            } else if (trackName[index].contains("-lls.flac")) {
-                qobuzTags.bitsPerSample = 16;
-                trackName[index].replace("-lls.flac", ".flac");
-            } else {
-                qCritical() << "extractTagsFromQobuz: no valid quality tag: " << trackName[index];
-                // Return an empty structure.
-                return xArchiveFileTags{ "", "", {}, {}, 0 };
-            }
-        }
+    emit messages(QString("[timing] extract: %1 files, %2 bytes in %3 ms (%4 MB/s)").arg(files.count()+convertFiles.count()).
+            arg(extractBytes).arg(extractTimer.elapsed()).arg(xLogSink::throughput(extractBytes, extractTimer.elapsed()), 0, 'f', 2), extractJobId);
+    // The audio files that failed to convert are deleted by the conversion.
+    QList<xAudioFile*> processedFiles(files);
+    for (const auto& convertFile : convertFiles) {
+        processedFiles.push_back(convertFile.first);
     }
-    // Sum up the numbers per disc.
-    for (auto index = 1; index < files+1; ++index) {
-        discMax[index] += discMax[index-1];
+    if (!convertFiles.isEmpty()) {
+        files.append(convertAudioFiles(convertFiles));
     }
-    // Compute final track numbers for index translation.
-    for (auto index = 0; index < files; ++index) {
-        archiveFileTrackNrs[index] = discMax[archiveFileTrackNrs[index]/1000] + (archiveFileTrackNrs[index]%1000);
+    // Release the space of the archived files that were not extracted or converted.
+    QSet<QString> extractedFileNames;
+    for (const auto& file : files) {
+        extractedFileNames.insert(file->getFileName());
     }
-    // Create return output. Order archived files according to their track number.
-    qobuzTags.trackName.resize(files);
-    qobuzTags.trackSize.resize(files);
-    for (auto index = 0; index < files; ++index) {
-        auto trackNr = archiveFileTrackNrs[index]-1;
-        if ((trackNr >= 0) && (trackNr < files)) {
-            qobuzTags.trackName[archiveFileTrackNrs[index]-1] = trackName[index].remove(".flac");
-            qobuzTags.trackSize[archiveFileTrackNrs[index]-1] = archiveFileSizes[index];
-        } else {
-            qCritical() << "extractTagsFromQobuz: invalid track number: " << trackNr;
-            // Return an empty structure.
-            return xArchiveFileTags{ "", "", {}, {}, 0 };
+    for (const auto& file : extractFileSizes) {
+        if (!extractedFileNames.contains(file.first)) {
+            xTempSpace::tempSpace()->release(file.first);
         }
     }
-    return qobuzTags;
+    // The queue is reused by the next extraction, e.g. in batch mode.
+    clearQueue(processedFiles);
+    // Emit extracted audio files. Transfer to encoding view.
+    emit audioFiles(files);
 }
 
-xArchiveFileTags xArchiveFile::extractTagsFrom7Digital() {
-    // Parse the file names in order to determine artist, album, track nr and track name.
-    // Keep in mind that the names within the archive are not necessarily sorted.
-    QRegularExpression digitalRegExp(R"((?<artist>.*)/(?<album>.*)/(.*) - (?<nr>\d\d). (?<name>.*))");
-    QRegularExpressionMatch digitalMatch;
-    xArchiveFileTags digitalTags;
-    // Determine the number of (relevant) files in the archive.
-    auto files = archiveFileNames.count();
-    // Unordered vector of track names based on their position in the archive file.
-    QVector<QString> trackName(files);
-    // Index translation to get from archived file name to desired output file name.
-    archiveFileTrackNrs.resize(files);
-    for (auto index = 0; index < files; ++index) {
-        digitalMatch = digitalRegExp.match(archiveFileNames[index].toLower());
-        if (digitalMatch.hasMatch()) {
-            archiveFileTrackNrs[index] = digitalMatch.captured("nr").toInt();
-            digitalTags.artist = digitalMatch.captured("artist");
-            digitalTags.album = digitalMatch.captured("album");
-            trackName[index] = digitalMatch.captured("name");
-            digitalTags.bitsPerSample = 16;
-        }
-    }
-    // Create return output. Order archived files according to their track number.
-    digitalTags.trackName.resize(files);
-    digitalTags.trackSize.resize(files);
-    for (auto index = 0; index < files; ++index) {
-        auto trackNr = archiveFileTrackNrs[index]-1;
-        if ((trackNr >= 0) && (trackNr < files)) {
-            digitalTags.trackName[archiveFileTrackNrs[index]-1] = trackName[index].remove(".flac");
-            digitalTags.trackSize[archiveFileTrackNrs[index]-1] = archiveFileSizes[index];
-        } else {
-            qCritical() << "extractTagsFromQobuz: invalid track number: " << trackNr;
-            // Return an empty structure.
-            return xArchiveFileTags{ "", "", {}, {}, 0 };
+void xArchiveFile::clearQueue(const QList<xAudioFile*>& files) {
+    for (auto& queueEntry : queue) {
+        if (!files.contains(queueEntry.audioFile)) {
+            delete queueEntry.audioFile;
         }
     }
-    return digitalTags;
+    queue.clear();
 }
 
-xArchiveFileTags xArchiveFile::extractTagsFromBandcamp() {
-    // Parse the file names in order to determine artist, album, track nr and track name.
-    // Keep in mind that the names within the archive are not necessarily sorted.
-    QRegularExpression bandcampRegExp(R"((?<artist>.*?) - (?<album>.*) - (?<nr>\d\d) (?<name>.*))");
-    QRegularExpressionMatch bandcampMatch;
-    xArchiveFileTags bandcampTags;
-    // Determine the number of (relevant) files in the archive.
-    auto files = archiveFileNames.count();
-    // Unordered vector of track names based on their position in the archive file.
-    QVector<QString> trackName(files);
-    // Index translation to get from archived file name to desired output file name.
-    archiveFileTrackNrs.resize(files);
-    for (auto index = 0; index < files; ++index) {
-        bandcampMatch = bandcampRegExp.match(archiveFileNames[index].toLower());
-        if (bandcampMatch.hasMatch()) {
-            archiveFileTrackNrs[index] = bandcampMatch.captured("nr").toInt();
-            bandcampTags.artist = bandcampMatch.captured("artist");
-            bandcampTags.album = bandcampMatch.captured("album");
-            trackName[index] = bandcampMatch.captured("name");
-            bandcampTags.bitsPerSample = 16;
-        }
-    }
-    // Create return output. Order archived files according to their track number.
-    bandcampTags.trackName.resize(files);
-    bandcampTags.trackSize.resize(files);
-    for (auto index = 0; index < files; ++index) {
-        auto trackNr = archiveFileTrackNrs[index]-1;
-        if ((trackNr >= 0) && (trackNr < files)) {
-            bandcampTags.trackName[archiveFileTrackNrs[index]-1] = trackName[index].remove(".flac");
-            bandcampTags.trackSize[archiveFileTrackNrs[index]-1] = archiveFileSizes[index];
-        } else {
-            qCritical() << "extractTagsFromQobuz: invalid track number: " << trackNr;
-            // Return an empty structure.
-            return xArchiveFileTags{ "", "", {}, {}, 0 };
-        }
-    }
-    return bandcampTags;
+xArchiveFileTags xArchiveFile::extractTags(const QString& scheme) {
+    QElapsedTimer extractTagsTimer;
+    extractTagsTimer.start();
+    QString detected;
+    auto tags = xArchiveFileSchemes::schemes()->extractTags(scheme, archiveFileNames, archiveFileSizes, archiveFileTrackNrs, detected);
+    emit messages(QString("[timing] lookup (%1): %2 files in %3 ms").arg((detected.isEmpty()) ? scheme : detected).
+            arg(archiveFileNames.count()).arg(extractTagsTimer.elapsed()), 0);
+    // Empty structure if no valid scheme found.
+    return tags;
 }
 
-
 xAudioFile* xArchiveFile::findQueueEntry(struct archive_entry *entry) {
     // Search queue for output file name.
     auto pathName = archive_entry_pathname(entry);
@@ -347,10 +446,126 @@ bool xArchiveFile::extractOutputFile(struct archive* archiveFile, struct archive
     return (archive_write_finish_entry(outputFile) == ARCHIVE_EOF);
 }
 
+QStringList xArchiveFile::integrityScan() {
+    QElapsedTimer scanTimer;
+    scanTimer.start();
+    QSet<QString> fileNames;
+    for (const auto& queueEntry : queue) {
+        fileNames.insert(queueEntry.archiveFileName);
+    }
+    // Only zip archives allow the workers to seek to their entries. Other
+    // archives are streams that each worker would have to decompress.
+    auto workers = 1;
+    if (archiveFileName.endsWith(".zip", Qt::CaseInsensitive)) {
+        workers = std::clamp(QThread::idealThreadCount(), 1, std::max(fileNames.count(), 1));
+    }
+    QStringList failures;
+    QMutex failuresLock;
+    std::atomic<qint64> scanBytes { 0 };
+    std::vector<std::unique_ptr<QThread>> scanThreads;
+    for (auto worker = 0; worker < workers; ++worker) {
+        scanThreads.emplace_back(QThread::create([=, &fileNames, &failures, &failuresLock, &scanBytes]() {
+            scanBytes += integrityScanWorker(worker, workers, fileNames, failures, failuresLock);
+        }));
+        scanThreads.back()->start();
+    }
+    for (auto& scanThread : scanThreads) {
+        scanThread->wait();
+    }
+    emit messages(QString("[timing] integrity scan: %1 files, %2 bytes, %3 workers in %4 ms (%5 MB/s)").arg(fileNames.count()).
+            arg(scanBytes.load()).arg(workers).arg(scanTimer.elapsed()).arg(xLogSink::throughput(scanBytes.load(), scanTimer.elapsed()), 0, 'f', 2), extractJobId);
+    failures.sort();
+    return failures;
+}
+
+qint64 xArchiveFile::integrityScanWorker(int worker, int workers, const QSet<QString>& fileNames,
+                                         QStringList& failures, QMutex& failuresLock) {
+    auto addFailure = [&failures, &failuresLock](const QString& failure) {
+        QMutexLocker locker(&failuresLock);
+        failures.push_back(failure);
+    };
+    auto archiveFile = openArchive(archiveFileName);
+    if (!archiveFile) {
+        addFailure(QString("%1: unable to open the archive").arg(archiveFileName));
+        return 0;
+    }
+    struct archive_entry* archiveEntry;
+    const void* dataBuffer;
+    size_t dataSize;
+    int64_t dataOffset;
+    qint64 bytes = 0;
+    int result;
+    auto entry = 0;
+    while ((result = archive_read_next_header(archiveFile, &archiveEntry)) != ARCHIVE_EOF) {
+        if (result != ARCHIVE_OK) {
+            // Report broken headers only once.
+            if (worker == 0) {
+                addFailure(QString("%1: unable to read archive header: %2").arg(archiveFileName).arg(archive_error_string(archiveFile)));
+            }
+            break;
+        }
+        auto pathName = QString(archive_entry_pathname(archiveEntry));
+        // Each worker handles every n-th queued entry.
+        if ((!fileNames.contains(pathName)) || ((entry++ % workers) != worker)) {
+            continue;
+        }
+        // The CRC is checked by libarchive after the last data block.
+        while ((result = archive_read_data_block(archiveFile, &dataBuffer, &dataSize, &dataOffset)) == ARCHIVE_OK) {
+            bytes += static_cast<qint64>(dataSize);
+        }
+        if (result != ARCHIVE_EOF) {
+            addFailure(QString("%1: %2").arg(pathName).arg(archive_error_string(archiveFile)));
+            if (result == ARCHIVE_FATAL) {
+                break;
+            }
+        }
+    }
+    archive_read_close(archiveFile);
+    archive_read_free(archiveFile);
+    return bytes;
+}
+
 bool xArchiveFile::validOutputFile(const QString& fileName) {
-    auto lowerFileName = fileName.toLower();
-    if (lowerFileName.endsWith(".flac") || lowerFileName.endsWith(".wav")) {
-        return true;
+    return xArchiveFile_AudioFileSuffixes.contains(QFileInfo(fileName).suffix().toLower());
+}
+
+QList<xAudioFile*> xArchiveFile::convertAudioFiles(const QList<std::pair<xAudioFile*,QString>>& files) {
+    QElapsedTimer convertTimer;
+    convertTimer.start();
+    auto workers = std::clamp(QThread::idealThreadCount(), 1, std::max(files.count(), 1));
+    QVector<bool> converted(files.count(), false);
+    std::atomic<int> nextFile { 0 };
+    std::vector<std::unique_ptr<QThread>> convertThreads;
+    for (auto worker = 0; worker < workers; ++worker) {
+        convertThreads.emplace_back(QThread::create([this, &files, &converted, &nextFile]() {
+            int index;
+            while ((index = nextFile++) < files.count()) {
+                // Decode in-process and pipe the samples into the flac encoder.
+                xMovieFileDemux convert(files[index].second);
+                connect(&convert, &xMovieFileDemux::messages, this, [this](const QString& msg) {
+                    emit messages(msg, extractJobId);
+                }, Qt::DirectConnection);
+                converted[index] = convert.convert(files[index].first->getFileName());
+                QFile::remove(files[index].second);
+                xTempSpace::tempSpace()->release(files[index].second);
+            }
+        }));
+        convertThreads.back()->start();
+    }
+    for (auto& convertThread : convertThreads) {
+        convertThread->wait();
+    }
+    QList<xAudioFile*> convertedFiles;
+    for (auto index = 0; index < files.count(); ++index) {
+        if (converted[index]) {
+            emit extractProgress(files[index].first->getAudioTrackNr(), 100);
+            convertedFiles.push_back(files[index].first);
+        } else {
+            emit messages(QString("[error] unable to convert: %1").arg(files[index].second), extractJobId);
+            delete files[index].first;
+        }
     }
-    return false;
+    emit messages(QString("[timing] convert: %1 files, %2 workers in %3 ms").arg(files.count()).arg(workers).
+            arg(convertTimer.elapsed()), extractJobId);
+    return convertedFiles;
 }
\ No newline at end of file
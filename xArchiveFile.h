@@ -16,26 +16,76 @@
 #define __XRIPENCODE_XARCHIVEFILE_H__
 
 #include "xAudioFile.h"
+#include "xArchiveFileScheme.h"
 #include <QThread>
 #include <QVector>
+#include <QSet>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <tuple>
 
-struct xArchiveFileTags {
-    QString artist;
-    QString album;
-    QVector<QString> trackName;
-    QVector<qint64> trackSize;
-    int bitsPerSample;
+class xArchiveFileAnalyze:public QThread {
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor
+     *
+     * @param file path to the archive file as string.
+     * @param parent pointer to the parent object.
+     */
+    explicit xArchiveFileAnalyze(const QString& file, QObject* parent=nullptr);
+    /**
+     * Destructor (default)
+     */
+    ~xArchiveFileAnalyze() override = default;
+    /**
+     * Scan the archive file.
+     *
+     * The scan is run in a separate thread. Supported audio files are reported
+     * in batches using the signal archivedFiles. For zip archives the central
+     * directory is read instead of walking through the data of each entry.
+     */
+    void run() override;
+    /**
+     * Check if the scan ended with an error.
+     *
+     * @return true if an error occurred, false otherwise.
+     */
+    [[nodiscard]] bool hasError() const;
+
+signals:
+    /**
+     * Signal emitted for each batch of archived files found.
+     *
+     * @param fileNames a vector of file names.
+     * @param fileSizes a vector of file sizes in bytes.
+     */
+    void archivedFiles(const QVector<QString>& fileNames, const QVector<qint64>& fileSizes);
+    /**
+     * Signal the output of the scan.
+     *
+     * @param msg the current output as string.
+     */
+    void messages(const QString& msg);
+
+private:
+    QString archiveFileName;
+    bool archiveFileError;
 };
 
 class xArchiveFile:public QThread {
     Q_OBJECT
 
 public:
-    // Currently supported lookup schemes.
-    static const QStringList TagLookupSchemes;
+    // Name filters of the supported archive files.
+    static const QStringList ArchiveFileNameFilters;
 
     explicit xArchiveFile(QObject* parent=nullptr);
-    ~xArchiveFile() override = default;
+    /**
+     * Destructor. Wait for a running analysis.
+     */
+    ~xArchiveFile() override;
     /**
      * Determine the number of relevant files in the archive file.
      *
@@ -51,13 +101,23 @@ public:
     /**
      * Analyze the given archive.
      *
+     * The analysis is performed in a separate thread. The archived files are
+     * reported in batches with archivedFilesAppend while scanning and with
+     * archivedFiles after the scan is finished.
+     *
      * @param file path to the archive file as string.
      */
     void analyze(const QString& file);
+    /**
+     * Check if an analysis is running. A new analysis is rejected until it finished.
+     *
+     * @return true if the analysis is running, false otherwise.
+     */
+    [[nodiscard]] bool isAnalyzing() const;
     /**
      * Extract tags (album, artist, track name, quality) out of archived file names.
      *
-     * @param scheme the scheme used to extract tags as string.
+     * @param scheme the scheme used to extract tags as string, auto detect if xArchiveFileSchemes::AutoDetect.
      * @return tuple of artist, album and vector of track names.
      */
     xArchiveFileTags extractTags(const QString& scheme);
@@ -68,7 +128,25 @@ public:
      */
     void queueExtract(const QList<xAudioFile*>& files);
     /**
-     * Extract all tracks queued.
+     * Create the audio file objects for the archived files to extract.
+     *
+     * The files are named according to the configured file name format and
+     * placed in the temp directory.
+     *
+     * @param artist the artist name as string.
+     * @param album the album name as string.
+     * @param tracks list of tuples of audio track index (starting with 1), track number and track name.
+     * @param trackDiscs the disc of each audio track index, empty if not a box set.
+     * @param tag the additional tag as string.
+     * @param tagId the corresponding tag ID.
+     * @param jobId the job ID the audio files belong to.
+     * @return the list of audio file objects.
+     */
+    static QList<xAudioFile*> createAudioFiles(const QString& artist, const QString& album,
+                                               const QList<std::tuple<int,QString,QString>>& tracks,
+                                               const QVector<int>& trackDiscs, const QString& tag, int tagId, quint64 jobId);
+    /**
+     * Extract all tracks queued. The queue is cleared afterwards.
      */
     void run() override;
 
@@ -86,6 +164,13 @@ signals:
      * @param fileSizes a vector of file sizes in bytes.
      */
     void archivedFiles(const QVector<QString>& fileNames, const QVector<qint64>& fileSizes);
+    /**
+     * Signal emitted for each batch of archived files found during the analysis.
+     *
+     * @param fileNames a vector of file names.
+     * @param fileSizes a vector of file sizes in bytes.
+     */
+    void archivedFilesAppend(const QVector<QString>& fileNames, const QVector<qint64>& fileSizes);
     /**
      * Signal the extract progress for the archived file.
      *
@@ -94,31 +179,36 @@ signals:
      */
     void extractProgress(int track, int progress);
     /**
-     * Signal the output of the rip process.
+     * Signal the output of the analysis and the extract process.
      *
      * @param msg the current output as string.
+     * @param jobId the job ID of the extraction, 0 if none.
      */
-    void messages(const QString& msg);
+    void messages(const QString& msg, quint64 jobId);
 
-private:
+private slots:
     /**
-     * Extract album, artist and track name out of archived file names for Qobuz archives.
+     * Add a batch of archived files found by the analysis thread.
      *
-     * @return tuple of artist, album and vector of track names.
+     * @param fileNames a vector of file names.
+     * @param fileSizes a vector of file sizes in bytes.
      */
-    xArchiveFileTags extractTagsFromQobuz();
+    void analyzeBatch(const QVector<QString>& fileNames, const QVector<qint64>& fileSizes);
     /**
-     * Extract album, artist and track name out of archived file names for 7Digital archives.
-     *
-     * @return tuple of artist, album and vector of track names.
+     * Called if the analysis thread is finished.
      */
-    xArchiveFileTags extractTagsFrom7Digital();
+    void analyzeFinished();
+
+private:
+    // Grant access to the shared helper functions.
+    friend xArchiveFileAnalyze;
     /**
-     * Extract album, artist and track name out of archived file names for Bandcamp archives.
+     * Open the archive file for reading.
      *
-     * @return tuple of artist, album and vector of track names.
+     * @param fileName path to the archive file as string.
+     * @return pointer to the archive structure, nullptr on error.
      */
-    xArchiveFileTags extractTagsFromBandcamp();
+    static struct archive* openArchive(const QString& fileName);
     /**
      * Find the queue entry for the corresponding archive entry.
      *
@@ -130,9 +220,24 @@ private:
      * Check if the file is a supported audio file.
      *
      * @param fileName the file name of the archive file.
-     * @return true if the file name ends with .flac or .wav, false otherwise.
+     * @return true if the file is a flac, wav, aiff, alac or dsd file, false otherwise.
      */
     static bool validOutputFile(const QString& fileName);
+    /**
+     * Convert the extracted audio files into flac files. The files are
+     * distributed among parallel workers.
+     *
+     * @param files the audio files extracted with the suffix of the archived file appended.
+     * @return the audio files converted successfully. The other audio file objects are deleted.
+     */
+    QList<xAudioFile*> convertAudioFiles(const QList<std::pair<xAudioFile*,QString>>& files);
+    /**
+     * Clear the queue after an extraction. The audio file objects of queue
+     * entries that were not processed are deleted.
+     *
+     * @param files the audio file objects passed on or already deleted.
+     */
+    void clearQueue(const QList<xAudioFile*>& files);
     /**
      * Actually extract the given archive file.
      *
@@ -141,6 +246,25 @@ private:
      * @return true if the file was successfully extracted, false otherwise.
      */
     static bool extractOutputFile(struct archive* archiveFile, struct archive* outputFile);
+    /**
+     * Validate the CRC of all queued archived files. The archived files are
+     * distributed among parallel workers, each with its own archive handle.
+     *
+     * @return the list of failing archived files including the error, empty if all are valid.
+     */
+    QStringList integrityScan();
+    /**
+     * Read the data of the archived files assigned to one worker of the integrity scan.
+     *
+     * @param worker the index of the worker.
+     * @param workers the number of workers.
+     * @param fileNames the archived files to validate.
+     * @param failures the list of failing archived files. Access is protected by the lock.
+     * @param failuresLock the lock used for the list of failing archived files.
+     * @return the number of bytes read.
+     */
+    qint64 integrityScanWorker(int worker, int workers, const QSet<QString>& fileNames,
+                               QStringList& failures, QMutex& failuresLock);
 
     typedef struct {
         xAudioFile* audioFile;
@@ -148,10 +272,14 @@ private:
     } xArchiveFileQueue;
 
     QString archiveFileName;
+    xArchiveFileAnalyze* archiveFileAnalyzer;
+    QElapsedTimer archiveFileAnalyzeTimer;
     QVector<QString> archiveFileNames;
     QVector<int> archiveFileTrackNrs;
     QVector<qint64> archiveFileSizes;
     QList<xArchiveFileQueue> queue;
+    // Job of the queued audio files. Attached to the messages of the extraction.
+    quint64 extractJobId;
 };
 
 
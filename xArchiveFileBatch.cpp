@@ -0,0 +1,147 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "xArchiveFileBatch.h"
+#include "xRipEncodeConfiguration.h"
+
+#include <QDir>
+#include <QRandomGenerator>
+#include <QDebug>
+
+// Number of extracted jobs that may wait for the encoding.
+const int xArchiveFileBatch_MaxPending { 1 };
+
+xArchiveFileBatch::xArchiveFileBatch(QObject* parent):
+        QObject(parent),
+        batchArchiveFileNames(),
+        batchArchiveFileIndex(0),
+        batchPending(),
+        batchRunning(false),
+        batchActive(false),
+        batchCanceled(false) {
+    batchArchiveFile = new xArchiveFile(this);
+    connect(batchArchiveFile, &xArchiveFile::archivedFiles, this, &xArchiveFileBatch::analyzed);
+    connect(batchArchiveFile, &xArchiveFile::audioFiles, this, &xArchiveFileBatch::extracted);
+    connect(batchArchiveFile, &xArchiveFile::finished, this, &xArchiveFileBatch::extractFinished);
+    connect(batchArchiveFile, &xArchiveFile::messages, this, &xArchiveFileBatch::messages);
+}
+
+bool xArchiveFileBatch::start(const QString& directory) {
+    if (batchRunning) {
+        return false;
+    }
+    QDir batchDirectory(directory);
+    batchArchiveFileNames.clear();
+    for (const auto& fileName : batchDirectory.entryList(xArchiveFile::ArchiveFileNameFilters, QDir::Files|QDir::Readable, QDir::Name)) {
+        batchArchiveFileNames.push_back(batchDirectory.absoluteFilePath(fileName));
+    }
+    if (batchArchiveFileNames.isEmpty()) {
+        emit messages(QString("[error] no archive files found: %1").arg(directory), 0);
+        return false;
+    }
+    emit messages(QString("[batch] %1 archive files found: %2").arg(batchArchiveFileNames.count()).arg(directory), 0);
+    batchArchiveFileIndex = 0;
+    batchPending.clear();
+    batchRunning = true;
+    batchCanceled = false;
+    next();
+    return true;
+}
+
+void xArchiveFileBatch::cancel() {
+    batchCanceled = true;
+    // Abort the wait for temp space.
+    batchArchiveFile->requestInterruption();
+    // Finish right away if we only wait for the encoding.
+    next();
+}
+
+bool xArchiveFileBatch::isRunning() const {
+    return batchRunning;
+}
+
+void xArchiveFileBatch::dequeued(quint64 jobId) {
+    if (batchPending.removeAll(jobId) > 0) {
+        next();
+    }
+}
+
+void xArchiveFileBatch::next() {
+    // Only one archive file is analyzed or extracted at a time.
+    if ((!batchRunning) || (batchActive)) {
+        return;
+    }
+    if ((batchCanceled) || (batchArchiveFileIndex >= batchArchiveFileNames.count())) {
+        emit messages(QString("[batch] %1 of %2 archive files imported").arg(batchArchiveFileIndex).
+                arg(batchArchiveFileNames.count()), 0);
+        batchRunning = false;
+        emit finished();
+        return;
+    }
+    // Extract the next archive file while the previous job is encoded, but do not get further ahead.
+    if (batchPending.count() >= xArchiveFileBatch_MaxPending) {
+        return;
+    }
+    batchActive = true;
+    emit progress(batchArchiveFileIndex, batchArchiveFileNames.count());
+    emit messages(QString("[batch] analyze: %1").arg(batchArchiveFileNames[batchArchiveFileIndex]), 0);
+    batchArchiveFile->analyze(batchArchiveFileNames[batchArchiveFileIndex]);
+    ++batchArchiveFileIndex;
+}
+
+void xArchiveFileBatch::analyzed(const QVector<QString>& fileNames, const QVector<qint64>& fileSizes) {
+    Q_UNUSED(fileSizes)
+    if (batchCanceled) {
+        batchActive = false;
+        next();
+        return;
+    }
+    auto tags = batchArchiveFile->extractTags(xArchiveFileSchemes::AutoDetect);
+    if ((fileNames.isEmpty()) || (tags.artist.isEmpty()) || (tags.album.isEmpty()) ||
+        (tags.trackName.count() != fileNames.count())) {
+        emit messages(QString("[error] no tag lookup scheme matches, skipped: %1").arg(batchArchiveFile->getFileName()), 0);
+        batchActive = false;
+        next();
+        return;
+    }
+    auto jobId = QRandomGenerator::global()->generate64();
+    batchArchiveFile->queueExtract(getAudioFiles(tags, jobId));
+    batchArchiveFile->start();
+}
+
+void xArchiveFileBatch::extracted(const QList<xAudioFile*>& files) {
+    if (!files.isEmpty()) {
+        batchPending.push_back(files.first()->getJobId());
+        emit audioFiles(files);
+    }
+}
+
+void xArchiveFileBatch::extractFinished() {
+    emit progress(batchArchiveFileIndex, batchArchiveFileNames.count());
+    batchActive = false;
+    next();
+}
+
+QList<xAudioFile*> xArchiveFileBatch::getAudioFiles(const xArchiveFileTags& tags, quint64 jobId) const {
+    auto tagId = static_cast<int>(tags.bitsPerSample == 24);
+    auto tag = xRipEncodeConfiguration::configuration()->getTags().value(tagId);
+    QList<std::tuple<int,QString,QString>> tracks;
+    for (auto track = 0; track < tags.trackName.count(); ++track) {
+        // Number the tracks within each disc for box sets.
+        auto trackNr = QString("%1").arg((tags.trackDisc.isEmpty()) ? track+1 : tags.trackDiscNr[track], 2, 10, QChar('0'));
+        // Track names are not allowed to have any "/".
+        tracks.push_back(std::make_tuple(track+1, trackNr, QString(tags.trackName[track]).replace('/', '-')));
+    }
+    return xArchiveFile::createAudioFiles(tags.artist, tags.album, tracks, tags.trackDisc, tag, tagId, jobId);
+}
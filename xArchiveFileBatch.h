@@ -0,0 +1,141 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __XARCHIVEFILEBATCH_H__
+#define __XARCHIVEFILEBATCH_H__
+
+#include "xArchiveFile.h"
+#include <QObject>
+#include <QStringList>
+#include <QList>
+
+/**
+ * @class xArchiveFileBatch
+ *
+ * @note Import all archive files of a directory. Each archive file is analyzed,
+ * its tag lookup scheme is auto detected and all tracks are extracted. The
+ * extracted audio files are handed over as batch job for the encoding. The next
+ * archive file is extracted while the previous job is encoded. The number of
+ * extracted jobs waiting for the encoding is limited to bound the temporary space.
+ */
+class xArchiveFileBatch:public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param parent pointer to the parent object.
+     */
+    explicit xArchiveFileBatch(QObject* parent=nullptr);
+    /**
+     * Destructor. Default.
+     */
+    ~xArchiveFileBatch() override = default;
+    /**
+     * Start the import of all supported archive files in the directory.
+     *
+     * @param directory the path to the directory as string.
+     * @return true if the import was started, false if running or no archive files were found.
+     */
+    bool start(const QString& directory);
+    /**
+     * Stop the import after the current archive file.
+     */
+    void cancel();
+    /**
+     * Check if an import is running.
+     *
+     * @return true if archive files are left to be imported, false otherwise.
+     */
+    [[nodiscard]] bool isRunning() const;
+
+public slots:
+    /**
+     * Called once the audio files of the batch job are encoded or removed.
+     * Continue with the next archive file if it was waiting.
+     *
+     * @param jobId the job ID of the batch job.
+     */
+    void dequeued(quint64 jobId);
+
+signals:
+    /**
+     * Signal the extracted audio files of one archive file.
+     *
+     * @param files a list of audio file objects.
+     */
+    void audioFiles(const QList<xAudioFile*>& files);
+    /**
+     * Signal the progress of the import.
+     *
+     * @param archive the number of archive files processed.
+     * @param archives the number of archive files in the directory.
+     */
+    void progress(int archive, int archives);
+    /**
+     * Signal emitted after the last archive file is extracted or the import is canceled.
+     */
+    void finished();
+    /**
+     * Signal the output of the import.
+     *
+     * @param msg the current output as string.
+     * @param jobId the job ID of the archive file extracted, 0 if none.
+     */
+    void messages(const QString& msg, quint64 jobId);
+
+private slots:
+    /**
+     * Lookup the tags and extract all tracks of the analyzed archive file.
+     *
+     * @param fileNames a vector of file names.
+     * @param fileSizes a vector of file sizes in bytes.
+     */
+    void analyzed(const QVector<QString>& fileNames, const QVector<qint64>& fileSizes);
+    /**
+     * Queue the extracted audio files as batch job.
+     *
+     * @param files a list of audio file objects.
+     */
+    void extracted(const QList<xAudioFile*>& files);
+    /**
+     * Continue with the next archive file after the extraction is finished.
+     */
+    void extractFinished();
+
+private:
+    /**
+     * Analyze the next archive file if not too many jobs wait for the encoding.
+     */
+    void next();
+    /**
+     * Create the audio file objects for all archived files.
+     *
+     * @param tags the tags determined by the auto detected scheme.
+     * @param jobId the job ID the files belong to.
+     * @return a list of audio file objects containing the necessary information.
+     */
+    [[nodiscard]] QList<xAudioFile*> getAudioFiles(const xArchiveFileTags& tags, quint64 jobId) const;
+
+    xArchiveFile* batchArchiveFile;
+    QStringList batchArchiveFileNames;
+    int batchArchiveFileIndex;
+    QList<quint64> batchPending;
+    bool batchRunning;
+    bool batchActive;
+    bool batchCanceled;
+};
+
+#endif
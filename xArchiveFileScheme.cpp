@@ -0,0 +1,237 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "xArchiveFileScheme.h"
+#include "xRipEncodeConfiguration.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <numeric>
+
+const QString xArchiveFileSchemes::AutoDetect { "Auto" };
+// Number of fields in front of the pattern.
+const int xArchiveFileScheme_Fields { 4 };
+// Disc folder within the archive, e.g. "CD1", "cd 02" or "Disc 3 - Live".
+const QRegularExpression xArchiveFileScheme_DiscFolder { R"(/(?:cd|disc|disk)[ _.-]*(\d+)[^/]*(?=/))",
+                                                         QRegularExpression::CaseInsensitiveOption };
+
+// singleton object.
+xArchiveFileSchemes* xArchiveFileSchemes::archiveFileSchemes = nullptr;
+
+xArchiveFileScheme::xArchiveFileScheme(const QString& definition):
+        bitsPerSample(0),
+        underscores(false),
+        hasDisc(false),
+        hasQuality(false),
+        valid(false) {
+    // The pattern is the last field and may contain the separator.
+    QStringList fields;
+    auto position = 0;
+    for (auto i = 0; i < xArchiveFileScheme_Fields; ++i) {
+        auto next = definition.indexOf(';', position);
+        if (next < 0) {
+            qCritical() << "xArchiveFileScheme: invalid definition: " << definition;
+            return;
+        }
+        fields.push_back(definition.mid(position, next-position).trimmed());
+        position = next+1;
+    }
+    name = fields[0];
+    bitsPerSample = fields[1].toInt();
+    for (const auto& marker : fields[2].split(',', Qt::SkipEmptyParts)) {
+        auto markerBitsPerSample = marker.section('=', 1).toInt();
+        if (markerBitsPerSample > 0) {
+            qualityBitsPerSample[marker.section('=', 0, 0).trimmed().toLower()] = markerBitsPerSample;
+        }
+    }
+    underscores = fields[3].split(',', Qt::SkipEmptyParts).contains("underscores", Qt::CaseInsensitive);
+    // Match the original file names. Lowercase conversions are not required.
+    pattern.setPattern(definition.mid(position));
+    pattern.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+    if (!pattern.isValid()) {
+        qCritical() << "xArchiveFileScheme: invalid pattern for " << name << ": " << pattern.errorString();
+        return;
+    }
+    auto groups = pattern.namedCaptureGroups();
+    if ((!groups.contains("artist")) || (!groups.contains("album")) || (!groups.contains("nr")) || (!groups.contains("name"))) {
+        qCritical() << "xArchiveFileScheme: missing groups in pattern for " << name;
+        return;
+    }
+    hasDisc = groups.contains("disc");
+    hasQuality = groups.contains("quality");
+    // Compile the pattern now instead of on the first match.
+    pattern.optimize();
+    valid = !name.isEmpty();
+}
+
+bool xArchiveFileScheme::isValid() const {
+    return valid;
+}
+
+const QString& xArchiveFileScheme::getName() const {
+    return name;
+}
+
+QRegularExpressionMatch xArchiveFileScheme::match(const QString& fileName) const {
+    return pattern.match(fileName);
+}
+
+xArchiveFileTags xArchiveFileScheme::extractTags(const QVector<QRegularExpressionMatch>& matches, const QVector<int>& fileDiscs,
+                                                 const QVector<qint64>& fileSizes, QVector<int>& trackNrs) const {
+    auto files = matches.count();
+    xArchiveFileTags tags { "", "", {}, {}, hasQuality ? 0 : bitsPerSample, {}, {} };
+    // Disc and track number within the disc for each archived file.
+    QVector<std::pair<int,int>> discTracks(files);
+    QVector<QString> trackNames(files);
+    trackNrs.clear();
+    for (auto index = 0; index < files; ++index) {
+        const auto& match = matches[index];
+        if (!match.hasMatch()) {
+            qCritical() << "xArchiveFileScheme::extractTags: " << name << ": no match for file: " << index;
+            return xArchiveFileTags{ "", "", {}, {}, 0, {}, {} };
+        }
+        auto disc = fileDiscs.value(index, 0);
+        if (hasDisc && (!match.captured("disc").isEmpty())) {
+            disc = match.captured("disc").toInt();
+        }
+        discTracks[index] = std::make_pair(std::max(disc, 1), match.captured("nr").toInt());
+        tags.artist = clean(match.captured("artist"));
+        tags.album = clean(match.captured("album"));
+        trackNames[index] = clean(match.captured("name"));
+        if (hasQuality) {
+            auto quality = qualityBitsPerSample.value(match.captured("quality").toLower(), 0);
+            if (quality == 0) {
+                qCritical() << "xArchiveFileScheme::extractTags: " << name << ": no valid quality tag: " << match.captured(0);
+                return xArchiveFileTags{ "", "", {}, {}, 0, {}, {} };
+            }
+            tags.bitsPerSample = std::max(tags.bitsPerSample, quality);
+        }
+    }
+    // Order the archived files by disc and track number. Discs may restart their track numbers at 1.
+    QVector<int> order(files);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&discTracks](int a, int b) {
+        return discTracks[a] < discTracks[b];
+    });
+    // Create return output. Order archived files according to their track number.
+    auto multiDisc = (files > 0) && (discTracks[order.first()].first != discTracks[order.last()].first);
+    tags.trackName.resize(files);
+    tags.trackSize.resize(files);
+    if (multiDisc) {
+        tags.trackDisc.resize(files);
+        tags.trackDiscNr.resize(files);
+    }
+    trackNrs.resize(files);
+    for (auto trackNr = 0; trackNr < files; ++trackNr) {
+        auto index = order[trackNr];
+        if ((trackNr > 0) && (discTracks[order[trackNr-1]] == discTracks[index])) {
+            qCritical() << "xArchiveFileScheme::extractTags: " << name << ": duplicate track number: "
+                        << discTracks[index].first << "-" << discTracks[index].second;
+            trackNrs.clear();
+            return xArchiveFileTags{ "", "", {}, {}, 0, {}, {} };
+        }
+        trackNrs[index] = trackNr+1;
+        tags.trackName[trackNr] = trackNames[index];
+        tags.trackSize[trackNr] = fileSizes.value(index, 0);
+        if (multiDisc) {
+            tags.trackDisc[trackNr] = discTracks[index].first;
+            tags.trackDiscNr[trackNr] = discTracks[index].second;
+        }
+    }
+    return tags;
+}
+
+QString xArchiveFileScheme::clean(const QString& value) const {
+    if (underscores) {
+        return QString(value).replace('_', ' ');
+    }
+    return value;
+}
+
+xArchiveFileSchemes* xArchiveFileSchemes::schemes() {
+    // Create and return singleton.
+    if (archiveFileSchemes == nullptr) {
+        archiveFileSchemes = new xArchiveFileSchemes();
+    }
+    return archiveFileSchemes;
+}
+
+QStringList xArchiveFileSchemes::getNames() {
+    update();
+    QStringList names { AutoDetect };
+    for (const auto& scheme : schemeList) {
+        names.push_back(scheme.getName());
+    }
+    return names;
+}
+
+xArchiveFileTags xArchiveFileSchemes::extractTags(const QString& scheme, const QVector<QString>& fileNames,
+                                                  const QVector<qint64>& fileSizes, QVector<int>& trackNrs, QString& detected) {
+    update();
+    // Schemes to be matched.
+    QList<const xArchiveFileScheme*> candidates;
+    for (const auto& entry : schemeList) {
+        if ((scheme.compare(AutoDetect, Qt::CaseInsensitive) == 0) || (scheme.compare(entry.getName(), Qt::CaseInsensitive) == 0)) {
+            candidates.push_back(&entry);
+        }
+    }
+    detected.clear();
+    trackNrs.clear();
+    if (candidates.isEmpty()) {
+        qCritical() << "xArchiveFileSchemes::extractTags: unknown scheme: " << scheme;
+        return xArchiveFileTags{ "", "", {}, {}, 0, {}, {} };
+    }
+    // Remove the disc folders of box sets. The schemes only match the remaining layout.
+    QVector<QString> matchFileNames(fileNames);
+    QVector<int> fileDiscs(fileNames.count(), 0);
+    for (auto index = 0; index < matchFileNames.count(); ++index) {
+        auto discMatch = xArchiveFileScheme_DiscFolder.match(matchFileNames[index]);
+        if (discMatch.hasMatch()) {
+            fileDiscs[index] = discMatch.captured(1).toInt();
+            matchFileNames[index].remove(discMatch.capturedStart(), discMatch.capturedLength());
+        }
+    }
+    // Match all archived files against all candidates in one pass.
+    QVector<QVector<QRegularExpressionMatch>> matches(candidates.count());
+    QVector<int> matched(candidates.count(), 0);
+    for (auto& candidateMatches : matches) {
+        candidateMatches.reserve(fileNames.count());
+    }
+    for (const auto& fileName : matchFileNames) {
+        for (auto c = 0; c < candidates.count(); ++c) {
+            matches[c].push_back(candidates[c]->match(fileName));
+            matched[c] += matches[c].last().hasMatch() ? 1 : 0;
+        }
+    }
+    // Use the scheme with the highest match rate. The first scheme wins on a tie.
+    auto best = static_cast<int>(std::max_element(matched.begin(), matched.end())-matched.begin());
+    detected = candidates[best]->getName();
+    qDebug() << "xArchiveFileSchemes::extractTags: " << detected << ": " << matched[best] << " of " << fileNames.count() << " files";
+    return candidates[best]->extractTags(matches[best], fileDiscs, fileSizes, trackNrs);
+}
+
+void xArchiveFileSchemes::update() {
+    auto definitions = xRipEncodeConfiguration::configuration()->getTagLookupSchemes();
+    if (definitions == schemeDefinitions) {
+        return;
+    }
+    schemeDefinitions = definitions;
+    schemeList.clear();
+    for (const auto& definition : schemeDefinitions) {
+        xArchiveFileScheme scheme(definition);
+        if (scheme.isValid()) {
+            schemeList.push_back(scheme);
+        }
+    }
+}
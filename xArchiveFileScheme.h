@@ -0,0 +1,155 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __XARCHIVEFILESCHEME_H__
+#define __XARCHIVEFILESCHEME_H__
+
+#include <QRegularExpression>
+#include <QStringList>
+#include <QVector>
+#include <QMap>
+
+struct xArchiveFileTags {
+    QString artist;
+    QString album;
+    QVector<QString> trackName;
+    QVector<qint64> trackSize;
+    int bitsPerSample;
+    // Disc and track number within the disc. Only filled for multi-disc archives.
+    QVector<int> trackDisc;
+    QVector<int> trackDiscNr;
+};
+
+/**
+ * @class xArchiveFileScheme
+ *
+ * @note Tag lookup scheme for the file names within an archive file. The scheme
+ * is defined as "name;bits per sample;quality markers;flags;pattern". The pattern
+ * requires the named groups artist, album, nr and name. The optional group disc
+ * is used to number the tracks of several discs consecutively. The optional group
+ * quality is mapped to the bits per sample using the quality markers (e.g.
+ * "smr=24,lls=16"). The flag underscores replaces underscores by spaces.
+ * Disc folders (e.g. "CD1", "Disc 2") are removed from the file names before
+ * matching and used as disc if the pattern does not capture the disc.
+ */
+class xArchiveFileScheme {
+public:
+    /**
+     * Constructor. Compile and optimize the pattern of the definition.
+     *
+     * @param definition the scheme definition as string.
+     */
+    explicit xArchiveFileScheme(const QString& definition);
+    ~xArchiveFileScheme() = default;
+    /**
+     * Check if the definition and the pattern are valid.
+     *
+     * @return true if the scheme can be used, false otherwise.
+     */
+    [[nodiscard]] bool isValid() const;
+    /**
+     * Return the name of the scheme.
+     *
+     * @return the name as string.
+     */
+    [[nodiscard]] const QString& getName() const;
+    /**
+     * Match the archived file name against the pattern.
+     *
+     * @param fileName the archived file name.
+     * @return the result of the match.
+     */
+    [[nodiscard]] QRegularExpressionMatch match(const QString& fileName) const;
+    /**
+     * Extract the tags from the matches of all archived files. The archived files
+     * are ordered by disc and track number and numbered consecutively.
+     *
+     * @param matches the matches of all archived files in order of the archive.
+     * @param fileDiscs the disc of each archived file determined by its folder, 0 if none.
+     * @param fileSizes the sizes of all archived files in order of the archive.
+     * @param trackNrs the track number of each archived file (output).
+     * @return the tags ordered by track number, empty on error.
+     */
+    [[nodiscard]] xArchiveFileTags extractTags(const QVector<QRegularExpressionMatch>& matches, const QVector<int>& fileDiscs,
+                                               const QVector<qint64>& fileSizes, QVector<int>& trackNrs) const;
+
+private:
+    /**
+     * Clean up a captured value.
+     *
+     * @param value the captured value.
+     * @return the value with underscores replaced if required.
+     */
+    [[nodiscard]] QString clean(const QString& value) const;
+
+    QString name;
+    QRegularExpression pattern;
+    QMap<QString,int> qualityBitsPerSample;
+    int bitsPerSample;
+    bool underscores;
+    bool hasDisc;
+    bool hasQuality;
+    bool valid;
+};
+
+/**
+ * @class xArchiveFileSchemes
+ *
+ * @note Registry of all tag lookup schemes. The schemes are loaded from the
+ * configuration and compiled once. They are reloaded if the configuration changes.
+ */
+class xArchiveFileSchemes {
+public:
+    // Name used to select the scheme with the highest match rate.
+    static const QString AutoDetect;
+    /**
+     * Return the registry of the schemes.
+     *
+     * @return pointer to a singleton of the registry.
+     */
+    static xArchiveFileSchemes* schemes();
+    /**
+     * Return the names of all valid schemes including the auto detection.
+     *
+     * @return a list of names.
+     */
+    [[nodiscard]] QStringList getNames();
+    /**
+     * Extract the tags using the given scheme. The archived file names are
+     * matched in one pass against the scheme or all schemes for the auto detection.
+     *
+     * @param scheme the name of the scheme or AutoDetect.
+     * @param fileNames the archived file names.
+     * @param fileSizes the sizes of the archived files.
+     * @param trackNrs the track number of each archived file (output).
+     * @param detected the name of the scheme used (output).
+     * @return the tags ordered by track number, empty on error.
+     */
+    [[nodiscard]] xArchiveFileTags extractTags(const QString& scheme, const QVector<QString>& fileNames,
+                                               const QVector<qint64>& fileSizes, QVector<int>& trackNrs, QString& detected);
+
+private:
+    xArchiveFileSchemes() = default;
+    ~xArchiveFileSchemes() = default;
+    /**
+     * Compile the schemes if the configuration changed.
+     */
+    void update();
+
+    static xArchiveFileSchemes* archiveFileSchemes;
+    QStringList schemeDefinitions;
+    QList<xArchiveFileScheme> schemeList;
+};
+
+#endif
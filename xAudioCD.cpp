@@ -19,9 +19,11 @@
  */
 
 #include "xAudioCD.h"
+#include "xTempSpace.h"
 #include <QFile>
 #include <QDataStream>
 #include <QCryptographicHash>
+#include <QElapsedTimer>
 #include <QDebug>
 
 #include "musicbrainz5/Query.h"
@@ -39,6 +41,10 @@
 #include "musicbrainz5/NameCreditList.h"
 #include "musicbrainz5/NameCredit.h"
 
+// Interval in ms in which the errors and messages of the rip are reported.
+const int xAudioCDRipper_ReportInterval { 1000 };
+// Maximal number of error and message lines per report.
+const int xAudioCDRipper_ReportLines { 10 };
 
 /**
  * xAudioCDLookup
@@ -79,6 +85,8 @@ void xAudioCDLookup::run() {
                     // So we need to filter out the only the media we want.
                     MusicBrainz5::CMediumList mediaList = fullRelease->MediaMatchingDiscID(musicBrainzID.toStdString());
                     if (mediaList.NumItems() != 0) {
+                        // The release date is of the form YYYY-MM-DD. Only the year is used.
+                        audioCDLookupResult.year = QString::fromStdString(fullRelease->Date()).left(4);
                         if (fullRelease->ReleaseGroup()) {
                             audioCDLookupResult.album = QString::fromStdString(fullRelease->ReleaseGroup()->Title());
                             qDebug() << "Album: '" << audioCDLookupResult.album << "'";
@@ -146,26 +154,52 @@ void xAudioCDLookup::run() {
  * This class handles the rip process in a separate thread. The process is initiated
  * from the xAudioCD class. Output is written as wav files.
  */
-xAudioCDRipper::xAudioCDRipper(cdrom_drive_t* drive, const QList<xAudioFile*>& tracks, QObject* parent):
+xAudioCDRipper::xAudioCDRipper(xAudioCDDrive* drive, const QList<xAudioFile*>& tracks, QObject* parent):
         QThread(parent),
         audioDrive(drive),
         audioTracks(tracks) {
 }
 
 void xAudioCDRipper::run() {
-    // Init paranoia.
-    cdrom_paranoia_t* audioDriveParanoia = paranoia_init(audioDrive);
+    // Init paranoia (if required by the drive).
+    audioDrive->ripStart();
+    // Reserve the temp space for the wav files of all tracks.
+    QList<std::pair<QString,qint64>> wavFileSizes;
     for (const auto& track : audioTracks) {
         auto trackNr = track->getAudioTrackNr();
-        if ((trackNr <= 0) || (trackNr > audioDrive->tracks)) {
+        if ((trackNr > 0) && (trackNr <= audioDrive->getTracks())) {
+            auto sectors = audioDrive->getTrackLastSector(trackNr)-audioDrive->getTrackFirstSector(trackNr)+1;
+            wavFileSizes.push_back({ track->getFileName(), static_cast<qint64>(sectors)*CDIO_CD_FRAMESIZE_RAW+44 });
+        }
+    }
+    // All tracks of a rip belong to the same job.
+    quint64 jobId = (audioTracks.isEmpty()) ? 0 : audioTracks.first()->getJobId();
+    qint64 wavFileSizeTotal = 0;
+    for (const auto& file : wavFileSizes) {
+        wavFileSizeTotal += file.second;
+    }
+    if (!xTempSpace::tempSpace()->available(wavFileSizeTotal)) {
+        emit messages(0, QString("[temp] waiting for temp space: %1 MB reserved").arg(xTempSpace::tempSpace()->reserved()/(1024*1024)), jobId);
+    }
+    if (!xTempSpace::tempSpace()->reserve(wavFileSizes)) {
+        emit error(0, "waiting for temp space canceled", true, jobId);
+        audioDrive->ripFinish();
+        return;
+    }
+    for (const auto& track : audioTracks) {
+        // The rip was canceled. Release the space of the remaining tracks.
+        if (isInterruptionRequested()) {
+            xTempSpace::tempSpace()->release(track->getFileName());
+            continue;
+        }
+        auto trackNr = track->getAudioTrackNr();
+        if ((trackNr <= 0) || (trackNr > audioDrive->getTracks())) {
             qInfo() << "Illegal track number: " << track->getAudioTrackNr() << ". Ignore and continue.";
             continue;
         }
-        lsn_t iFirstLsn = cdda_track_firstsector(audioDrive, trackNr);
-        lsn_t iLastLsn = cdda_track_lastsector(audioDrive, trackNr);
-        // Set reading mode for full paranoia, but allow skipping sectors.
-        paranoia_modeset(audioDriveParanoia, PARANOIA_MODE_FULL^PARANOIA_MODE_NEVERSKIP);
-        paranoia_seek(audioDriveParanoia, iFirstLsn, SEEK_SET);
+        lsn_t iFirstLsn = audioDrive->getTrackFirstSector(trackNr);
+        lsn_t iLastLsn = audioDrive->getTrackLastSector(trackNr);
+        audioDrive->seek(iFirstLsn);
         // Compute byte count. We need the size for the wav header.
         int byteCount = (iLastLsn-iFirstLsn+1) * CDIO_CD_FRAMESIZE_RAW;
         // Create wave file.
@@ -173,43 +207,75 @@ void xAudioCDRipper::run() {
         QFile wavFile(wavFilePath);
         if (!wavFile.open(QIODevice::WriteOnly)) {
             qCritical() << "Unable to open wav file: " << wavFilePath;
-            emit error(trackNr, "Unable to open wav file: "+wavFilePath, true);
+            emit error(trackNr, "Unable to open wav file: "+wavFilePath, true, track->getJobId());
+            xTempSpace::tempSpace()->release(wavFilePath);
             continue;
         }
         QDataStream wavFileStream(&wavFile);
         wavFileStream.setByteOrder(QDataStream::LittleEndian);
         // Write the wav header.
         writeWaveHeader(wavFileStream, byteCount);
+        // Errors and messages are reported at most once per interval.
+        QStringList trackErrors;
+        QStringList trackMessages;
+        int trackErrorsDropped = 0;
+        QElapsedTimer reportTimer;
+        reportTimer.start();
+        auto report = [&]() {
+            auto readErrors = audioDrive->readErrors();
+            if ((readErrors.first > 0) || (readErrors.second > 0)) {
+                trackErrors.push_back(QString("%1 read errors, %2 skipped sectors").arg(readErrors.first).arg(readErrors.second));
+            }
+            if (trackErrorsDropped > 0) {
+                trackErrors.push_back(QString("(%1 more errors)").arg(trackErrorsDropped));
+                trackErrorsDropped = 0;
+            }
+            if (!trackErrors.isEmpty()) {
+                qCritical() << "CDDA Errors: " << trackErrors;
+                emit error(trackNr, trackErrors.join('\n'), false, track->getJobId());
+                trackErrors.clear();
+            }
+            if (!trackMessages.isEmpty()) {
+                qInfo() << "CDDA Messages: " << trackMessages;
+                emit messages(trackNr, trackMessages.join('\n'), track->getJobId());
+                trackMessages.clear();
+            }
+            reportTimer.restart();
+        };
         // Read sectors.
         for (auto i = iFirstLsn; i <= iLastLsn; ++i) {
             // Read a sector
-            std::int16_t* readBuffer = paranoia_read(audioDriveParanoia, nullptr);
-            char* cddaErrors = cdda_errors(audioDrive);
-            char* cddaMessages = cdda_messages(audioDrive);
-            if (cddaErrors) {
-                qCritical() << "CDDA Errors: " << cddaErrors;
-                emit error(trackNr, QString(cddaErrors), false);
-                free(cddaErrors);
+            std::int16_t* readBuffer = audioDrive->read();
+            auto cddaErrors = audioDrive->errors();
+            auto cddaMessages = audioDrive->messages();
+            if (!cddaErrors.isEmpty()) {
+                if (trackErrors.count() < xAudioCDRipper_ReportLines) {
+                    trackErrors.push_back(cddaErrors.trimmed());
+                } else {
+                    ++trackErrorsDropped;
+                }
             }
-            if (cddaMessages) {
-                qInfo() << "CDDA Messages: " << cddaMessages;
-                emit messages(trackNr, QString(cddaMessages));
-                free(cddaMessages);
+            if ((!cddaMessages.isEmpty()) && (trackMessages.count() < xAudioCDRipper_ReportLines)) {
+                trackMessages.push_back(cddaMessages.trimmed());
+            }
+            if ((!readBuffer) || (reportTimer.elapsed() >= xAudioCDRipper_ReportInterval)) {
+                report();
             }
             if (!readBuffer) {
                 // Notify UI about the error.
-                emit error(trackNr, tr("Aborted due to a paranoia reading error"), true);
+                emit error(trackNr, tr("Aborted due to a paranoia reading error"), true, track->getJobId());
                 // Remove the corresponding wav file.
                 wavFile.remove();
+                xTempSpace::tempSpace()->release(wavFilePath);
                 break;
             }
             emit progress(trackNr, ((i-iFirstLsn)*100)/(iLastLsn-iFirstLsn));
             wavFileStream.writeRawData((char* )readBuffer, CDIO_CD_FRAMESIZE_RAW);
         }
+        report();
     }
-    // Free paranoia and close drive.
-    paranoia_free(audioDriveParanoia);
-
+    // Free paranoia.
+    audioDrive->ripFinish();
 }
 
 void xAudioCDRipper::writeWaveHeader(QDataStream& dataStream, qint32 byteCount) {
@@ -240,42 +306,27 @@ xAudioCD::xAudioCD(QObject* parent):
 }
 
 xAudioCD::~xAudioCD() {
+    // Stop the rippers including canceled ones before the drive is closed.
+    for (auto ripper : findChildren<xAudioCDRipper*>()) {
+        ripper->requestInterruption();
+        ripper->wait();
+    }
     close();
 }
 
 bool xAudioCD::detect() {
     // Close and retry detect.
+    close();
+    audioDrive = xAudioCDDrive::detect();
     if (audioDrive) {
-        cdda_close(audioDrive);
-    }
-    auto audioDrives = cdio_get_devices_with_cap(nullptr, CDIO_FS_AUDIO, false);
-    if ((audioDrives) && (*audioDrives)) {
-        // Take the first drive.
-        audioDrive = cdda_identify(*audioDrives, 1, nullptr);
-        cdio_free_device_list(audioDrives);
-        if (audioDrive) {
-            // Log messages and errors.
-            cdda_verbose_set(audioDrive, CDDA_MESSAGE_LOGIT, CDDA_MESSAGE_LOGIT);
-            // We'll set for verbose paranoia messages.
-            if (cdda_open(audioDrive)) {
-                qCritical() << "Unable to open drive.";
-                return false;
-            }
-            // Get messages.
-            char* cddaMessages = cdda_messages(audioDrive);
-            if (cddaMessages) {
-                emit ripMessages(0, QString(cddaMessages));
-                free(cddaMessages);
-            }
-            return true;
-        } else {
-            qCritical() << "Unable to access disc.";
-            return false;
+        // Get messages.
+        auto cddaMessages = audioDrive->messages();
+        if (!cddaMessages.isEmpty()) {
+            emit ripMessages(0, cddaMessages, 0);
         }
-    } else {
-        qInfo() << "No CD-ROM drive with an audio CD available";
-        return false;
+        return true;
     }
+    return false;
 }
 
 void xAudioCD::eject() {
@@ -285,25 +336,24 @@ void xAudioCD::eject() {
         }
     }
     if (audioDrive) {
-        if (cdio_eject_media(&audioDrive->p_cdio)) {
+        if (!audioDrive->eject()) {
             qCritical() << "Unable to eject disc.";
             return;
         }
-        cdda_close(audioDrive);
-        audioDrive = nullptr;
+        close();
     }
 }
 
 void xAudioCD::close() {
     if (audioDrive) {
-        cdda_close(audioDrive);
+        delete audioDrive;
         audioDrive = nullptr;
     }
 }
 
 int xAudioCD::getTracks() {
     if (audioDrive) {
-        return static_cast<int>(cdio_cddap_tracks(audioDrive));
+        return audioDrive->getTracks();
     } else {
         // No Audio CD or not yet detected.
         return -1;
@@ -313,10 +363,10 @@ int xAudioCD::getTracks() {
 QVector<qint64> xAudioCD::getTrackLengths() {
     QVector<qint64> lengths;
     if (audioDrive) {
-        auto tracks = cdio_cddap_tracks(audioDrive);
+        auto tracks = audioDrive->getTracks();
         for (auto i = 1; i <= tracks; ++i) {
-            auto firstSector = cdio_cddap_track_firstsector(audioDrive, i);
-            auto lastSector = cdio_cddap_track_lastsector(audioDrive, i);
+            auto firstSector = audioDrive->getTrackFirstSector(i);
+            auto lastSector = audioDrive->getTrackLastSector(i);
             qDebug() << "getTrackLengths in sectors: " << lastSector-firstSector+1;
             qint64 lengthInMs = static_cast<qint64>(lastSector-firstSector+1)*1000/75;
             qDebug() << "getTrackLength in ms: " << lengthInMs;
@@ -332,23 +382,23 @@ QString xAudioCD::getID() {
     }
     // Vector for toc data. Fill with zeros.
     QVector<uint32_t> tocData(100, 0);
-    uint32_t noTracks = cdio_cddap_tracks(audioDrive);
+    uint32_t noTracks = audioDrive->getTracks();
     uint32_t noAudioTracks = noTracks;
     uint32_t firstAudioTrack = 1;
     if (noTracks >= CDIO_CD_MAX_TRACKS) {
         return QString();
     }
     // Leadout track.
-    tocData[0] = cdio_cddap_track_firstsector(audioDrive, CDIO_CDROM_LEADOUT_TRACK)+CDIO_PREGAP_SECTORS;
+    tocData[0] = audioDrive->getTrackFirstSector(CDIO_CDROM_LEADOUT_TRACK)+CDIO_PREGAP_SECTORS;
     for (uint32_t track = 1; track <= noTracks; ++track) {
         // Do we have an audio track. Break if we do not.
-        if (cdda_track_audiop(audioDrive, track) == 0) {
-            tocData[0] = cdio_cddap_track_firstsector(audioDrive, CDIO_CDROM_LEADOUT_TRACK)+CDIO_PREGAP_SECTORS;
+        if (!audioDrive->isAudioTrack(track)) {
+            tocData[0] = audioDrive->getTrackFirstSector(CDIO_CDROM_LEADOUT_TRACK)+CDIO_PREGAP_SECTORS;
             noAudioTracks = track-1;
             break;
         }
         // Track offsets for tracks 1..99
-        tocData[track] = cdio_cddap_track_firstsector(audioDrive, track)+CDIO_PREGAP_SECTORS;
+        tocData[track] = audioDrive->getTrackFirstSector(track)+CDIO_PREGAP_SECTORS;
     }
     qDebug() << "xAudio::getID: first: " << firstAudioTrack << ", last: " << noAudioTracks << ", toc-data: " << tocData;
 #if 0
@@ -396,8 +446,8 @@ void xAudioCD::rip(const QList<xAudioFile*>& tracks) {
 
 void xAudioCD::ripCancel() {
     if (audioRipper) {
-        // End the thread.
-        audioRipper->quit();
+        // End the thread after the current track. Aborts the wait for temp space.
+        audioRipper->requestInterruption();
         // Reset the object.
         audioRipper = nullptr;
         audioTracks.clear();
@@ -405,6 +455,12 @@ void xAudioCD::ripCancel() {
 }
 
 void xAudioCD::ripThreadFinished() {
+    // A canceled ripper may finish after the next rip is started.
+    auto ripper = qobject_cast<xAudioCDRipper*>(sender());
+    if ((ripper) && (ripper != audioRipper)) {
+        ripper->deleteLater();
+        return;
+    }
     if (audioRipper) {
         delete audioRipper;
         audioRipper = nullptr;
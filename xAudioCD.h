@@ -16,12 +16,10 @@
 #define __XAUDIOCD_H__
 
 #include "xAudioFile.h"
+#include "xAudioCDDrive.h"
 #include <QThread>
 #include <QList>
 #include <QString>
-#include <cdio/paranoia/paranoia.h>
-#include <cdio/cd_types.h>
-#include <cdio/device.h>
 
 class xAudioCDLookup:public QThread {
     Q_OBJECT
@@ -33,6 +31,7 @@ public:
     typedef struct {
         QString artist;
         QString album;
+        QString year;
         QVector<QString> tracks;
     } xAudioCDLookupResult;
     /**
@@ -73,11 +72,11 @@ public:
     /**
      * Constructor.
      *
-     * @param drive pointer to the structure required by libcdio-paranoia.
+     * @param drive pointer to the audio CD drive (real or simulated).
      * @param tracks a list of audio files containing the necessary info.
      * @param parent pointer to the parent widget.
      */
-    xAudioCDRipper(cdrom_drive_t* drive, const QList<xAudioFile*>& tracks, QObject* parent=nullptr);
+    xAudioCDRipper(xAudioCDDrive* drive, const QList<xAudioFile*>& tracks, QObject* parent=nullptr);
     /**
      * Destructor (default)
      */
@@ -104,15 +103,17 @@ signals:
      * @param track number of the current track that is ripped.
      * @param error the error message as string.
      * @param abort the rip process is aborted if true, false otherwise.
+     * @param jobId the job ID of the current track.
      */
-    void error(int track, const QString& error, bool abort);
+    void error(int track, const QString& error, bool abort, quint64 jobId);
     /**
      * Signal emitted if a message occurs during the rip process.
      *
      * @param track number of the current track that is ripped.
      * @param message the rip message as string.
+     * @param jobId the job ID of the current track.
      */
-    void messages(int track, const QString& message);
+    void messages(int track, const QString& message, quint64 jobId);
 
 private:
     /**
@@ -123,7 +124,7 @@ private:
      */
     static void writeWaveHeader(QDataStream& dataStream, int byteCount);
 
-    cdrom_drive_t* audioDrive;
+    xAudioCDDrive* audioDrive;
     QList<xAudioFile*> audioTracks;
 };
 
@@ -197,15 +198,17 @@ signals:
      * @param track number of the current track that is ripped.
      * @param error the error message as string.
      * @param abort the rip process is aborted if true, false otherwise.
+     * @param jobId the job ID of the current track, 0 if none.
      */
-    void ripError(int track, const QString& error, bool abort);
+    void ripError(int track, const QString& error, bool abort, quint64 jobId);
     /**
      * Signal emitted (forwarded) if a message occurs during the rip process.
      *
      * @param track number of the current track that is ripped.
      * @param message the rip message as string.
+     * @param jobId the job ID of the current track, 0 if none.
      */
-    void ripMessages(int track, const QString& message);
+    void ripMessages(int track, const QString& message, quint64 jobId);
     /**
      * Signal emitted if the scan process is finished.
      */
@@ -218,7 +221,7 @@ private slots:
     void ripThreadFinished();
 
 private:
-    cdrom_drive_t* audioDrive;
+    xAudioCDDrive* audioDrive;
     xAudioCDRipper* audioRipper;
     QList<xAudioFile*> audioTracks;
 };
@@ -0,0 +1,320 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "xAudioCDDrive.h"
+#include "xRipEncodeConfiguration.h"
+#include <QThread>
+#include <QDebug>
+#include <cerrno>
+
+xAudioCDDrive* xAudioCDDrive::detect() {
+    // Use the simulated drive if an image is specified.
+    auto cueFileName = qEnvironmentVariable("XRIPENCODE_CDIMAGE");
+    if (!cueFileName.isEmpty()) {
+        auto imageDrive = new xAudioCDDriveImage(cueFileName, xAudioCDDriveImage::parametersFromEnvironment());
+        if (imageDrive->isValid()) {
+            qInfo() << "Using simulated audio CD drive with image: " << cueFileName;
+            return imageDrive;
+        }
+        qCritical() << "Unable to use audio CD image: " << cueFileName;
+        delete imageDrive;
+        return nullptr;
+    }
+    auto audioDrives = cdio_get_devices_with_cap(nullptr, CDIO_FS_AUDIO, false);
+    if ((audioDrives) && (*audioDrives)) {
+        // Take the first drive.
+        auto audioDrive = cdda_identify(*audioDrives, 1, nullptr);
+        cdio_free_device_list(audioDrives);
+        if (audioDrive) {
+            // Log messages and errors.
+            cdda_verbose_set(audioDrive, CDDA_MESSAGE_LOGIT, CDDA_MESSAGE_LOGIT);
+            // We'll set for verbose paranoia messages.
+            if (cdda_open(audioDrive)) {
+                qCritical() << "Unable to open drive.";
+                cdda_close(audioDrive);
+                return nullptr;
+            }
+            return new xAudioCDDriveParanoia(audioDrive);
+        } else {
+            qCritical() << "Unable to access disc.";
+            return nullptr;
+        }
+    } else {
+        qInfo() << "No CD-ROM drive with an audio CD available";
+        return nullptr;
+    }
+}
+
+/**
+ * xAudioCDDriveParanoia
+ *
+ * Audio CD drive accessed through libcdio-paranoia.
+ */
+xAudioCDDriveParanoia* xAudioCDDriveParanoia::paranoiaDrive = nullptr;
+
+xAudioCDDriveParanoia::xAudioCDDriveParanoia(cdrom_drive_t* drive):
+        xAudioCDDrive(),
+        audioDrive(drive),
+        audioDriveParanoia(nullptr),
+        paranoiaMaxRetries(0),
+        paranoiaReadErrors(0),
+        paranoiaSkips(0) {
+}
+
+xAudioCDDriveParanoia::~xAudioCDDriveParanoia() {
+    ripFinish();
+    if (audioDrive) {
+        cdda_close(audioDrive);
+    }
+}
+
+int xAudioCDDriveParanoia::getTracks() {
+    return static_cast<int>(cdio_cddap_tracks(audioDrive));
+}
+
+lsn_t xAudioCDDriveParanoia::getTrackFirstSector(int track) {
+    return cdio_cddap_track_firstsector(audioDrive, track);
+}
+
+lsn_t xAudioCDDriveParanoia::getTrackLastSector(int track) {
+    return cdio_cddap_track_lastsector(audioDrive, track);
+}
+
+bool xAudioCDDriveParanoia::isAudioTrack(int track) {
+    return (cdda_track_audiop(audioDrive, track) != 0);
+}
+
+bool xAudioCDDriveParanoia::eject() {
+    return (cdio_eject_media(&audioDrive->p_cdio) == DRIVER_OP_SUCCESS);
+}
+
+void xAudioCDDriveParanoia::ripStart() {
+    if (!audioDriveParanoia) {
+        audioDriveParanoia = paranoia_init(audioDrive);
+        // Set reading mode for full paranoia, but allow skipping sectors.
+        paranoia_modeset(audioDriveParanoia, PARANOIA_MODE_FULL^PARANOIA_MODE_NEVERSKIP);
+    }
+    paranoiaMaxRetries = xRipEncodeConfiguration::configuration()->getAudioCDMaxRetries();
+    paranoiaReadErrors = 0;
+    paranoiaSkips = 0;
+}
+
+void xAudioCDDriveParanoia::ripFinish() {
+    if (audioDriveParanoia) {
+        paranoia_free(audioDriveParanoia);
+        audioDriveParanoia = nullptr;
+    }
+    if (paranoiaDrive == this) {
+        paranoiaDrive = nullptr;
+    }
+}
+
+void xAudioCDDriveParanoia::seek(lsn_t sector) {
+    paranoia_seek(audioDriveParanoia, sector, SEEK_SET);
+}
+
+std::int16_t* xAudioCDDriveParanoia::read() {
+    paranoiaDrive = this;
+    return paranoia_read_limited(audioDriveParanoia, &xAudioCDDriveParanoia::paranoiaCallback, paranoiaMaxRetries);
+}
+
+QString xAudioCDDriveParanoia::errors() {
+    QString errorMessages;
+    char* cddaErrors = cdda_errors(audioDrive);
+    if (cddaErrors) {
+        errorMessages = QString(cddaErrors);
+        free(cddaErrors);
+    }
+    return errorMessages;
+}
+
+QString xAudioCDDriveParanoia::messages() {
+    QString messageMessages;
+    char* cddaMessages = cdda_messages(audioDrive);
+    if (cddaMessages) {
+        messageMessages = QString(cddaMessages);
+        free(cddaMessages);
+    }
+    return messageMessages;
+}
+
+std::pair<int,int> xAudioCDDriveParanoia::readErrors() {
+    auto errors = std::make_pair(paranoiaReadErrors, paranoiaSkips);
+    paranoiaReadErrors = 0;
+    paranoiaSkips = 0;
+    return errors;
+}
+
+void xAudioCDDriveParanoia::paranoiaCallback(long int position, paranoia_cb_mode_t mode) {
+    Q_UNUSED(position)
+    if (paranoiaDrive == nullptr) {
+        return;
+    }
+    switch (mode) {
+        case PARANOIA_CB_READERR: {
+            ++paranoiaDrive->paranoiaReadErrors;
+        } break;
+        case PARANOIA_CB_SKIP: {
+            ++paranoiaDrive->paranoiaSkips;
+        } break;
+        default: break;
+    }
+}
+
+/**
+ * xAudioCDDriveImage
+ *
+ * Simulated audio CD drive reading a BIN/CUE image through libcdio and paranoia.
+ * The read function of the drive structure is replaced in order to inject
+ * latency, jitter, read errors and scratches. Paranoia handles the failing
+ * reads the same way as for a real drive. The random generator is seeded in
+ * order to allow for reproducible runs.
+ */
+QMap<cdrom_drive_t*,xAudioCDDriveImage*> xAudioCDDriveImage::imageDrives;
+
+xAudioCDDriveImage::xAudioCDDriveImage(const QString& cueFileName, const xAudioCDDriveImageParameters& parameters):
+        xAudioCDDriveParanoia(openImage(cueFileName)),
+        imageParameters(parameters),
+        imageRandom(parameters.seed),
+        imageReadAudio(nullptr) {
+    if (audioDrive) {
+        // Read the image through our read function.
+        imageReadAudio = audioDrive->read_audio;
+        audioDrive->read_audio = &xAudioCDDriveImage::readAudio;
+        imageDrives[audioDrive] = this;
+        imageMessages.push_back(QString("Image %1: %2 tracks").arg(cueFileName).arg(getTracks()));
+    }
+}
+
+xAudioCDDriveImage::~xAudioCDDriveImage() {
+    imageDrives.remove(audioDrive);
+}
+
+bool xAudioCDDriveImage::isValid() const {
+    return (audioDrive != nullptr) && (imageReadAudio != nullptr);
+}
+
+xAudioCDDriveImageParameters xAudioCDDriveImage::parametersFromEnvironment() {
+    xAudioCDDriveImageParameters parameters;
+    parameters.latency = qEnvironmentVariableIntValue("XRIPENCODE_CDIMAGE_LATENCY");
+    parameters.jitter = qEnvironmentVariableIntValue("XRIPENCODE_CDIMAGE_JITTER");
+    parameters.errorRate = qEnvironmentVariable("XRIPENCODE_CDIMAGE_ERRORRATE", "0").toDouble();
+    parameters.scratchRetries = qEnvironmentVariable("XRIPENCODE_CDIMAGE_SCRATCHRETRIES", "5").toInt();
+    parameters.seed = qEnvironmentVariable("XRIPENCODE_CDIMAGE_SEED", "1").toUInt();
+    // Scratches are specified as comma separated list of sector ranges.
+    for (const auto& scratch : qEnvironmentVariable("XRIPENCODE_CDIMAGE_SCRATCHES").split(',', Qt::SkipEmptyParts)) {
+        auto range = scratch.split('-');
+        if (range.count() == 2) {
+            parameters.scratches.push_back(std::make_pair(range[0].trimmed().toInt(), range[1].trimmed().toInt()));
+        } else {
+            qCritical() << "Ignoring illegal scratch range: " << scratch;
+        }
+    }
+    return parameters;
+}
+
+cdrom_drive_t* xAudioCDDriveImage::openImage(const QString& cueFileName) {
+    auto imageCdio = cdio_open(cueFileName.toStdString().c_str(), DRIVER_BINCUE);
+    if (!imageCdio) {
+        qCritical() << "Unable to open audio CD image: " << cueFileName;
+        return nullptr;
+    }
+    auto imageDrive = cdio_cddap_identify_cdio(imageCdio, CDDA_MESSAGE_LOGIT, nullptr);
+    if (!imageDrive) {
+        qCritical() << "Unable to identify audio CD image: " << cueFileName;
+        cdio_destroy(imageCdio);
+        return nullptr;
+    }
+    cdda_verbose_set(imageDrive, CDDA_MESSAGE_LOGIT, CDDA_MESSAGE_LOGIT);
+    if (cdda_open(imageDrive)) {
+        qCritical() << "Unable to open audio CD image: " << cueFileName;
+        // Also destroys the cdio structure.
+        cdda_close(imageDrive);
+        return nullptr;
+    }
+    return imageDrive;
+}
+
+bool xAudioCDDriveImage::eject() {
+    imageMessages.push_back("Image ejected");
+    return true;
+}
+
+void xAudioCDDriveImage::ripStart() {
+    // Restart the random generator and the scratches for reproducible runs.
+    imageRandom.seed(imageParameters.seed);
+    imageFailedReads.clear();
+    xAudioCDDriveParanoia::ripStart();
+}
+
+QString xAudioCDDriveImage::messages() {
+    imageMessages.push_back(xAudioCDDriveParanoia::messages());
+    imageMessages.removeAll(QString());
+    auto messageMessages = imageMessages.join('\n');
+    imageMessages.clear();
+    return messageMessages;
+}
+
+long xAudioCDDriveImage::readAudio(cdrom_drive_t* drive, void* buffer, lsn_t begin, long sectors) {
+    auto image = imageDrives.value(drive, nullptr);
+    if (image == nullptr) {
+        errno = ENODEV;
+        return -1;
+    }
+    return image->simulateRead(buffer, begin, sectors);
+}
+
+long xAudioCDDriveImage::simulateRead(void* buffer, lsn_t begin, long sectors) {
+    // Only the sectors before the first failing one are read.
+    auto sectorsRead = sectors;
+    for (long sector = 0; sector < sectors; ++sector) {
+        simulateLatency();
+        auto failed = false;
+        if (isScratched(begin+sector)) {
+            // Scratched sectors can be read after the given number of failing reads.
+            failed = (imageFailedReads.value(begin+sector, 0) < imageParameters.scratchRetries);
+        } else if (imageParameters.errorRate > 0) {
+            failed = (imageRandom.generateDouble() < imageParameters.errorRate);
+        }
+        if (failed) {
+            ++imageFailedReads[begin+sector];
+            sectorsRead = sector;
+            break;
+        }
+    }
+    if (sectorsRead == 0) {
+        errno = EIO;
+        return -1;
+    }
+    return imageReadAudio(audioDrive, buffer, begin, sectorsRead);
+}
+
+void xAudioCDDriveImage::simulateLatency() {
+    auto latency = imageParameters.latency;
+    if (imageParameters.jitter > 0) {
+        latency += imageRandom.bounded(-imageParameters.jitter, imageParameters.jitter+1);
+    }
+    if (latency > 0) {
+        QThread::usleep(static_cast<unsigned long>(latency));
+    }
+}
+
+bool xAudioCDDriveImage::isScratched(lsn_t sector) const {
+    for (const auto& scratch : imageParameters.scratches) {
+        if ((sector >= scratch.first) && (sector <= scratch.second)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,266 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __XAUDIOCDDRIVE_H__
+#define __XAUDIOCDDRIVE_H__
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QMap>
+#include <QRandomGenerator>
+#include <cdio/paranoia/paranoia.h>
+#include <cdio/cd_types.h>
+#include <cdio/device.h>
+
+/**
+ * @class xAudioCDDrive
+ *
+ * @note Abstraction of the audio CD drive used by xAudioCD and xAudioCDRipper.
+ * The track numbering starts with 1. The leadout track is accessed using
+ * CDIO_CDROM_LEADOUT_TRACK.
+ */
+class xAudioCDDrive {
+public:
+    xAudioCDDrive() = default;
+    virtual ~xAudioCDDrive() = default;
+    /**
+     * Detect an audio CD drive.
+     *
+     * A simulated drive based on a BIN/CUE image is returned if the environment
+     * variable XRIPENCODE_CDIMAGE points to a cue sheet.
+     *
+     * @return pointer to the drive object if successful, nullptr otherwise.
+     */
+    static xAudioCDDrive* detect();
+    /**
+     * Determine the number of tracks of the audio CD.
+     *
+     * @return the number of tracks.
+     */
+    [[nodiscard]] virtual int getTracks() = 0;
+    /**
+     * Determine the first sector of the given track.
+     *
+     * @param track the track number (starting with 1) or the leadout track.
+     * @return the first sector of the track.
+     */
+    [[nodiscard]] virtual lsn_t getTrackFirstSector(int track) = 0;
+    /**
+     * Determine the last sector of the given track.
+     *
+     * @param track the track number (starting with 1).
+     * @return the last sector of the track.
+     */
+    [[nodiscard]] virtual lsn_t getTrackLastSector(int track) = 0;
+    /**
+     * Check if the given track is an audio track.
+     *
+     * @param track the track number (starting with 1).
+     * @return true if the track is an audio track, false otherwise.
+     */
+    [[nodiscard]] virtual bool isAudioTrack(int track) = 0;
+    /**
+     * Eject the audio CD.
+     *
+     * @return true if successful, false otherwise.
+     */
+    virtual bool eject() = 0;
+    /**
+     * Prepare the drive for ripping. Called once before the first seek.
+     */
+    virtual void ripStart() = 0;
+    /**
+     * Cleanup after ripping. Called once after the last read.
+     */
+    virtual void ripFinish() = 0;
+    /**
+     * Seek to the given sector.
+     *
+     * @param sector the sector the following read operations start with.
+     */
+    virtual void seek(lsn_t sector) = 0;
+    /**
+     * Read the next sector.
+     *
+     * @return pointer to CDIO_CD_FRAMESIZE_RAW bytes of audio data, nullptr on unrecoverable errors.
+     */
+    virtual std::int16_t* read() = 0;
+    /**
+     * Retrieve and clear the error messages of the drive.
+     *
+     * @return the error messages as string, empty if no errors occurred.
+     */
+    [[nodiscard]] virtual QString errors() = 0;
+    /**
+     * Retrieve and clear the messages of the drive.
+     *
+     * @return the messages as string, empty if there are no messages.
+     */
+    [[nodiscard]] virtual QString messages() = 0;
+    /**
+     * Retrieve and clear the number of read errors and skipped sectors.
+     *
+     * @return pair of read errors and skipped sectors since the last call.
+     */
+    [[nodiscard]] virtual std::pair<int,int> readErrors() = 0;
+};
+
+class xAudioCDDriveParanoia:public xAudioCDDrive {
+public:
+    /**
+     * Constructor.
+     *
+     * @param drive pointer to the opened structure required by libcdio-paranoia.
+     */
+    explicit xAudioCDDriveParanoia(cdrom_drive_t* drive);
+    /**
+     * Destructor. Close the drive.
+     */
+    ~xAudioCDDriveParanoia() override;
+
+    [[nodiscard]] int getTracks() override;
+    [[nodiscard]] lsn_t getTrackFirstSector(int track) override;
+    [[nodiscard]] lsn_t getTrackLastSector(int track) override;
+    [[nodiscard]] bool isAudioTrack(int track) override;
+    bool eject() override;
+    void ripStart() override;
+    void ripFinish() override;
+    void seek(lsn_t sector) override;
+    std::int16_t* read() override;
+    [[nodiscard]] QString errors() override;
+    [[nodiscard]] QString messages() override;
+    [[nodiscard]] std::pair<int,int> readErrors() override;
+
+protected:
+    cdrom_drive_t* audioDrive;
+
+private:
+    /**
+     * Count the read errors and skipped sectors reported by paranoia.
+     *
+     * @param position the position of the event in samples.
+     * @param mode the type of the event.
+     */
+    static void paranoiaCallback(long int position, paranoia_cb_mode_t mode);
+
+    // The paranoia callback does not have a context. Only one drive is read at a time.
+    static xAudioCDDriveParanoia* paranoiaDrive;
+    cdrom_paranoia_t* audioDriveParanoia;
+    int paranoiaMaxRetries;
+    int paranoiaReadErrors;
+    int paranoiaSkips;
+};
+
+/**
+ * Parameters for the simulated drive. Latency and jitter are given in
+ * microseconds per sector. The error rate is the probability of a failing
+ * read per sector. Reads of sectors within a scratch fail the given number
+ * of times. Paranoia skips the sector if it requires more than the
+ * configured maximal number of retries.
+ */
+struct xAudioCDDriveImageParameters {
+    int latency;
+    int jitter;
+    double errorRate;
+    QVector<std::pair<lsn_t,lsn_t>> scratches;
+    int scratchRetries;
+    quint32 seed;
+};
+
+class xAudioCDDriveImage:public xAudioCDDriveParanoia {
+public:
+    /**
+     * Constructor. Open the BIN/CUE image with libcdio and read it through paranoia.
+     *
+     * @param cueFileName path to the cue sheet of the image.
+     * @param parameters the parameters used to simulate the drive behavior.
+     */
+    xAudioCDDriveImage(const QString& cueFileName, const xAudioCDDriveImageParameters& parameters);
+    /**
+     * Destructor. Close the image.
+     */
+    ~xAudioCDDriveImage() override;
+    /**
+     * Check if the image was opened successfully.
+     *
+     * @return true if the image can be used, false otherwise.
+     */
+    [[nodiscard]] bool isValid() const;
+    /**
+     * Read the simulation parameters from the environment.
+     *
+     * XRIPENCODE_CDIMAGE_LATENCY, XRIPENCODE_CDIMAGE_JITTER (microseconds),
+     * XRIPENCODE_CDIMAGE_ERRORRATE (0.0-1.0), XRIPENCODE_CDIMAGE_SCRATCHES
+     * (e.g. "1000-1200,5000-5100"), XRIPENCODE_CDIMAGE_SCRATCHRETRIES and
+     * XRIPENCODE_CDIMAGE_SEED.
+     *
+     * @return the parameters structure.
+     */
+    static xAudioCDDriveImageParameters parametersFromEnvironment();
+
+    bool eject() override;
+    void ripStart() override;
+    [[nodiscard]] QString messages() override;
+
+private:
+    /**
+     * Open the image and identify it as drive for paranoia.
+     *
+     * @param cueFileName path to the cue sheet of the image.
+     * @return pointer to the opened drive structure, nullptr on error.
+     */
+    static cdrom_drive_t* openImage(const QString& cueFileName);
+    /**
+     * Read function installed in the drive structure. Called by paranoia.
+     *
+     * @param drive pointer to the drive structure.
+     * @param buffer the buffer for the audio data.
+     * @param begin the first sector to read.
+     * @param sectors the number of sectors to read.
+     * @return the number of sectors read, -1 on error.
+     */
+    static long readAudio(cdrom_drive_t* drive, void* buffer, lsn_t begin, long sectors);
+    /**
+     * Inject latency and read errors and read the sectors up to the first failing one.
+     *
+     * @param buffer the buffer for the audio data.
+     * @param begin the first sector to read.
+     * @param sectors the number of sectors to read.
+     * @return the number of sectors read, -1 on error.
+     */
+    long simulateRead(void* buffer, lsn_t begin, long sectors);
+    /**
+     * Simulate the time required to read a sector.
+     */
+    void simulateLatency();
+    /**
+     * Check if the sector is within one of the scratches.
+     *
+     * @param sector the sector to check.
+     * @return true if the sector is scratched, false otherwise.
+     */
+    [[nodiscard]] bool isScratched(lsn_t sector) const;
+
+    // Map the drive structure passed to the read function to the simulated drive.
+    static QMap<cdrom_drive_t*,xAudioCDDriveImage*> imageDrives;
+    xAudioCDDriveImageParameters imageParameters;
+    QRandomGenerator imageRandom;
+    long (*imageReadAudio)(cdrom_drive_t* drive, void* buffer, lsn_t begin, long sectors);
+    QHash<lsn_t,int> imageFailedReads;
+    QStringList imageMessages;
+};
+
+#endif
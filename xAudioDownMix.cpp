@@ -0,0 +1,174 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "xAudioDownMix.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <numeric>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define xAudioDownMix_X86
+#include <immintrin.h>
+#endif
+
+// Speaker positions as used in the wav channel mask.
+enum xAudioDownMixSpeaker : quint64 {
+    FrontLeft = 0x1, FrontRight = 0x2, FrontCenter = 0x4, LowFrequency = 0x8,
+    BackLeft = 0x10, BackRight = 0x20, FrontLeftOfCenter = 0x40, FrontRightOfCenter = 0x80,
+    BackCenter = 0x100, SideLeft = 0x200, SideRight = 0x400, TopCenter = 0x800,
+    TopFrontLeft = 0x1000, TopFrontCenter = 0x2000, TopFrontRight = 0x4000,
+    TopBackLeft = 0x8000, TopBackCenter = 0x10000, TopBackRight = 0x20000
+};
+
+// Level for channels mixed into both sides, such as a back center.
+const float xAudioDownMix_CenterLevel { 0.7071f };
+
+/**
+ * Scalar kernel. Also used for the remaining samples of the vector kernels.
+ */
+static void xAudioDownMixScalar(const float* const* input, const float* leftLevels, const float* rightLevels,
+                                int channels, int offset, int samples, float* left, float* right) {
+    for (auto i = offset; i < samples; ++i) {
+        float leftSample = 0.0f, rightSample = 0.0f;
+        for (auto c = 0; c < channels; ++c) {
+            leftSample += leftLevels[c]*input[c][i];
+            rightSample += rightLevels[c]*input[c][i];
+        }
+        left[i] = leftSample;
+        right[i] = rightSample;
+    }
+}
+
+static void xAudioDownMixKernelScalar(const float* const* input, const float* leftLevels, const float* rightLevels,
+                                      int channels, int samples, float* left, float* right) {
+    xAudioDownMixScalar(input, leftLevels, rightLevels, channels, 0, samples, left, right);
+}
+
+#ifdef xAudioDownMix_X86
+__attribute__((target("sse")))
+static void xAudioDownMixKernelSSE(const float* const* input, const float* leftLevels, const float* rightLevels,
+                                   int channels, int samples, float* left, float* right) {
+    auto i = 0;
+    for (; i+4 <= samples; i += 4) {
+        auto leftSamples = _mm_setzero_ps();
+        auto rightSamples = _mm_setzero_ps();
+        for (auto c = 0; c < channels; ++c) {
+            auto samplesIn = _mm_loadu_ps(input[c]+i);
+            leftSamples = _mm_add_ps(leftSamples, _mm_mul_ps(_mm_set1_ps(leftLevels[c]), samplesIn));
+            rightSamples = _mm_add_ps(rightSamples, _mm_mul_ps(_mm_set1_ps(rightLevels[c]), samplesIn));
+        }
+        _mm_storeu_ps(left+i, leftSamples);
+        _mm_storeu_ps(right+i, rightSamples);
+    }
+    xAudioDownMixScalar(input, leftLevels, rightLevels, channels, i, samples, left, right);
+}
+
+__attribute__((target("avx")))
+static void xAudioDownMixKernelAVX(const float* const* input, const float* leftLevels, const float* rightLevels,
+                                   int channels, int samples, float* left, float* right) {
+    auto i = 0;
+    for (; i+8 <= samples; i += 8) {
+        auto leftSamples = _mm256_setzero_ps();
+        auto rightSamples = _mm256_setzero_ps();
+        for (auto c = 0; c < channels; ++c) {
+            auto samplesIn = _mm256_loadu_ps(input[c]+i);
+            leftSamples = _mm256_add_ps(leftSamples, _mm256_mul_ps(_mm256_set1_ps(leftLevels[c]), samplesIn));
+            rightSamples = _mm256_add_ps(rightSamples, _mm256_mul_ps(_mm256_set1_ps(rightLevels[c]), samplesIn));
+        }
+        _mm256_storeu_ps(left+i, leftSamples);
+        _mm256_storeu_ps(right+i, rightSamples);
+    }
+    xAudioDownMixScalar(input, leftLevels, rightLevels, channels, i, samples, left, right);
+}
+#endif
+
+xAudioDownMix::xAudioDownMix(const QVector<quint64>& channels, const xAudioDownMixLevels& levels):
+        leftLevels(static_cast<size_t>(channels.count()), 0.0f),
+        rightLevels(static_cast<size_t>(channels.count()), 0.0f),
+        kernel(xAudioDownMixKernelScalar) {
+    if (channels.count() == 1) {
+        // Mono is copied to both sides.
+        leftLevels[0] = rightLevels[0] = 1.0f;
+    } else {
+        for (auto c = 0; c < channels.count(); ++c) {
+            switch (channels[c]) {
+                case FrontLeft:
+                case FrontLeftOfCenter:
+                    leftLevels[c] = 1.0f;
+                    break;
+                case FrontRight:
+                case FrontRightOfCenter:
+                    rightLevels[c] = 1.0f;
+                    break;
+                case FrontCenter:
+                case TopCenter:
+                case TopFrontCenter:
+                    leftLevels[c] = rightLevels[c] = levels.center;
+                    break;
+                case LowFrequency:
+                    leftLevels[c] = rightLevels[c] = levels.lfe;
+                    break;
+                case SideLeft:
+                case TopFrontLeft:
+                    leftLevels[c] = levels.surround;
+                    break;
+                case SideRight:
+                case TopFrontRight:
+                    rightLevels[c] = levels.surround;
+                    break;
+                case BackLeft:
+                case TopBackLeft:
+                    leftLevels[c] = levels.back;
+                    break;
+                case BackRight:
+                case TopBackRight:
+                    rightLevels[c] = levels.back;
+                    break;
+                case BackCenter:
+                case TopBackCenter:
+                    leftLevels[c] = rightLevels[c] = levels.back*xAudioDownMix_CenterLevel;
+                    break;
+                default:
+                    // Unknown positions are dropped.
+                    qWarning() << "xAudioDownMix: unknown channel position: " << channels[c];
+                    break;
+            }
+        }
+    }
+    // Normalize both sides by the same factor to avoid clipping.
+    auto sum = std::max(std::accumulate(leftLevels.begin(), leftLevels.end(), 0.0f),
+                        std::accumulate(rightLevels.begin(), rightLevels.end(), 0.0f));
+    if (sum > 1.0f) {
+        for (auto c = 0; c < channels.count(); ++c) {
+            leftLevels[c] /= sum;
+            rightLevels[c] /= sum;
+        }
+    }
+#ifdef xAudioDownMix_X86
+    if (__builtin_cpu_supports("avx")) {
+        kernel = xAudioDownMixKernelAVX;
+    } else if (__builtin_cpu_supports("sse")) {
+        kernel = xAudioDownMixKernelSSE;
+    }
+#endif
+}
+
+void xAudioDownMix::process(const float* const* input, int samples, float* left, float* right) const {
+    kernel(input, leftLevels.data(), rightLevels.data(), static_cast<int>(leftLevels.size()), samples, left, right);
+}
+
+int xAudioDownMix::getChannels() const {
+    return static_cast<int>(leftLevels.size());
+}
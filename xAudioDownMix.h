@@ -0,0 +1,74 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __XAUDIODOWNMIX_H__
+#define __XAUDIODOWNMIX_H__
+
+#include <QVector>
+#include <vector>
+
+/**
+ * Levels used to mix the non-front channels into the stereo output.
+ */
+struct xAudioDownMixLevels {
+    float center;
+    float lfe;
+    float surround;
+    float back;
+};
+
+/**
+ * @class xAudioDownMix
+ *
+ * @note Down mix planar float samples of a multi-channel layout to stereo.
+ * The mix matrix is computed from the channel positions (wav speaker mask bits)
+ * and the configured levels. It is normalized to avoid clipping. The matrix
+ * kernel uses AVX or SSE if supported by the CPU.
+ */
+class xAudioDownMix {
+public:
+    /**
+     * Constructor. Compute the mix matrix.
+     *
+     * @param channels the speaker mask bit for each input channel, 0 if unknown.
+     * @param levels the levels for center, lfe, surround and back channels.
+     */
+    xAudioDownMix(const QVector<quint64>& channels, const xAudioDownMixLevels& levels);
+    ~xAudioDownMix() = default;
+    /**
+     * Down mix the given samples.
+     *
+     * @param input pointers to the planar samples of each input channel.
+     * @param samples number of samples per channel.
+     * @param left output buffer for the left channel.
+     * @param right output buffer for the right channel.
+     */
+    void process(const float* const* input, int samples, float* left, float* right) const;
+    /**
+     * Return the number of input channels.
+     *
+     * @return the number of channels.
+     */
+    [[nodiscard]] int getChannels() const;
+
+private:
+    typedef void (*xAudioDownMixKernel)(const float* const* input, const float* leftLevels, const float* rightLevels,
+                                        int channels, int samples, float* left, float* right);
+
+    std::vector<float> leftLevels;
+    std::vector<float> rightLevels;
+    xAudioDownMixKernel kernel;
+};
+
+#endif
@@ -13,9 +13,19 @@
  */
 
 #include "xAudioFile.h"
+#include "xAudioLoudness.h"
+#include "xAudioFingerprint.h"
 #include "xRipEncodeConfiguration.h"
+#include "xTempSpace.h"
+#include "xLogSink.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMap>
+#include <QtEndian>
 #include <QDebug>
-
+#include <algorithm>
+#include <functional>
+#include <limits>
 
 
 xAudioFileEncoding::xAudioFileEncoding(const QList<std::pair<xAudioFile*,QString>>& files, bool flac, QObject* parent):
@@ -25,17 +35,209 @@ xAudioFileEncoding::xAudioFileEncoding(const QList<std::pair<xAudioFile*,QString
 }
 
 void xAudioFileEncoding::run() {
-    if (encodeFlac) {
-        for (auto i = 0; i < encodeFiles.count(); ++i) {
-            encodeFiles[i].first->encodeFlac(encodeFiles[i].second);
-            emit encodingProgress(i+1, 100);
+    // Verify the encoded flac files in parallel to the encoding of the following files.
+    std::unique_ptr<xAudioFileVerification> verification;
+    if ((encodeFlac) && (xRipEncodeConfiguration::configuration()->getVerify())) {
+        verification = std::make_unique<xAudioFileVerification>();
+        connect(verification.get(), &xAudioFileVerification::verified, this, &xAudioFileEncoding::encodingVerified);
+        connect(verification.get(), &xAudioFileVerification::verified, this, [this](int track, bool passed) {
+            if (!passed) {
+                failed(track, "verification");
+            }
+        }, Qt::DirectConnection);
+        verification->start();
+    }
+    // Measure the encoding throughput based on the size of the input files.
+    QElapsedTimer encodingTimer;
+    qint64 encodingBytes = 0;
+    encodingTimer.start();
+    // Group the encoded files by album for the album loudness.
+    auto replayGain = xRipEncodeConfiguration::configuration()->getReplayGain();
+    QMap<std::pair<QString,QString>,QList<int>> encodedAlbums;
+    for (auto i = 0; i < encodeFiles.count(); ++i) {
+        try {
+            encodingBytes += static_cast<qint64>(std::filesystem::file_size(encodeFiles[i].first->getFileName().toStdString()));
+        } catch (std::filesystem::filesystem_error& e) {
+            // Ignore errors. The encoding will report them.
         }
-    } else {
-        for (auto i = 0; i < encodeFiles.count(); ++i) {
+        if (encodeFlac) {
+            if (encodeFiles[i].first->encodeFlac(encodeFiles[i].second)) {
+                if (verification) {
+                    verification->add(i+1, encodeFiles[i].first, encodeFiles[i].second);
+                }
+                // Silent tracks are not tagged and do not contribute to the album loudness.
+                auto loudness = (replayGain) ? encodeFiles[i].first->getLoudness() : nullptr;
+                if ((loudness) && (loudness->isValid())) {
+                    encodedAlbums[std::make_pair(encodeFiles[i].first->getArtist(), encodeFiles[i].first->getAlbum())].push_back(i);
+                } else if (loudness) {
+                    emit messages(QString("[warning] no audio above the loudness gate, ReplayGain tags skipped: %1").arg(encodeFiles[i].second));
+                }
+            } else {
+                failed(i+1, "encoding");
+            }
+        } else {
             encodeFiles[i].first->encodeWavPack(encodeFiles[i].second);
-            emit encodingProgress(i+1, 100);
+        }
+        emit encodingProgress(i+1, 100);
+    }
+    // The tags are only updated after the files are verified.
+    if (verification) {
+        verification->close();
+        verification->wait();
+    }
+    // The loudness was measured while encoding. Only the tags need to be added.
+    // Files that failed the verification are removed and do not contribute to the album.
+    for (auto& album : encodedAlbums) {
+        album.erase(std::remove_if(album.begin(), album.end(), [this](int index) {
+            return encodeFailed.contains(index+1);
+        }), album.end());
+        if (album.isEmpty()) {
+            continue;
+        }
+        QList<const xAudioLoudness*> measurements;
+        double albumPeak = 0.0;
+        for (const auto& index : album) {
+            measurements.push_back(encodeFiles[index].first->getLoudness());
+            albumPeak = std::max(albumPeak, encodeFiles[index].first->getLoudness()->getTruePeak());
+        }
+        auto albumLoudness = xAudioLoudness::getLoudness(measurements);
+        for (const auto& index : album) {
+            encodeFiles[index].first->tagReplayGain(encodeFiles[index].second, albumLoudness, albumPeak);
+        }
+    }
+    auto encodingTime = encodingTimer.elapsed();
+    emit messages(QString("[timing] %1: %2 files, %3 bytes in %4 ms (%5 MB/s)").arg((encodeFlac) ? "encode" : "backup").
+            arg(encodeFiles.count()).arg(encodingBytes).arg(encodingTime).
+            arg(xLogSink::throughput(encodingBytes, encodingTime), 0, 'f', 2));
+}
+
+const QList<int>& xAudioFileEncoding::getFailed() const {
+    return encodeFailed;
+}
+
+void xAudioFileEncoding::failed(int track, const QString& reason) {
+    {
+        QMutexLocker locker(&encodeFailedLock);
+        encodeFailed.push_back(track);
+    }
+    emit messages(QString("[error] %1 failed: %2").arg(reason).arg(encodeFiles[track-1].second));
+}
+
+xAudioFileVerification::xAudioFileVerification(QObject* parent):
+        QThread(parent),
+        verifyClosed(false) {
+}
+
+void xAudioFileVerification::add(int track, xAudioFile* file, const QString& flacFileName) {
+    QMutexLocker locker(&verifyLock);
+    verifyQueue.push_back(xAudioFileVerificationEntry{ track, file, flacFileName });
+    verifyCondition.wakeOne();
+}
+
+void xAudioFileVerification::close() {
+    QMutexLocker locker(&verifyLock);
+    verifyClosed = true;
+    verifyCondition.wakeAll();
+}
+
+void xAudioFileVerification::run() {
+    std::vector<std::unique_ptr<QThread>> workers;
+    for (auto i = 0; i < std::max(QThread::idealThreadCount(), 1); ++i) {
+        workers.emplace_back(QThread::create([this]() { verifyQueued(); }));
+        workers.back()->start();
+    }
+    for (auto& worker : workers) {
+        worker->wait();
+    }
+}
+
+void xAudioFileVerification::verifyQueued() {
+    forever {
+        xAudioFileVerificationEntry entry;
+        {
+            QMutexLocker locker(&verifyLock);
+            while ((verifyQueue.isEmpty()) && (!verifyClosed)) {
+                verifyCondition.wait(&verifyLock);
+            }
+            if (verifyQueue.isEmpty()) {
+                return;
+            }
+            entry = verifyQueue.takeFirst();
+        }
+        auto passed = entry.file->verifyFlac(entry.flacFileName);
+        qInfo() << "xAudioFileVerification: " << entry.flacFileName << ": " << ((passed) ? "passed" : "failed");
+        if (!passed) {
+            // Do not leave a corrupt file in the library. The source is kept for another encoding.
+            try {
+                std::filesystem::remove(entry.flacFileName.toStdString());
+            } catch (std::filesystem::filesystem_error& e) {
+                qWarning() << "Unable to remove corrupt output file: " << entry.flacFileName << ", error: " << e.what() << ", ignoring.";
+            }
+        }
+        emit verified(entry.track, passed);
+    }
+}
+
+xAudioFileFingerprinting::xAudioFileFingerprinting(const QList<xAudioFile*>& files, const xAudioFingerprintIndex& index,
+                                                   const QList<std::pair<xAudioFile*,xAudioFingerprint>>& pending, QObject* parent):
+        QThread(parent),
+        fingerprintFiles(files),
+        fingerprintIndex(index),
+        fingerprintPending(pending) {
+}
+
+void xAudioFileFingerprinting::run() {
+    for (auto& file : fingerprintFiles) {
+        if (!file->fingerprint()) {
+            qWarning() << "xAudioFileFingerprinting::run: no fingerprint for: " << file->getFileName();
         }
     }
+    auto describe = [](const xAudioFingerprint& fingerprint) {
+        return QString("%1 - %2 - %3 (%4Hz/%5bit/%6ch)").arg(fingerprint.artist, fingerprint.album, fingerprint.trackName)
+                .arg(fingerprint.sampleRate).arg(fingerprint.bitsPerSample).arg(fingerprint.channels);
+    };
+    // The new files are pending as well.
+    for (const auto& file : fingerprintFiles) {
+        if (file->getFingerprint()) {
+            fingerprintPending.push_back(std::make_pair(file, *file->getFingerprint()));
+        }
+    }
+    fingerprintDuplicates.clear();
+    fingerprintLowerResolutionFiles.clear();
+    for (const auto& file : fingerprintFiles) {
+        auto fileFingerprint = file->getFingerprint();
+        if (fileFingerprint == nullptr) {
+            continue;
+        }
+        // Compare against the already encoded tracks.
+        for (const auto& indexFingerprint : fingerprintIndex.find(*fileFingerprint)) {
+            fingerprintDuplicates.push_back(tr("%1 already encoded as %2").arg(describe(*fileFingerprint), describe(indexFingerprint)));
+            if (xAudioFingerprinter::isHigherResolution(indexFingerprint, *fileFingerprint)) {
+                fingerprintLowerResolutionFiles.push_back(file);
+            }
+        }
+        // Compare against all other pending tracks.
+        for (const auto& [pendingFile, pendingFingerprint] : fingerprintPending) {
+            if ((pendingFile == file) || (!xAudioFingerprinter::isDuplicate(pendingFingerprint, *fileFingerprint))) {
+                continue;
+            }
+            // Report each pair of new files only once.
+            if ((!fingerprintFiles.contains(pendingFile)) || (fingerprintFiles.indexOf(pendingFile) < fingerprintFiles.indexOf(file))) {
+                fingerprintDuplicates.push_back(tr("%1 already queued as %2").arg(describe(*fileFingerprint), describe(pendingFingerprint)));
+            }
+            if (xAudioFingerprinter::isHigherResolution(pendingFingerprint, *fileFingerprint)) {
+                fingerprintLowerResolutionFiles.push_back(file);
+            }
+        }
+    }
+}
+
+const QStringList& xAudioFileFingerprinting::getDuplicates() const {
+    return fingerprintDuplicates;
+}
+
+const QList<xAudioFile*>& xAudioFileFingerprinting::getLowerResolutionFiles() const {
+    return fingerprintLowerResolutionFiles;
 }
 
 
@@ -50,6 +252,11 @@ xAudioFile::xAudioFile():
         encodingTrackName(),
         encodingTag(),
         encodingTagId(-1),
+        encodingDisc(),
+        encodingYear(),
+        encodingCodec(),
+        encodingLoudness(),
+        encodingFingerprint(),
         jobId(0) {
 }
 
@@ -65,6 +272,11 @@ xAudioFile::xAudioFile(const QString& fileName, int audioTrackNr, const QString&
         encodingTrackName(trackName),
         encodingTag(tag),
         encodingTagId(tagId),
+        encodingDisc(),
+        encodingYear(),
+        encodingCodec(),
+        encodingLoudness(),
+        encodingFingerprint(),
         jobId(id) {
 }
 
@@ -78,6 +290,11 @@ xAudioFile::xAudioFile(const xAudioFile& copy):
         encodingTrackName(copy.encodingTrackName),
         encodingTag(copy.encodingTag),
         encodingTagId(copy.encodingTagId),
+        encodingDisc(copy.encodingDisc),
+        encodingYear(copy.encodingYear),
+        encodingCodec(copy.encodingCodec),
+        encodingLoudness(copy.encodingLoudness),
+        encodingFingerprint(copy.encodingFingerprint),
         jobId(copy.jobId) {
 }
 
@@ -91,6 +308,7 @@ void xAudioFile::remove() {
     } catch (std::filesystem::filesystem_error& e) {
         qWarning() << "Unable to audio file: " << inputFileName << ", error: " << e.what() << ", ignoring.";
     }
+    xTempSpace::tempSpace()->release(inputFileName);
 }
 
 const QString& xAudioFile::getFileName() const {
@@ -145,10 +363,306 @@ int xAudioFile::getTagId() const {
     return encodingTagId;
 }
 
+void xAudioFile::setDisc(const QString& disc) {
+    encodingDisc = disc;
+}
+
+const QString& xAudioFile::getDisc() const {
+    return encodingDisc;
+}
+
+void xAudioFile::setYear(const QString& year) {
+    encodingYear = year;
+}
+
+const QString& xAudioFile::getYear() const {
+    return encodingYear;
+}
+
+void xAudioFile::setCodec(const QString& codec) {
+    encodingCodec = codec;
+}
+
+const QString& xAudioFile::getCodec() const {
+    return encodingCodec;
+}
+
 quint64 xAudioFile::getJobId() const {
     return jobId;
 }
 
+const xAudioLoudness* xAudioFile::getLoudness() const {
+    return encodingLoudness.get();
+}
+
+const xAudioFingerprint* xAudioFile::getFingerprint() const {
+    return encodingFingerprint.get();
+}
+
+bool xAudioFile::tagReplayGain(const QString& flacFileName, double albumLoudness, double albumPeak) {
+    if ((!encodingLoudness) || (!encodingLoudness->isValid())) {
+        return false;
+    }
+    auto trackGain = xAudioLoudness::getReplayGain(encodingLoudness->getLoudness());
+    auto albumGain = xAudioLoudness::getReplayGain(albumLoudness);
+    QProcess tagProcess;
+    tagProcess.setProcessChannelMode(QProcess::MergedChannels);
+    tagProcess.start(xRipEncodeConfiguration::configuration()->getLLTag(), { {"--yes"},
+            { "--tag" }, QString("REPLAYGAIN_TRACK_GAIN=%1 dB").arg(trackGain, 0, 'f', 2),
+            { "--tag" }, QString("REPLAYGAIN_TRACK_PEAK=%1").arg(encodingLoudness->getTruePeak(), 0, 'f', 6),
+            { "--tag" }, QString("REPLAYGAIN_ALBUM_GAIN=%1 dB").arg(albumGain, 0, 'f', 2),
+            { "--tag" }, QString("REPLAYGAIN_ALBUM_PEAK=%1").arg(albumPeak, 0, 'f', 6),
+            flacFileName });
+    qDebug() << "xAudioFile::tagReplayGain: process arguments: " << tagProcess.arguments();
+    tagProcess.waitForFinished(-1);
+    if ((tagProcess.exitStatus() != QProcess::NormalExit) || (tagProcess.exitCode() != 0)) {
+        qCritical() << "xAudioFile::tagReplayGain: error: " << tagProcess.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool xAudioFile::verifyFlac(const QString& flacFileName) const {
+    // Decode the complete file. The decoder checks the samples against the STREAMINFO MD5.
+    QProcess verifyProcess;
+    verifyProcess.setProcessChannelMode(QProcess::MergedChannels);
+    verifyProcess.start(xRipEncodeConfiguration::configuration()->getFlac(), { {"-t"}, {"-s"}, flacFileName });
+    verifyProcess.waitForFinished(-1);
+    if ((verifyProcess.exitStatus() != QProcess::NormalExit) || (verifyProcess.exitCode() != 0)) {
+        qCritical() << "xAudioFile::verifyFlac: decoding failed: " << flacFileName << ": " << verifyProcess.readAll();
+        return false;
+    }
+    // The MD5 of 8 bit wav samples differs as they are unsigned.
+    if ((!encodingFingerprint) || (encodingFingerprint->bitsPerSample <= 8)) {
+        return true;
+    }
+    QFile flacFile(flacFileName);
+    if (!flacFile.open(QIODevice::ReadOnly)) {
+        qCritical() << "xAudioFile::verifyFlac: unable to open: " << flacFileName;
+        return false;
+    }
+    // Skip ID3v2 tags in front of the stream.
+    auto header = flacFile.read(10);
+    if ((header.size() == 10) && (header.startsWith("ID3"))) {
+        auto tagSize = ((header[6] & 0x7F) << 21) | ((header[7] & 0x7F) << 14) | ((header[8] & 0x7F) << 7) | (header[9] & 0x7F);
+        flacFile.seek(10+tagSize);
+    } else {
+        flacFile.seek(0);
+    }
+    // The STREAMINFO block is always the first metadata block.
+    auto streamInfo = flacFile.read(42);
+    if ((streamInfo.size() != 42) || (!streamInfo.startsWith("fLaC")) || ((streamInfo[4] & 0x7F) != 0)) {
+        qCritical() << "xAudioFile::verifyFlac: no STREAMINFO block: " << flacFileName;
+        return false;
+    }
+    auto info = reinterpret_cast<const uchar*>(streamInfo.constData())+8;
+    auto sampleRate = (info[10] << 12) | (info[11] << 4) | (info[12] >> 4);
+    auto channels = ((info[12] >> 1) & 0x07)+1;
+    auto bitsPerSample = (((info[12] & 0x01) << 4) | (info[13] >> 4))+1;
+    auto md5 = streamInfo.mid(8+18, 16);
+    if ((md5 == QByteArray(16, '\0')) || (sampleRate != encodingFingerprint->sampleRate) ||
+        (channels != encodingFingerprint->channels) || (bitsPerSample != encodingFingerprint->bitsPerSample)) {
+        qWarning() << "xAudioFile::verifyFlac: unable to compare with source samples: " << flacFileName;
+        return true;
+    }
+    if (md5 != encodingFingerprint->md5) {
+        qCritical() << "xAudioFile::verifyFlac: MD5 mismatch: " << flacFileName << ": " << md5.toHex()
+                    << ", source: " << encodingFingerprint->md5.toHex();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Read the given number of bytes. Wait for more data if the device is a process.
+ */
+static QByteArray xAudioFileRead(QIODevice* input, qint64 size) {
+    QByteArray data;
+    while (data.size() < size) {
+        if ((input->bytesAvailable() <= 0) && (!input->waitForReadyRead(-1))) {
+            break;
+        }
+        data.append(input->read(size-data.size()));
+    }
+    return data;
+}
+
+/**
+ * Read a wav stream and copy it to the output if given. The format callback is called for the
+ * fmt chunk and returns true if the samples are required. The samples callback is called with
+ * the raw PCM data and the converted float samples of complete frames.
+ */
+static bool xAudioFileReadWav(QIODevice* input, QIODevice* output,
+                              const std::function<bool(int,int,int,quint32)>& formatCallback,
+                              const std::function<void(const QByteArray&,const float*,int)>& samplesCallback) {
+    auto forward = [output](const QByteArray& data) {
+        if (output == nullptr) {
+            return true;
+        }
+        if (output->write(data) != data.size()) {
+            return false;
+        }
+        // Do not buffer more than one chunk for the encoder.
+        output->waitForBytesWritten(-1);
+        return true;
+    };
+    auto header = xAudioFileRead(input, 12);
+    if ((header.size() != 12) || (!header.startsWith("RIFF")) || (header.mid(8, 4) != "WAVE") || (!forward(header))) {
+        return false;
+    }
+    auto required = false;
+    int channels = 0;
+    int bytesPerSample = 0;
+    std::vector<float> samples;
+    while (true) {
+        auto chunkHeader = xAudioFileRead(input, 8);
+        if (chunkHeader.size() < 8) {
+            // End of the wav file.
+            break;
+        }
+        if (!forward(chunkHeader)) {
+            return false;
+        }
+        auto chunkSize = qFromLittleEndian<quint32>(chunkHeader.constData()+4);
+        // Chunks are padded to an even size.
+        auto remaining = static_cast<qint64>(chunkSize)+(chunkSize & 1);
+        if ((chunkHeader.startsWith("data")) && (required)) {
+            // Data chunks of unknown size extend to the end of the stream.
+            if ((chunkSize == 0) || (chunkSize == 0xFFFFFFFF)) {
+                remaining = std::numeric_limits<qint64>::max();
+            }
+            auto frameBytes = channels*bytesPerSample;
+            while (remaining > 0) {
+                auto data = xAudioFileRead(input, std::min<qint64>(remaining, frameBytes*4096));
+                if (data.isEmpty()) {
+                    break;
+                }
+                if (!forward(data)) {
+                    return false;
+                }
+                remaining -= data.size();
+                auto frames = data.size()/frameBytes;
+                samples.resize(static_cast<size_t>(frames*channels));
+                auto sample = reinterpret_cast<const uchar*>(data.constData());
+                for (auto& value : samples) {
+                    switch (bytesPerSample) {
+                        case 1:
+                            value = (static_cast<int>(sample[0])-128)/128.0f;
+                            break;
+                        case 2:
+                            value = qFromLittleEndian<qint16>(sample)/32768.0f;
+                            break;
+                        case 3:
+                            value = static_cast<float>(static_cast<qint32>((sample[0] << 8) | (sample[1] << 16) |
+                                                                           (static_cast<quint32>(sample[2]) << 24))/2147483648.0);
+                            break;
+                        default:
+                            value = static_cast<float>(qFromLittleEndian<qint32>(sample)/2147483648.0);
+                            break;
+                    }
+                    sample += bytesPerSample;
+                }
+                // The pad byte of the data chunk is not part of the samples.
+                samplesCallback(data.left(frames*frameBytes), samples.data(), frames);
+            }
+            if (remaining > 0) {
+                break;
+            }
+            continue;
+        }
+        if (chunkHeader.startsWith("fmt ")) {
+            auto format = xAudioFileRead(input, remaining);
+            if ((format.size() != remaining) || (!forward(format)) || (format.size() < 16)) {
+                return false;
+            }
+            auto formatTag = qFromLittleEndian<quint16>(format.constData());
+            channels = qFromLittleEndian<quint16>(format.constData()+2);
+            auto sampleRate = static_cast<int>(qFromLittleEndian<quint32>(format.constData()+4));
+            auto bitsPerSample = qFromLittleEndian<quint16>(format.constData()+14);
+            quint32 channelMask = 0;
+            // WAVE_FORMAT_EXTENSIBLE with PCM sub format.
+            if ((formatTag == 0xFFFE) && (format.size() >= 40)) {
+                channelMask = qFromLittleEndian<quint32>(format.constData()+20);
+                formatTag = qFromLittleEndian<quint16>(format.constData()+24);
+            }
+            bytesPerSample = bitsPerSample/8;
+            if ((formatTag == 1) && (channels > 0) && (sampleRate > 0) && (bytesPerSample >= 1) && (bytesPerSample <= 4)) {
+                required = formatCallback(channels, sampleRate, bitsPerSample, channelMask);
+            } else {
+                qWarning() << "xAudioFileReadWav: unsupported format: " << formatTag;
+            }
+            continue;
+        }
+        // Copy all other chunks.
+        while (remaining > 0) {
+            auto data = xAudioFileRead(input, std::min<qint64>(remaining, 65536));
+            if (data.isEmpty()) {
+                break;
+            }
+            if (!forward(data)) {
+                return false;
+            }
+            remaining -= data.size();
+        }
+        if (remaining > 0) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool xAudioFile::analyzeWav(QIODevice* input, QIODevice* output) {
+    encodingLoudness.reset();
+    std::shared_ptr<xAudioLoudness> loudness;
+    auto read = xAudioFileReadWav(input, output, [&loudness](int channels, int sampleRate, int bitsPerSample, quint32 channelMask) {
+        Q_UNUSED(bitsPerSample)
+        loudness = std::make_shared<xAudioLoudness>(channels, sampleRate, channelMask);
+        return true;
+    }, [&loudness](const QByteArray& data, const float* samples, int frames) {
+        Q_UNUSED(data)
+        loudness->process(samples, frames);
+    });
+    if (!read) {
+        qCritical() << "xAudioFile::analyzeWav: unable to read wav file: " << inputFileName;
+        return false;
+    }
+    encodingLoudness = loudness;
+    return true;
+}
+
+bool xAudioFile::fingerprintWav(QIODevice* input) {
+    encodingFingerprint.reset();
+    // Measure the loudness with the same read. The encoding does not need to read the samples again.
+    auto replayGain = xRipEncodeConfiguration::configuration()->getReplayGain();
+    std::unique_ptr<xAudioFingerprinter> fingerprinter;
+    std::shared_ptr<xAudioLoudness> loudness;
+    auto read = xAudioFileReadWav(input, nullptr, [&](int channels, int sampleRate, int bitsPerSample, quint32 channelMask) {
+        fingerprinter = std::make_unique<xAudioFingerprinter>(channels, sampleRate, bitsPerSample);
+        if (replayGain) {
+            loudness = std::make_shared<xAudioLoudness>(channels, sampleRate, channelMask);
+        }
+        return true;
+    }, [&](const QByteArray& data, const float* samples, int frames) {
+        fingerprinter->process(data, samples, frames);
+        if (loudness) {
+            loudness->process(samples, frames);
+        }
+    });
+    if ((!read) || (!fingerprinter)) {
+        qCritical() << "xAudioFile::fingerprintWav: unable to read wav file: " << inputFileName;
+        return false;
+    }
+    if (loudness) {
+        encodingLoudness = loudness;
+    }
+    encodingFingerprint = std::make_shared<xAudioFingerprint>(fingerprinter->result());
+    encodingFingerprint->artist = encodingArtist;
+    encodingFingerprint->album = encodingAlbum;
+    encodingFingerprint->trackName = encodingTrackName;
+    encodingFingerprint->jobId = jobId;
+    return true;
+}
+
 xAudioFileWav::xAudioFileWav():
         xAudioFile(),
         process(nullptr) {
@@ -211,15 +725,30 @@ bool xAudioFileWav::encodeFlac(const QString& flacFileName) {
     } catch (std::filesystem::filesystem_error& e) {
         // Ignore errors.
     }
-    // Encode file.
+    // Encode file. The wav file is piped into the encoder if the loudness is measured.
+    // The loudness is usually measured together with the fingerprint already.
+    auto replayGain = (xRipEncodeConfiguration::configuration()->getReplayGain()) && (!encodingLoudness);
+    auto analyzeFailed = false;
+    QStringList arguments { {"-8"}, {"-f"}, (replayGain) ? QString("-") : inputFileName,
+                            {"-o"}, flacFileName, { "--tag=ARTIST="+encodingArtist }, { "--tag=ALBUM="+encodingAlbum },
+                            { "--tag=TRACKNUMBER="+encodingTrackNr }, { "--tag=TITLE="+encodingTrackName } };
+    if (!encodingDisc.isEmpty()) {
+        arguments.push_back("--tag=DISCNUMBER="+encodingDisc);
+    }
     process = new QProcess();
     process->setProcessChannelMode(QProcess::MergedChannels);
-    process->start(xRipEncodeConfiguration::configuration()->getFlac(), { {"-8"}, {"-f"}, inputFileName,
-                                                                          {"-o"}, flacFileName, { "--tag=ARTIST="+encodingArtist }, { "--tag=ALBUM="+encodingAlbum },
-                                                                          { "--tag=TRACKNUMBER="+encodingTrackNr }, { "--tag=TITLE="+encodingTrackName } });
+    process->start(xRipEncodeConfiguration::configuration()->getFlac(), arguments);
     qDebug() << "xAudioFileWav::encodeFlac: process arguments: " << process->arguments();
+    if (replayGain) {
+        QFile inputFile(inputFileName);
+        if ((!inputFile.open(QIODevice::ReadOnly)) || (!analyzeWav(&inputFile, process))) {
+            analyzeFailed = true;
+            process->kill();
+        }
+        process->closeWriteChannel();
+    }
     process->waitForFinished(-1);
-    auto exitCode = process->exitCode();
+    auto exitCode = (analyzeFailed) ? -1 : process->exitCode();
     auto exitError = process->errorString();
     delete process;
     if (exitCode == QProcess::NormalExit) {
@@ -235,6 +764,15 @@ bool xAudioFileWav::encodeFlac(const QString& flacFileName) {
     }
 }
 
+bool xAudioFileWav::fingerprint() {
+    QFile inputFile(inputFileName);
+    if (!inputFile.open(QIODevice::ReadOnly)) {
+        qCritical() << "xAudioFileWav::fingerprint: unable to open: " << inputFileName;
+        return false;
+    }
+    return fingerprintWav(&inputFile);
+}
+
 xAudioFileFlac::xAudioFileFlac():
         xAudioFile(),
         process(nullptr) {
@@ -277,13 +815,26 @@ bool xAudioFileFlac::encodeFlac(const QString& flacFileName) {
         qCritical() << "Unable to copy file: " << inputFileName << "to" << flacFileName;
         return false;
     }
+    // Decode the file to measure the loudness unless measured together with the fingerprint.
+    if ((xRipEncodeConfiguration::configuration()->getReplayGain()) && (!encodingLoudness)) {
+        QProcess decodeProcess;
+        decodeProcess.start(xRipEncodeConfiguration::configuration()->getFlac(), { {"-d"}, {"-c"}, {"-s"}, inputFileName });
+        if (!analyzeWav(&decodeProcess, nullptr)) {
+            qWarning() << "xAudioFileFlac::encodeFlac: unable to measure loudness: " << inputFileName;
+            encodingLoudness.reset();
+        }
+        decodeProcess.waitForFinished(-1);
+    }
     // Tag the target file.
+    QStringList arguments { {"--yes"}, { "--ARTIST"}, encodingArtist, { "--ALBUM" }, encodingAlbum,
+                            { "--NUMBER"}, encodingTrackNr, { "--TITLE" }, encodingTrackName };
+    if (!encodingDisc.isEmpty()) {
+        arguments << "--tag" << "DISCNUMBER="+encodingDisc;
+    }
+    arguments.push_back(flacFileName);
     process = new QProcess();
     process->setProcessChannelMode(QProcess::MergedChannels);
-    process->start(xRipEncodeConfiguration::configuration()->getLLTag(), { {"--yes"},
-                                                                          { "--ARTIST"}, encodingArtist, { "--ALBUM" }, encodingAlbum,
-                                                                          { "--NUMBER"}, encodingTrackNr, { "--TITLE" }, encodingTrackName,
-                                                                          flacFileName });
+    process->start(xRipEncodeConfiguration::configuration()->getLLTag(), arguments);
     qDebug() << "xAudioFileFlac::encodeFlac: process arguments: " << process->arguments();
     process->waitForFinished(-1);
     auto exitCode = process->exitCode();
@@ -302,4 +853,11 @@ bool xAudioFileFlac::encodeFlac(const QString& flacFileName) {
     }
 }
 
-
+bool xAudioFileFlac::fingerprint() {
+    // Decode the file to compute the fingerprint.
+    QProcess decodeProcess;
+    decodeProcess.start(xRipEncodeConfiguration::configuration()->getFlac(), { {"-d"}, {"-c"}, {"-s"}, inputFileName });
+    auto fingerprinted = fingerprintWav(&decodeProcess);
+    decodeProcess.waitForFinished(-1);
+    return fingerprinted;
+}
@@ -19,8 +19,15 @@
 #include <QObject>
 #include <QProcess>
 #include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QStringList>
+#include <memory>
+
+#include "xAudioFingerprint.h"
 
 class xAudioFile;
+class xAudioLoudness;
 
 class xAudioFileEncoding:public QThread {
     Q_OBJECT
@@ -39,6 +46,12 @@ public:
      * Encode all files in the queue in a separate thread.
      */
     void run() override;
+    /**
+     * Get the tracks that failed to encode or verify. Call after the thread finished.
+     *
+     * @return the track numbers (starting with 1) of the failed tracks.
+     */
+    [[nodiscard]] const QList<int>& getFailed() const;
 
 signals:
     /**
@@ -48,10 +61,132 @@ signals:
      * @param progress the encoding progress for the current track.
      */
     void encodingProgress(int track, int progress);
+    /**
+     * Signal emitted after an encoded flac file is verified.
+     *
+     * @param track the number of the track verified.
+     * @param passed true if the verification passed, false otherwise.
+     */
+    void encodingVerified(int track, bool passed);
+    /**
+     * Signal the output of the encoding.
+     *
+     * @param msg the current output as string.
+     */
+    void messages(const QString& msg);
 
 private:
+    /**
+     * Record a failed track and report it on the console.
+     *
+     * @param track the number of the failed track (starting with 1).
+     * @param reason the step that failed.
+     */
+    void failed(int track, const QString& reason);
+
     QList<std::pair<xAudioFile*,QString>> encodeFiles;
     bool encodeFlac;
+    // Verification results are reported by the verification workers.
+    QMutex encodeFailedLock;
+    QList<int> encodeFailed;
+};
+
+class xAudioFileFingerprinting:public QThread {
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param files list of audio file objects.
+     * @param index the fingerprints of the already encoded tracks.
+     * @param pending the fingerprints of the other pending tracks.
+     * @param parent pointer to the parent object.
+     */
+    xAudioFileFingerprinting(const QList<xAudioFile*>& files, const xAudioFingerprintIndex& index,
+                             const QList<std::pair<xAudioFile*,xAudioFingerprint>>& pending, QObject* parent=nullptr);
+    ~xAudioFileFingerprinting() override = default;
+    /**
+     * Compute the fingerprints of all files and compare them against the index
+     * and the pending tracks in a separate thread.
+     */
+    void run() override;
+    /**
+     * Get the duplicates found.
+     *
+     * @return the description of each duplicate as list of strings.
+     */
+    [[nodiscard]] const QStringList& getDuplicates() const;
+    /**
+     * Get the files with a duplicate of higher resolution.
+     *
+     * @return the list of audio file objects, a file may be contained several times.
+     */
+    [[nodiscard]] const QList<xAudioFile*>& getLowerResolutionFiles() const;
+
+private:
+    QList<xAudioFile*> fingerprintFiles;
+    xAudioFingerprintIndex fingerprintIndex;
+    QList<std::pair<xAudioFile*,xAudioFingerprint>> fingerprintPending;
+    QStringList fingerprintDuplicates;
+    QList<xAudioFile*> fingerprintLowerResolutionFiles;
+};
+
+class xAudioFileVerification:public QThread {
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param parent pointer to the parent object.
+     */
+    explicit xAudioFileVerification(QObject* parent=nullptr);
+    ~xAudioFileVerification() override = default;
+    /**
+     * Queue an encoded flac file for verification. Thread safe.
+     *
+     * @param track the number of the track.
+     * @param file pointer to the audio file object the flac file was encoded from.
+     * @param flacFileName the name of the encoded flac file.
+     */
+    void add(int track, xAudioFile* file, const QString& flacFileName);
+    /**
+     * Indicate that no more files are queued. The thread finishes after all
+     * queued files are verified.
+     */
+    void close();
+    /**
+     * Verify the queued files using one worker thread per CPU core.
+     */
+    void run() override;
+
+signals:
+    /**
+     * Signal emitted for each verified track. The flac file of a track
+     * that failed the verification is removed.
+     *
+     * @param track the number of the track.
+     * @param passed true if the verification passed, false otherwise.
+     */
+    void verified(int track, bool passed);
+
+private:
+    /**
+     * Verify queued files until the queue is closed and empty.
+     */
+    void verifyQueued();
+
+    typedef struct {
+        int track;
+        xAudioFile* file;
+        QString flacFileName;
+    } xAudioFileVerificationEntry;
+
+    QMutex verifyLock;
+    QWaitCondition verifyCondition;
+    QList<xAudioFileVerificationEntry> verifyQueue;
+    bool verifyClosed;
 };
 
 
@@ -168,6 +303,42 @@ public:
      * @return the tag ID as integer.
      */
     [[nodiscard]] int getTagId() const;
+    /**
+     * Set the disc number.
+     *
+     * @param disc the disc number as string.
+     */
+    void setDisc(const QString& disc);
+    /**
+     * Get the disc number.
+     *
+     * @return the disc number as string, empty if not set.
+     */
+    [[nodiscard]] const QString& getDisc() const;
+    /**
+     * Set the release year.
+     *
+     * @param year the year as string.
+     */
+    void setYear(const QString& year);
+    /**
+     * Get the release year.
+     *
+     * @return the year as string, empty if not set.
+     */
+    [[nodiscard]] const QString& getYear() const;
+    /**
+     * Set the codec of the source.
+     *
+     * @param codec the codec name as string.
+     */
+    void setCodec(const QString& codec);
+    /**
+     * Get the codec of the source.
+     *
+     * @return the codec name as string, empty if not set.
+     */
+    [[nodiscard]] const QString& getCodec() const;
     /**
      * Get the job ID the audio file belongs to.
      *
@@ -189,7 +360,42 @@ public:
      */
     virtual bool encodeFlac(const QString& flacFileName) = 0;
     /**
-     * Remove the file attached to the object.
+     * Get the loudness measured during the last flac encoding.
+     *
+     * @return pointer to the loudness measurement, nullptr if not available.
+     */
+    [[nodiscard]] const xAudioLoudness* getLoudness() const;
+    /**
+     * Add the ReplayGain 2.0 tags to the encoded flac file. Only the metadata is updated.
+     *
+     * @param flacFileName the name of the encoded flac file.
+     * @param albumLoudness the integrated loudness of the album in LUFS.
+     * @param albumPeak the true peak of the album.
+     * @return true, if the tags were added, false otherwise.
+     */
+    bool tagReplayGain(const QString& flacFileName, double albumLoudness, double albumPeak);
+    /**
+     * Compute the fingerprint and the MD5 of the samples of the audio file.
+     *
+     * @return true, if the fingerprint was computed, false otherwise.
+     */
+    virtual bool fingerprint() = 0;
+    /**
+     * Get the fingerprint computed by the last call of fingerprint.
+     *
+     * @return pointer to the fingerprint, nullptr if not available.
+     */
+    [[nodiscard]] const xAudioFingerprint* getFingerprint() const;
+    /**
+     * Decode the flac file and check it against the STREAMINFO MD5. If the fingerprint
+     * is available then the STREAMINFO MD5 is compared with the MD5 of the source samples.
+     *
+     * @param flacFileName the name of the flac file.
+     * @return true, if the verification passed, false otherwise.
+     */
+    [[nodiscard]] bool verifyFlac(const QString& flacFileName) const;
+    /**
+     * Remove the file attached to the object and release its temp space.
      */
     void remove();
 
@@ -203,6 +409,23 @@ signals:
     void encodingProgress(int track, int progress);
 
 protected:
+    /**
+     * Read a wav stream and measure its loudness.
+     *
+     * @param input the device the wav stream is read from.
+     * @param output the device the wav stream is copied to, nullptr if not required.
+     * @return true, if the stream was read and copied, false otherwise.
+     */
+    bool analyzeWav(QIODevice* input, QIODevice* output);
+    /**
+     * Read a wav stream and compute its fingerprint. The loudness is measured
+     * with the same read if ReplayGain is enabled.
+     *
+     * @param input the device the wav stream is read from.
+     * @return true, if the stream was read, false otherwise.
+     */
+    bool fingerprintWav(QIODevice* input);
+
     QString inputFileName;
     int inputAudioTrackNr;
     QString encodingArtist;
@@ -211,6 +434,11 @@ protected:
     QString encodingTrackName;
     QString encodingTag;
     int encodingTagId;
+    QString encodingDisc;
+    QString encodingYear;
+    QString encodingCodec;
+    std::shared_ptr<xAudioLoudness> encodingLoudness;
+    std::shared_ptr<xAudioFingerprint> encodingFingerprint;
     quint64 jobId;
 };
 
@@ -258,6 +486,12 @@ public:
      * @return true, if the encoding process was successful, false otherwise.
      */
     bool encodeFlac(const QString& flacFileName) override;
+    /**
+     * Compute the fingerprint and the MD5 of the samples of the audio file.
+     *
+     * @return true, if the fingerprint was computed, false otherwise.
+     */
+    bool fingerprint() override;
 
 private:
     QProcess* process;
@@ -308,6 +542,12 @@ public:
      * @return true, if the encoding process was successful, false otherwise.
      */
     bool encodeFlac(const QString& flacFileName) override;
+    /**
+     * Compute the fingerprint and the MD5 of the samples of the audio file.
+     *
+     * @return true, if the fingerprint was computed, false otherwise.
+     */
+    bool fingerprint() override;
 
 private:
     QProcess* process;
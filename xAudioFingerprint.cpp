@@ -0,0 +1,222 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "xAudioFingerprint.h"
+
+#include <QStandardPaths>
+#include <QDataStream>
+#include <QFile>
+#include <QDir>
+#include <QDebug>
+#include <algorithm>
+#include <numeric>
+#include <bitset>
+#include <cmath>
+
+// Frames of 100ms are evaluated every 25ms. Each frame consists of four segments.
+const int xAudioFingerprint_SegmentsPerSecond { 40 };
+const int xAudioFingerprint_FrameSegments { 4 };
+// Maximum offset between two fingerprints in segments (2s).
+const int xAudioFingerprint_MaxOffset { 80 };
+// Minimum number of compared bits (3s) and the maximum bit error rate of duplicates.
+const int xAudioFingerprint_MinBits { 120 };
+const double xAudioFingerprint_MaxErrorRate { 0.2 };
+// Maximum difference of the length of duplicates relative to the length.
+const double xAudioFingerprint_MaxLengthDifference { 0.02 };
+// Index files of any other version are ignored.
+const quint32 xAudioFingerprint_IndexVersion { 2 };
+
+/**
+ * Return the 32 bits of the fingerprint starting at the given position. Bits beyond the end are zero.
+ */
+static quint32 xAudioFingerprintWord(const QVector<quint32>& bits, int position) {
+    auto index = position/32;
+    auto shift = position%32;
+    auto word = (index < bits.count()) ? bits[index] >> shift : 0u;
+    if ((shift > 0) && (index+1 < bits.count())) {
+        word |= bits[index+1] << (32-shift);
+    }
+    return word;
+}
+
+xAudioFingerprinter::xAudioFingerprinter(int channels, int sampleRate, int bitsPerSample):
+        channels(channels),
+        sampleRate(sampleRate),
+        bitsPerSample(bitsPerSample),
+        sampleCount(0),
+        segmentStart(0),
+        segmentEnd(std::max(sampleRate/xAudioFingerprint_SegmentsPerSecond, 1)),
+        segmentEnergy(0.0),
+        md5(QCryptographicHash::Md5) {
+}
+
+void xAudioFingerprinter::process(const QByteArray& data, const float* samples, int frames) {
+    md5.addData(data);
+    for (auto i = 0; i < frames; ++i) {
+        // The energy of the mono signal.
+        double sample = 0.0;
+        for (auto c = 0; c < channels; ++c) {
+            sample += samples[i*channels+c];
+        }
+        sample /= channels;
+        segmentEnergy += sample*sample;
+        if (++sampleCount >= segmentEnd) {
+            energies.push_back(segmentEnergy/static_cast<double>(segmentEnd-segmentStart));
+            segmentEnergy = 0.0;
+            segmentStart = segmentEnd;
+            // End of the next segment. Integer arithmetic keeps the boundaries exact.
+            segmentEnd = std::max(static_cast<qint64>(energies.size()+1)*sampleRate/xAudioFingerprint_SegmentsPerSecond,
+                                  segmentStart+1);
+        }
+    }
+}
+
+xAudioFingerprint xAudioFingerprinter::result() {
+    xAudioFingerprint fingerprint;
+    fingerprint.md5 = md5.result();
+    // Energy of the frames starting at each segment.
+    std::vector<double> frames;
+    for (size_t i = 0; i+xAudioFingerprint_FrameSegments <= energies.size(); ++i) {
+        frames.push_back(std::accumulate(energies.begin()+i, energies.begin()+i+xAudioFingerprint_FrameSegments, 0.0));
+    }
+    // Compare each frame with the following adjacent frame. The overlapping frames make
+    // the fingerprint robust against offsets that are not a multiple of the segment size.
+    fingerprint.frames = std::max(static_cast<int>(frames.size())-xAudioFingerprint_FrameSegments, 0);
+    fingerprint.sampleRate = sampleRate;
+    fingerprint.bitsPerSample = bitsPerSample;
+    fingerprint.channels = channels;
+    fingerprint.jobId = 0;
+    fingerprint.bits.fill(0, (fingerprint.frames+31)/32);
+    for (auto i = 0; i < fingerprint.frames; ++i) {
+        if (frames[i+xAudioFingerprint_FrameSegments] > frames[i]) {
+            fingerprint.bits[i/32] |= 1u << (i%32);
+        }
+    }
+    return fingerprint;
+}
+
+bool xAudioFingerprinter::isDuplicate(const xAudioFingerprint& first, const xAudioFingerprint& second) {
+    if ((!first.md5.isEmpty()) && (first.md5 == second.md5)) {
+        return true;
+    }
+    auto length = std::max(first.frames, second.frames);
+    if ((length == 0) || (std::abs(first.frames-second.frames) > length*xAudioFingerprint_MaxLengthDifference+1)) {
+        return false;
+    }
+    // Search for the best alignment of both fingerprints.
+    for (auto offset = -xAudioFingerprint_MaxOffset; offset <= xAudioFingerprint_MaxOffset; ++offset) {
+        auto start = std::max(0, -offset);
+        auto end = std::min(first.frames, second.frames-offset);
+        if (end-start < xAudioFingerprint_MinBits) {
+            continue;
+        }
+        // Compare 32 bits at once. Stop as soon as too many bits differ.
+        auto maxErrors = (end-start)*xAudioFingerprint_MaxErrorRate;
+        auto errors = 0;
+        for (auto i = start; (i < end) && (errors < maxErrors); i += 32) {
+            auto difference = xAudioFingerprintWord(first.bits, i) ^ xAudioFingerprintWord(second.bits, i+offset);
+            if (end-i < 32) {
+                difference &= (1u << (end-i))-1;
+            }
+            errors += static_cast<int>(std::bitset<32>(difference).count());
+        }
+        if (errors < maxErrors) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool xAudioFingerprinter::isHigherResolution(const xAudioFingerprint& first, const xAudioFingerprint& second) {
+    auto firstResolution = static_cast<qint64>(first.sampleRate)*first.bitsPerSample;
+    auto secondResolution = static_cast<qint64>(second.sampleRate)*second.bitsPerSample;
+    if (firstResolution != secondResolution) {
+        return firstResolution > secondResolution;
+    }
+    return first.channels > second.channels;
+}
+
+xAudioFingerprintIndex::xAudioFingerprintIndex():
+        fingerprints() {
+}
+
+void xAudioFingerprintIndex::load() {
+    fingerprints.clear();
+    QFile indexFile(indexFileName());
+    if (!indexFile.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream indexStream(&indexFile);
+    quint32 indexVersion;
+    qint32 entries;
+    indexStream >> indexVersion >> entries;
+    if (indexVersion != xAudioFingerprint_IndexVersion) {
+        return;
+    }
+    for (auto i = 0; (i < entries) && (indexStream.status() == QDataStream::Ok); ++i) {
+        xAudioFingerprint fingerprint;
+        indexStream >> fingerprint.md5 >> fingerprint.bits >> fingerprint.frames >> fingerprint.sampleRate
+                    >> fingerprint.bitsPerSample >> fingerprint.channels >> fingerprint.artist >> fingerprint.album
+                    >> fingerprint.trackName >> fingerprint.jobId;
+        fingerprints.push_back(fingerprint);
+    }
+    if (indexStream.status() != QDataStream::Ok) {
+        qCritical() << "xAudioFingerprintIndex: corrupt index file: " << indexFile.fileName();
+        fingerprints.clear();
+    }
+}
+
+void xAudioFingerprintIndex::save() {
+    QFile indexFile(indexFileName());
+    if (!indexFile.open(QIODevice::WriteOnly)) {
+        qCritical() << "xAudioFingerprintIndex: unable to write index file: " << indexFile.fileName();
+        return;
+    }
+    QDataStream indexStream(&indexFile);
+    indexStream << xAudioFingerprint_IndexVersion << static_cast<qint32>(fingerprints.count());
+    for (const auto& fingerprint : fingerprints) {
+        indexStream << fingerprint.md5 << fingerprint.bits << fingerprint.frames << fingerprint.sampleRate
+                    << fingerprint.bitsPerSample << fingerprint.channels << fingerprint.artist << fingerprint.album
+                    << fingerprint.trackName << fingerprint.jobId;
+    }
+}
+
+void xAudioFingerprintIndex::add(const xAudioFingerprint& fingerprint) {
+    for (const auto& entry : fingerprints) {
+        if ((entry.md5 == fingerprint.md5) && (entry.sampleRate == fingerprint.sampleRate) &&
+            (entry.bitsPerSample == fingerprint.bitsPerSample) && (entry.channels == fingerprint.channels)) {
+            return;
+        }
+    }
+    fingerprints.push_back(fingerprint);
+}
+
+QList<xAudioFingerprint> xAudioFingerprintIndex::find(const xAudioFingerprint& fingerprint) const {
+    QList<xAudioFingerprint> duplicates;
+    for (const auto& entry : fingerprints) {
+        if (xAudioFingerprinter::isDuplicate(entry, fingerprint)) {
+            duplicates.push_back(entry);
+        }
+    }
+    return duplicates;
+}
+
+QString xAudioFingerprintIndex::indexFileName() {
+    QDir cacheDirectory(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)+"/xRipEncode");
+    if (!cacheDirectory.mkpath(".")) {
+        qCritical() << "xAudioFingerprintIndex: unable to create cache directory: " << cacheDirectory.path();
+        return QString();
+    }
+    return cacheDirectory.absoluteFilePath("fingerprints");
+}
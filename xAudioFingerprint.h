@@ -0,0 +1,149 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __XAUDIOFINGERPRINT_H__
+#define __XAUDIOFINGERPRINT_H__
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <vector>
+
+/**
+ * Fingerprint of a track. The bits represent the rise or fall of the energy
+ * of adjacent 100ms frames of the mono signal evaluated every 25ms. They do
+ * not depend on the sample rate, bits per sample or level of the track.
+ */
+struct xAudioFingerprint {
+    QByteArray md5;
+    QVector<quint32> bits;
+    int frames;
+    int sampleRate;
+    int bitsPerSample;
+    int channels;
+    QString artist;
+    QString album;
+    QString trackName;
+    quint64 jobId;
+};
+
+/**
+ * @class xAudioFingerprinter
+ *
+ * @note Compute the fingerprint and the MD5 of the PCM samples of a track.
+ * The MD5 is computed over the little endian samples as for the flac
+ * STREAMINFO block.
+ */
+class xAudioFingerprinter {
+public:
+    /**
+     * Constructor
+     *
+     * @param channels number of channels.
+     * @param sampleRate the sample rate in Hz.
+     * @param bitsPerSample bits per sample.
+     */
+    xAudioFingerprinter(int channels, int sampleRate, int bitsPerSample);
+    ~xAudioFingerprinter() = default;
+    /**
+     * Add the given samples.
+     *
+     * @param data the raw interleaved PCM samples.
+     * @param samples the interleaved samples in the range [-1, 1].
+     * @param frames number of samples per channel.
+     */
+    void process(const QByteArray& data, const float* samples, int frames);
+    /**
+     * Return the fingerprint of all samples added.
+     *
+     * @return the fingerprint without track information.
+     */
+    [[nodiscard]] xAudioFingerprint result();
+    /**
+     * Compare two fingerprints.
+     *
+     * @param first the first fingerprint.
+     * @param second the second fingerprint.
+     * @return true if both fingerprints belong to the same recording, false otherwise.
+     */
+    [[nodiscard]] static bool isDuplicate(const xAudioFingerprint& first, const xAudioFingerprint& second);
+    /**
+     * Compare the resolution of two fingerprints.
+     *
+     * @param first the first fingerprint.
+     * @param second the second fingerprint.
+     * @return true if the first has a higher resolution than the second, false otherwise.
+     */
+    [[nodiscard]] static bool isHigherResolution(const xAudioFingerprint& first, const xAudioFingerprint& second);
+
+private:
+    int channels;
+    int sampleRate;
+    int bitsPerSample;
+    // The segments end at fractional positions (sampleRate/40). The boundaries are computed
+    // from the segment index to avoid drift for sample rates not divisible by 40.
+    qint64 sampleCount;
+    qint64 segmentStart;
+    qint64 segmentEnd;
+    double segmentEnergy;
+    std::vector<double> energies;
+    QCryptographicHash md5;
+};
+
+/**
+ * @class xAudioFingerprintIndex
+ *
+ * @note Local index of the fingerprints of all encoded tracks. The index is
+ * stored in the cache directory.
+ */
+class xAudioFingerprintIndex {
+public:
+    xAudioFingerprintIndex();
+    ~xAudioFingerprintIndex() = default;
+    /**
+     * Read the index from the cache directory.
+     */
+    void load();
+    /**
+     * Write the index to the cache directory.
+     */
+    void save();
+    /**
+     * Add the fingerprint to the index. Identical entries are not added twice.
+     *
+     * @param fingerprint the fingerprint of the encoded track.
+     */
+    void add(const xAudioFingerprint& fingerprint);
+    /**
+     * Find all duplicates of the given fingerprint.
+     *
+     * @param fingerprint the fingerprint to look for.
+     * @return the list of matching fingerprints in the index.
+     */
+    [[nodiscard]] QList<xAudioFingerprint> find(const xAudioFingerprint& fingerprint) const;
+
+private:
+    /**
+     * Determine the index file.
+     *
+     * @return the path to the index file as string, empty on error.
+     */
+    [[nodiscard]] static QString indexFileName();
+
+    QList<xAudioFingerprint> fingerprints;
+};
+
+#endif
@@ -0,0 +1,270 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "xAudioLoudness.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define xAudioLoudness_X86
+#include <immintrin.h>
+#endif
+
+// Gates and reference of the integrated loudness.
+const double xAudioLoudness_AbsoluteGate { -70.0 };
+const double xAudioLoudness_RelativeGate { -10.0 };
+const double xAudioLoudness_ReplayGainReference { -18.0 };
+// Taps of each phase of the true peak filter.
+const int xAudioLoudness_TruePeakTaps { 12 };
+// Number of phases stored for each tap. Unused phases are zero.
+const int xAudioLoudness_TruePeakLanes { 4 };
+// Default wav speaker positions for 1 to 8 channels.
+const quint32 xAudioLoudness_DefaultMasks[] { 0x4, 0x3, 0x7, 0x33, 0x37, 0x3F, 0x13F, 0x63F };
+
+/**
+ * Loudness of the given mean square energy.
+ */
+static double xAudioLoudnessLUFS(double energy) {
+    return (energy > 0.0) ? -0.691+10.0*std::log10(energy) : -std::numeric_limits<double>::infinity();
+}
+
+/**
+ * Integrated loudness of the given block energies using the absolute and relative gate.
+ */
+static double xAudioLoudnessGated(const std::vector<const std::vector<double>*>& blockLists) {
+    double sum = 0.0;
+    size_t count = 0;
+    for (const auto& blocks : blockLists) {
+        for (const auto& block : *blocks) {
+            if (xAudioLoudnessLUFS(block) > xAudioLoudness_AbsoluteGate) {
+                sum += block;
+                ++count;
+            }
+        }
+    }
+    if (count == 0) {
+        return xAudioLoudness_AbsoluteGate;
+    }
+    auto relativeGate = xAudioLoudnessLUFS(sum/count)+xAudioLoudness_RelativeGate;
+    sum = 0.0;
+    count = 0;
+    for (const auto& blocks : blockLists) {
+        for (const auto& block : *blocks) {
+            auto loudness = xAudioLoudnessLUFS(block);
+            if ((loudness > xAudioLoudness_AbsoluteGate) && (loudness > relativeGate)) {
+                sum += block;
+                ++count;
+            }
+        }
+    }
+    return (count > 0) ? xAudioLoudnessLUFS(sum/count) : xAudioLoudness_AbsoluteGate;
+}
+
+/**
+ * Scalar true peak kernel. Return the maximum of all oversampled samples.
+ */
+static float xAudioLoudnessKernelScalar(const float* history, const float* coefficients, int taps, int samples) {
+    float peak = 0.0f;
+    for (auto n = 0; n < samples; ++n) {
+        float phases[xAudioLoudness_TruePeakLanes] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (auto t = 0; t < taps; ++t) {
+            for (auto p = 0; p < xAudioLoudness_TruePeakLanes; ++p) {
+                phases[p] += coefficients[t*xAudioLoudness_TruePeakLanes+p]*history[n+t];
+            }
+        }
+        for (auto p = 0; p < xAudioLoudness_TruePeakLanes; ++p) {
+            peak = std::max(peak, std::abs(phases[p]));
+        }
+    }
+    return peak;
+}
+
+#ifdef xAudioLoudness_X86
+__attribute__((target("sse")))
+static float xAudioLoudnessKernelSSE(const float* history, const float* coefficients, int taps, int samples) {
+    // Clear the sign bit for the absolute value.
+    auto mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    auto peak = _mm_setzero_ps();
+    for (auto n = 0; n < samples; ++n) {
+        // All four phases of one input sample are computed in parallel.
+        auto phases = _mm_setzero_ps();
+        for (auto t = 0; t < taps; ++t) {
+            phases = _mm_add_ps(phases, _mm_mul_ps(_mm_loadu_ps(coefficients+t*xAudioLoudness_TruePeakLanes),
+                                                   _mm_set1_ps(history[n+t])));
+        }
+        peak = _mm_max_ps(peak, _mm_and_ps(phases, mask));
+    }
+    float peaks[xAudioLoudness_TruePeakLanes];
+    _mm_storeu_ps(peaks, peak);
+    return *std::max_element(peaks, peaks+xAudioLoudness_TruePeakLanes);
+}
+#endif
+
+xAudioLoudness::xAudioLoudness(int channels, int sampleRate, quint32 channelMask):
+        channels(channels),
+        segmentSize(std::max(static_cast<int>(std::lround(sampleRate*0.1)), 1)),
+        segmentPosition(0),
+        weights(static_cast<size_t>(channels), 1.0),
+        filterState(static_cast<size_t>(channels*4), 0.0),
+        segmentEnergy(0.0),
+        truePeakFactor((sampleRate < 96000) ? 4 : ((sampleRate < 192000) ? 2 : 1)),
+        truePeakTaps(xAudioLoudness_TruePeakTaps),
+        truePeakHistory(static_cast<size_t>(channels)),
+        truePeakKernel(xAudioLoudnessKernelScalar),
+        truePeak(0.0f) {
+    // Channel weights. LFE is ignored and surround channels are weighted with +1.5dB.
+    if ((channelMask == 0) && (channels >= 1) && (channels <= 8)) {
+        channelMask = xAudioLoudness_DefaultMasks[channels-1];
+    }
+    for (auto c = 0, bit = 0; (c < channels) && (bit < 32); ++bit) {
+        if (channelMask & (1u << bit)) {
+            switch (1u << bit) {
+                case 0x8:
+                    weights[c] = 0.0;
+                    break;
+                case 0x10:
+                case 0x20:
+                case 0x200:
+                case 0x400:
+                    weights[c] = 1.41;
+                    break;
+                default:
+                    break;
+            }
+            ++c;
+        }
+    }
+    // K-weighting: high shelf followed by a high pass (ITU-R BS.1770-4 for any sample rate).
+    auto k = std::tan(M_PI*1681.974450955533/sampleRate);
+    auto vh = std::pow(10.0, 3.999843853973347/20.0);
+    auto vb = std::pow(vh, 0.4996667741545416);
+    auto q = 0.7071752369554196;
+    auto a0 = 1.0+k/q+k*k;
+    filterB[0][0] = (vh+vb*k/q+k*k)/a0;
+    filterB[0][1] = 2.0*(k*k-vh)/a0;
+    filterB[0][2] = (vh-vb*k/q+k*k)/a0;
+    filterA[0][0] = 1.0;
+    filterA[0][1] = 2.0*(k*k-1.0)/a0;
+    filterA[0][2] = (1.0-k/q+k*k)/a0;
+    k = std::tan(M_PI*38.13547087602444/sampleRate);
+    q = 0.5003270373238773;
+    a0 = 1.0+k/q+k*k;
+    filterB[1][0] = 1.0;
+    filterB[1][1] = -2.0;
+    filterB[1][2] = 1.0;
+    filterA[1][0] = 1.0;
+    filterA[1][1] = 2.0*(k*k-1.0)/a0;
+    filterA[1][2] = (1.0-k/q+k*k)/a0;
+    // Interpolation filter for the true peak, Hann windowed sinc.
+    auto length = truePeakFactor*truePeakTaps;
+    truePeakCoefficients.assign(static_cast<size_t>(truePeakTaps*xAudioLoudness_TruePeakLanes), 0.0f);
+    for (auto p = 0; p < truePeakFactor; ++p) {
+        for (auto t = 0; t < truePeakTaps; ++t) {
+            auto i = p+t*truePeakFactor;
+            auto x = (i-(length-1)/2.0)/truePeakFactor;
+            auto sinc = (std::abs(x) < 1e-9) ? 1.0 : std::sin(M_PI*x)/(M_PI*x);
+            auto window = 0.5*(1.0-std::cos(2.0*M_PI*(i+0.5)/length));
+            truePeakCoefficients[(truePeakTaps-1-t)*xAudioLoudness_TruePeakLanes+p] = static_cast<float>(sinc*window);
+        }
+    }
+    for (auto& history : truePeakHistory) {
+        history.assign(static_cast<size_t>(truePeakTaps-1), 0.0f);
+    }
+#ifdef xAudioLoudness_X86
+    if (__builtin_cpu_supports("sse")) {
+        truePeakKernel = xAudioLoudnessKernelSSE;
+    }
+#endif
+}
+
+void xAudioLoudness::process(const float* samples, int frames) {
+    for (auto c = 0; c < channels; ++c) {
+        auto& history = truePeakHistory[c];
+        for (auto i = 0; i < frames; ++i) {
+            history.push_back(samples[i*channels+c]);
+        }
+        processTruePeak(c);
+    }
+    for (auto i = 0; i < frames; ++i) {
+        for (auto c = 0; c < channels; ++c) {
+            auto state = filterState.data()+c*4;
+            // Direct form II transposed.
+            double x = samples[i*channels+c];
+            auto y = filterB[0][0]*x+state[0];
+            state[0] = filterB[0][1]*x-filterA[0][1]*y+state[1];
+            state[1] = filterB[0][2]*x-filterA[0][2]*y;
+            x = y;
+            y = filterB[1][0]*x+state[2];
+            state[2] = filterB[1][1]*x-filterA[1][1]*y+state[3];
+            state[3] = filterB[1][2]*x-filterA[1][2]*y;
+            segmentEnergy += weights[c]*y*y;
+        }
+        if (++segmentPosition >= segmentSize) {
+            // Blocks of 400ms overlap by 75%.
+            segments.push_back(segmentEnergy/segmentSize);
+            if (segments.size() > 4) {
+                segments.erase(segments.begin());
+            }
+            if (segments.size() == 4) {
+                blocks.push_back((segments[0]+segments[1]+segments[2]+segments[3])/4.0);
+            }
+            segmentEnergy = 0.0;
+            segmentPosition = 0;
+        }
+    }
+}
+
+double xAudioLoudness::getLoudness() const {
+    return xAudioLoudnessGated({ &blocks });
+}
+
+bool xAudioLoudness::isValid() const {
+    return std::any_of(blocks.begin(), blocks.end(), [](double block) {
+        return xAudioLoudnessLUFS(block) > xAudioLoudness_AbsoluteGate;
+    });
+}
+
+double xAudioLoudness::getTruePeak() const {
+    return truePeak;
+}
+
+double xAudioLoudness::getLoudness(const QList<const xAudioLoudness*>& measurements) {
+    std::vector<const std::vector<double>*> blockLists;
+    for (const auto& measurement : measurements) {
+        blockLists.push_back(&measurement->blocks);
+    }
+    return xAudioLoudnessGated(blockLists);
+}
+
+double xAudioLoudness::getReplayGain(double loudness) {
+    return xAudioLoudness_ReplayGainReference-loudness;
+}
+
+void xAudioLoudness::processTruePeak(int channel) {
+    auto& history = truePeakHistory[channel];
+    auto samples = static_cast<int>(history.size())-(truePeakTaps-1);
+    if (samples <= 0) {
+        return;
+    }
+    if (truePeakFactor > 1) {
+        truePeak = std::max(truePeak, truePeakKernel(history.data(), truePeakCoefficients.data(), truePeakTaps, samples));
+    }
+    // The sample peak is the lower bound of the true peak.
+    for (auto i = truePeakTaps-1; i < static_cast<int>(history.size()); ++i) {
+        truePeak = std::max(truePeak, std::abs(history[i]));
+    }
+    history.erase(history.begin(), history.end()-(truePeakTaps-1));
+}
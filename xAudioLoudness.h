@@ -0,0 +1,114 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __XAUDIOLOUDNESS_H__
+#define __XAUDIOLOUDNESS_H__
+
+#include <QList>
+#include <vector>
+
+/**
+ * @class xAudioLoudness
+ *
+ * @note Measure the integrated loudness (EBU R128, ITU-R BS.1770-4) and the
+ * true peak of interleaved float samples. The samples are K-weighted and the
+ * energy of overlapping 400ms blocks is stored for the gating. The blocks of
+ * several measurements can be combined to compute the album loudness. The
+ * true peak is determined on 4x oversampled samples (2x above 96kHz) using a
+ * polyphase filter with SSE kernel if supported by the CPU.
+ */
+class xAudioLoudness {
+public:
+    /**
+     * Constructor
+     *
+     * @param channels number of channels.
+     * @param sampleRate the sample rate in Hz.
+     * @param channelMask the wav speaker positions, 0 for the default positions.
+     */
+    xAudioLoudness(int channels, int sampleRate, quint32 channelMask);
+    ~xAudioLoudness() = default;
+    /**
+     * Analyze the given samples.
+     *
+     * @param samples the interleaved samples in the range [-1, 1].
+     * @param frames number of samples per channel.
+     */
+    void process(const float* samples, int frames);
+    /**
+     * Return the integrated loudness.
+     *
+     * @return the loudness in LUFS, -70 for silence.
+     */
+    [[nodiscard]] double getLoudness() const;
+    /**
+     * Check if any block passes the absolute gate. The loudness of silence is not
+     * meaningful and must not be used for a gain.
+     *
+     * @return true if the loudness is valid, false otherwise.
+     */
+    [[nodiscard]] bool isValid() const;
+    /**
+     * Return the true peak.
+     *
+     * @return the linear true peak, 1.0 is full scale.
+     */
+    [[nodiscard]] double getTruePeak() const;
+    /**
+     * Return the integrated loudness of several measurements (e.g. an album).
+     *
+     * @param measurements the loudness measurements.
+     * @return the loudness in LUFS, -70 for silence.
+     */
+    [[nodiscard]] static double getLoudness(const QList<const xAudioLoudness*>& measurements);
+    /**
+     * Return the ReplayGain 2.0 gain for the given loudness (reference -18 LUFS).
+     *
+     * @param loudness the loudness in LUFS.
+     * @return the gain in dB.
+     */
+    [[nodiscard]] static double getReplayGain(double loudness);
+
+private:
+    /**
+     * Oversample the given channel and update the true peak.
+     *
+     * @param channel the index of the channel.
+     */
+    void processTruePeak(int channel);
+
+    typedef float (*xAudioLoudnessKernel)(const float* history, const float* coefficients, int taps, int samples);
+
+    int channels;
+    int segmentSize;
+    int segmentPosition;
+    std::vector<double> weights;
+    // K-weighting filter coefficients and state of each channel (two biquads).
+    double filterB[2][3];
+    double filterA[2][3];
+    std::vector<double> filterState;
+    // Energy of the current and the last three 100ms segments.
+    double segmentEnergy;
+    std::vector<double> segments;
+    std::vector<double> blocks;
+    // Polyphase filter for the true peak. The phases are interleaved per tap.
+    int truePeakFactor;
+    int truePeakTaps;
+    std::vector<float> truePeakCoefficients;
+    std::vector<std::vector<float>> truePeakHistory;
+    xAudioLoudnessKernel truePeakKernel;
+    float truePeak;
+};
+
+#endif
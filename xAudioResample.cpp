@@ -0,0 +1,194 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "xAudioResample.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+// Cutoff relative to the lower nyquist frequency.
+const double xAudioResample_Rolloff { 0.95 };
+// Kaiser window parameter and the corresponding stop band attenuation in dB.
+const double xAudioResample_KaiserBeta { 9.0 };
+const double xAudioResample_Attenuation { 90.0 };
+// Error feedback filter for noise shaping (Lipshitz E-weighted).
+const double xAudioDither_Shaping[] { 1.623, -0.982, 0.109 };
+const int xAudioDither_ShapingOrder { 3 };
+
+/**
+ * Modified Bessel function of the first kind of order zero.
+ */
+static double xAudioResampleBessel(double x) {
+    double sum = 1.0, term = 1.0;
+    for (auto k = 1; k < 50; ++k) {
+        term *= (x/(2.0*k))*(x/(2.0*k));
+        sum += term;
+        if (term < sum*1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+/**
+ * Determine the taps of each filter phase. The transition band of the window (Kaiser estimate)
+ * has to fit between the cutoff and the lower nyquist frequency. Downsampling therefore
+ * requires more taps relative to the input rate.
+ */
+static int xAudioResampleTaps(int upFactor, int downFactor) {
+    // Transition band relative to the lower sample rate. The stop band starts at the nyquist frequency.
+    auto transition = 1.0-xAudioResample_Rolloff;
+    auto length = (xAudioResample_Attenuation-7.95)/(14.36*transition);
+    return static_cast<int>(std::ceil(length*std::max(upFactor, downFactor)/upFactor));
+}
+
+xAudioResample::xAudioResample(int channels, int inputRate, int outputRate):
+        channels(channels),
+        outputRate(outputRate),
+        history(static_cast<size_t>(channels)),
+        inputCount(0),
+        outputCount(0) {
+    auto divisor = std::gcd(inputRate, outputRate);
+    upFactor = outputRate/divisor;
+    downFactor = inputRate/divisor;
+    taps = xAudioResampleTaps(upFactor, downFactor);
+    historyStart = -(taps-1);
+    // Prototype low pass filter at the upsampled rate.
+    auto length = upFactor*taps;
+    // The center is the delay compensated in resample.
+    auto center = length/2.0;
+    auto cutoff = xAudioResample_Rolloff*0.5/std::max(upFactor, downFactor);
+    auto window = xAudioResampleBessel(xAudioResample_KaiserBeta);
+    coefficients.resize(static_cast<size_t>(length));
+    for (auto p = 0; p < upFactor; ++p) {
+        for (auto t = 0; t < taps; ++t) {
+            auto k = p+t*upFactor;
+            auto x = k-center;
+            auto sinc = (std::abs(x) < 1e-9) ? 1.0 : std::sin(2.0*M_PI*cutoff*x)/(2.0*M_PI*cutoff*x);
+            auto r = x/center;
+            auto kaiser = xAudioResampleBessel(xAudioResample_KaiserBeta*std::sqrt(std::max(0.0, 1.0-r*r)))/window;
+            // The gain upFactor compensates the zeros inserted by upsampling.
+            coefficients[static_cast<size_t>(p*taps+(taps-1-t))] = static_cast<float>(upFactor*2.0*cutoff*sinc*kaiser);
+        }
+    }
+    // The input before the first sample is zero.
+    for (auto& channel : history) {
+        channel.assign(static_cast<size_t>(taps-1), 0.0f);
+    }
+    qDebug() << "xAudioResample: " << inputRate << "->" << outputRate << ", phases: " << upFactor << ", taps: " << taps;
+}
+
+void xAudioResample::process(const float* const* input, int samples, std::vector<std::vector<float>>& output) {
+    for (auto c = 0; c < channels; ++c) {
+        history[c].insert(history[c].end(), input[c], input[c]+samples);
+    }
+    inputCount += samples;
+    resample(inputCount, output);
+}
+
+void xAudioResample::flush(std::vector<std::vector<float>>& output) {
+    // Pad with zeros to compute the samples within the delay of the filter.
+    for (auto& channel : history) {
+        channel.insert(channel.end(), static_cast<size_t>(taps), 0.0f);
+    }
+    resample(inputCount+taps, output);
+}
+
+int xAudioResample::getOutputRate() const {
+    return outputRate;
+}
+
+void xAudioResample::resample(int64_t available, std::vector<std::vector<float>>& output) {
+    output.resize(static_cast<size_t>(channels));
+    for (auto& channel : output) {
+        channel.clear();
+    }
+    // Total number of output samples for the input. Only reached if flushed.
+    auto outputTotal = (inputCount*upFactor+downFactor-1)/downFactor;
+    // Delay of the filter in upsampled samples.
+    auto delay = static_cast<int64_t>(upFactor)*taps/2;
+    while (outputCount < outputTotal) {
+        auto position = outputCount*downFactor+delay;
+        auto index = position/upFactor;
+        if (index >= available) {
+            break;
+        }
+        auto phase = coefficients.data()+(position%upFactor)*taps;
+        auto offset = static_cast<size_t>(index-(taps-1)-historyStart);
+        for (auto c = 0; c < channels; ++c) {
+            auto samples = history[c].data()+offset;
+            float sample = 0.0f;
+            for (auto t = 0; t < taps; ++t) {
+                sample += phase[t]*samples[t];
+            }
+            output[c].push_back(sample);
+        }
+        ++outputCount;
+    }
+    // Drop the input that is no longer required.
+    auto next = (outputCount*downFactor+delay)/upFactor-(taps-1);
+    auto drop = std::clamp<int64_t>(next-historyStart, 0, static_cast<int64_t>(history[0].size()));
+    for (auto& channel : history) {
+        channel.erase(channel.begin(), channel.begin()+drop);
+    }
+    historyStart += drop;
+}
+
+xAudioDither::xAudioDither(int channels, int bitsPerSample, bool noiseShaping):
+        channels(channels),
+        bytesPerSample(bitsPerSample/8),
+        noiseShaping(noiseShaping),
+        errors(static_cast<size_t>(channels*xAudioDither_ShapingOrder), 0.0),
+        state(0x12345678) {
+    scale = std::ldexp(1.0, bitsPerSample-1);
+    minimum = -scale;
+    maximum = scale-1.0;
+}
+
+void xAudioDither::process(const float* const* input, int samples, QByteArray& buffer) {
+    buffer.resize(samples*channels*bytesPerSample);
+    auto output = reinterpret_cast<uint8_t*>(buffer.data());
+    for (auto i = 0; i < samples; ++i) {
+        for (auto c = 0; c < channels; ++c) {
+            auto value = static_cast<double>(input[c][i])*scale;
+            auto error = errors.data()+c*xAudioDither_ShapingOrder;
+            if (noiseShaping) {
+                for (auto k = 0; k < xAudioDither_ShapingOrder; ++k) {
+                    value -= xAudioDither_Shaping[k]*error[k];
+                }
+            }
+            // Triangular dither with an amplitude of one LSB.
+            auto quantized = std::clamp(std::floor(value+random()+random()+0.5), minimum, maximum);
+            if (noiseShaping) {
+                std::copy_backward(error, error+xAudioDither_ShapingOrder-1, error+xAudioDither_ShapingOrder);
+                // Limit the error fed back after clipping.
+                error[0] = std::clamp(quantized-value, -2.0, 2.0);
+            }
+            auto sample = static_cast<uint32_t>(static_cast<int32_t>(quantized));
+            for (auto b = 0; b < bytesPerSample; ++b) {
+                *output++ = static_cast<uint8_t>((sample >> (b*8)) & 0xFF);
+            }
+        }
+    }
+}
+
+double xAudioDither::random() {
+    // xorshift32 is sufficient for dither.
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state/4294967296.0-0.5;
+}
@@ -0,0 +1,130 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __XAUDIORESAMPLE_H__
+#define __XAUDIORESAMPLE_H__
+
+#include <QByteArray>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @class xAudioResample
+ *
+ * @note Convert the sample rate of planar float samples with a polyphase
+ * windowed sinc filter. The ratio of the sample rates is reduced to L/M and
+ * each output sample is computed with one of the L filter phases. The delay
+ * of the filter is compensated, the output is aligned with the input.
+ */
+class xAudioResample {
+public:
+    /**
+     * Constructor. Compute the filter phases.
+     *
+     * @param channels number of channels.
+     * @param inputRate the input sample rate in Hz.
+     * @param outputRate the output sample rate in Hz.
+     */
+    xAudioResample(int channels, int inputRate, int outputRate);
+    ~xAudioResample() = default;
+    /**
+     * Resample the given samples.
+     *
+     * @param input pointers to the planar samples of each channel.
+     * @param samples number of samples per channel.
+     * @param output the resampled planar samples of each channel. Replaced on each call.
+     */
+    void process(const float* const* input, int samples, std::vector<std::vector<float>>& output);
+    /**
+     * Resample the remaining samples at the end of the input.
+     *
+     * @param output the resampled planar samples of each channel.
+     */
+    void flush(std::vector<std::vector<float>>& output);
+    /**
+     * Return the output sample rate.
+     *
+     * @return the sample rate in Hz.
+     */
+    [[nodiscard]] int getOutputRate() const;
+
+private:
+    /**
+     * Compute all output samples for which the input is available.
+     *
+     * @param available number of input samples available including padding.
+     * @param output the resampled planar samples of each channel.
+     */
+    void resample(int64_t available, std::vector<std::vector<float>>& output);
+
+    int channels;
+    int outputRate;
+    int upFactor;
+    int downFactor;
+    int taps;
+    // Phase major coefficients, reversed for a dot product with the input.
+    std::vector<float> coefficients;
+    std::vector<std::vector<float>> history;
+    int64_t historyStart;
+    int64_t inputCount;
+    int64_t outputCount;
+};
+
+/**
+ * @class xAudioDither
+ *
+ * @note Quantize planar float samples to interleaved little endian integer
+ * samples with TPDF dither. Optionally the quantization error is shaped
+ * towards high frequencies using an error feedback filter.
+ */
+class xAudioDither {
+public:
+    /**
+     * Constructor
+     *
+     * @param channels number of channels.
+     * @param bitsPerSample the bits per output sample.
+     * @param noiseShaping use noise shaping if true, plain TPDF dither otherwise.
+     */
+    xAudioDither(int channels, int bitsPerSample, bool noiseShaping);
+    ~xAudioDither() = default;
+    /**
+     * Quantize the given samples.
+     *
+     * @param input pointers to the planar samples of each channel.
+     * @param samples number of samples per channel.
+     * @param buffer the interleaved integer samples. Replaced on each call.
+     */
+    void process(const float* const* input, int samples, QByteArray& buffer);
+
+private:
+    /**
+     * Uniform random value in [-0.5, 0.5).
+     *
+     * @return the random value.
+     */
+    double random();
+
+    int channels;
+    int bytesPerSample;
+    double scale;
+    double minimum;
+    double maximum;
+    bool noiseShaping;
+    // Last quantization errors of each channel for noise shaping.
+    std::vector<double> errors;
+    uint32_t state;
+};
+
+#endif
@@ -67,6 +67,10 @@ int xAudioTrackItemWidget::getAudioTrackOffset() const {
     return audioTrackOffset;
 }
 
+void xAudioTrackItemWidget::setTrackNr(int nr) {
+    trackNr->setText(QString("%1").arg(nr, 2, 10, QChar('0')));
+}
+
 QString xAudioTrackItemWidget::getTrackNr() const {
     return trackNr->text();
 }
@@ -144,6 +148,14 @@ void xAudioTracksWidget::setTrackNames(const QVector<QString>& names) {
     }
 }
 
+void xAudioTracksWidget::setTrackNrs(const QVector<int>& nrs) {
+    if (nrs.count() == audioTracks.count()) {
+        for (int track = 0; track < audioTracks.count(); ++track) {
+            audioTracks[track]->setTrackNr(nrs[track]);
+        }
+    }
+}
+
 QString xAudioTracksWidget::millisecondsToLabel(qint64 ms) {
     return QString("%1:%2.%3").arg(ms/60000).
             arg((ms/1000)%60, 2, 10, QChar('0')).
@@ -193,6 +205,30 @@ void xAudioTracksWidget::setTracks(int tracks) {
     setWidget(audioMain);
 }
 
+void xAudioTracksWidget::appendTracks(const QVector<QString>& names, const QVector<qint64>& sizes) {
+    if (names.count() != sizes.count()) {
+        return;
+    }
+    if (!audioLayout) {
+        setTracks(0);
+    }
+    for (int index = 0; index < names.count(); ++index) {
+        auto trackItemWidget = new xAudioTrackItemWidget(audioTracks.count()+1, audioTracksOffset, audioMain);
+        trackItemWidget->setTrackName(names[index]);
+        trackItemWidget->setTrackSize(QString::number(sizes[index]));
+        // Connect individual audio track signals to audio widget signal.
+        connect(trackItemWidget, &xAudioTrackItemWidget::isSelectedUpdate, this, &xAudioTracksWidget::isSelectedUpdate);
+        // Insert before the stretch at the end of the layout.
+        audioLayout->insertWidget(audioTracks.count(), trackItemWidget);
+        audioTracks.push_back(trackItemWidget);
+    }
+    updateTabOrder();
+}
+
+int xAudioTracksWidget::getTracks() const {
+    return audioTracks.count();
+}
+
 void xAudioTracksWidget::updateTabOrder() {
     auto noTracks = audioTracks.count();
     if (noTracks <= 1) {
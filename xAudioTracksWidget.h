@@ -65,6 +65,12 @@ public:
      * @return the offset of the track number as integer.
      */
     [[nodiscard]] int getAudioTrackOffset() const;
+    /**
+     * Set the track number used in the file name. Overrides the number based on the offset.
+     *
+     * @param nr the new track number as integer.
+     */
+    void setTrackNr(int nr);
     /**
      * Retrieve the track number used in the file name.
      *
@@ -178,6 +184,12 @@ public:
      * @param names the new track names as vector of strings.
      */
     void setTrackNames(const QVector<QString>& names);
+    /**
+     * Set all track numbers, e.g. the track numbers within each disc of a box set.
+     *
+     * @param nrs the new track numbers as vector of integers.
+     */
+    void setTrackNrs(const QVector<int>& nrs);
     /**
      * Set the lengths for each track.
      *
@@ -190,6 +202,19 @@ public:
      * @param sizes a vector of track sizes in byte.
      */
     void setTrackSizes(const QVector<qint64>& sizes);
+    /**
+     * Append tracks with the given names and sizes.
+     *
+     * @param names the track names of the appended tracks as vector of strings.
+     * @param sizes the track sizes in bytes of the appended tracks.
+     */
+    void appendTracks(const QVector<QString>& names, const QVector<qint64>& sizes);
+    /**
+     * Retrieve the number of tracks.
+     *
+     * @return the number of tracks as integer.
+     */
+    [[nodiscard]] int getTracks() const;
     /**
      * Clear the widget. Remove all tracks.
      */
@@ -0,0 +1,104 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "xConsoleWidget.h"
+#include <QContextMenuEvent>
+#include <QActionGroup>
+#include <QMenu>
+#include <QStringList>
+
+// Maximum number of lines shown in the console.
+const int xConsoleWidget_MaximumLines { 2000 };
+
+xConsoleWidget::xConsoleWidget(const QString& source, QWidget* parent):
+        QPlainTextEdit(parent),
+        consoleSource(source),
+        consoleJobId(0),
+        consoleSeverity(xLogSeverity::Info),
+        consoleJobFilter(false) {
+    setReadOnly(true);
+    setMaximumBlockCount(xConsoleWidget_MaximumLines);
+    connect(xLogSink::sink(), &xLogSink::flushed, this, &xConsoleWidget::append);
+}
+
+void xConsoleWidget::log(const QString& message, quint64 jobId) {
+    xLogSink::sink()->log(consoleSource, xLogSink::severityFromMessage(message), message, jobId);
+}
+
+void xConsoleWidget::setJobId(quint64 jobId) {
+    consoleJobId = jobId;
+    if (consoleJobFilter) {
+        reload();
+    }
+}
+
+void xConsoleWidget::setSeverity(xLogSeverity severity) {
+    consoleSeverity = severity;
+    reload();
+}
+
+void xConsoleWidget::setJobFilter(bool enabled) {
+    consoleJobFilter = enabled;
+    reload();
+}
+
+void xConsoleWidget::contextMenuEvent(QContextMenuEvent* event) {
+    auto menu = createStandardContextMenu();
+    menu->addSeparator();
+    auto severityGroup = new QActionGroup(menu);
+    const std::pair<QString,xLogSeverity> severities[] = {
+        { tr("Show Debug"), xLogSeverity::Debug },
+        { tr("Show Info"), xLogSeverity::Info },
+        { tr("Show Warnings"), xLogSeverity::Warning },
+        { tr("Show Errors"), xLogSeverity::Error }
+    };
+    for (const auto& severity : severities) {
+        auto action = menu->addAction(severity.first);
+        action->setCheckable(true);
+        action->setChecked(consoleSeverity == severity.second);
+        action->setActionGroup(severityGroup);
+        auto level = severity.second;
+        connect(action, &QAction::triggered, [=]() { setSeverity(level); });
+    }
+    menu->addSeparator();
+    auto jobAction = menu->addAction(tr("Current Job Only"));
+    jobAction->setCheckable(true);
+    jobAction->setChecked(consoleJobFilter);
+    connect(jobAction, &QAction::toggled, this, &xConsoleWidget::setJobFilter);
+    menu->exec(event->globalPos());
+    delete menu;
+}
+
+void xConsoleWidget::append(const QVector<xLogEntry>& entries) {
+    QStringList lines;
+    for (const auto& entry : entries) {
+        if (isShown(entry)) {
+            lines.push_back(entry.message);
+        }
+    }
+    // Append all lines of the batch at once.
+    if (!lines.isEmpty()) {
+        appendPlainText(lines.join('\n'));
+    }
+}
+
+bool xConsoleWidget::isShown(const xLogEntry& entry) const {
+    return (entry.source == consoleSource) && (entry.severity >= consoleSeverity) &&
+           ((!consoleJobFilter) || (consoleJobId == 0) || (entry.jobId == 0) || (entry.jobId == consoleJobId));
+}
+
+void xConsoleWidget::reload() {
+    clear();
+    append(xLogSink::sink()->entries(consoleSource, consoleSeverity, consoleJobFilter ? consoleJobId : 0));
+}
@@ -0,0 +1,97 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __XCONSOLEWIDGET_H__
+#define __XCONSOLEWIDGET_H__
+
+#include "xLogSink.h"
+#include <QPlainTextEdit>
+
+/**
+ * @class xConsoleWidget
+ *
+ * @note Plain text view for the messages of one source of the log sink.
+ * The number of lines shown is bounded. The context menu allows to filter
+ * by severity and by the current job.
+ */
+class xConsoleWidget:public QPlainTextEdit {
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param source the source of the messages shown, e.g. "movie".
+     * @param parent pointer to the parent widget.
+     */
+    explicit xConsoleWidget(const QString& source, QWidget* parent=nullptr);
+    ~xConsoleWidget() override = default;
+    /**
+     * Log a message for the source of the console. The severity is
+     * determined by the message prefix.
+     *
+     * @param message the message as string.
+     * @param jobId the job ID the message belongs to, 0 if none.
+     */
+    void log(const QString& message, quint64 jobId=0);
+    /**
+     * Set the current job used by the job filter.
+     *
+     * @param jobId the job ID, 0 if none.
+     */
+    void setJobId(quint64 jobId);
+    /**
+     * Only show messages with at least the given severity.
+     *
+     * @param severity the minimal severity.
+     */
+    void setSeverity(xLogSeverity severity);
+    /**
+     * Only show messages of the current job and messages without job.
+     *
+     * @param enabled filter if true, show all jobs otherwise.
+     */
+    void setJobFilter(bool enabled);
+
+protected:
+    void contextMenuEvent(QContextMenuEvent* event) override;
+
+private slots:
+    /**
+     * Append the messages of a flush of the log sink.
+     *
+     * @param entries the new log entries.
+     */
+    void append(const QVector<xLogEntry>& entries);
+
+private:
+    /**
+     * Check if the entry is shown with the current filter.
+     *
+     * @param entry the log entry to check.
+     * @return true if the entry is shown, false otherwise.
+     */
+    [[nodiscard]] bool isShown(const xLogEntry& entry) const;
+    /**
+     * Clear the view and fill it from the ring buffer of the log sink.
+     */
+    void reload();
+
+    QString consoleSource;
+    quint64 consoleJobId;
+    xLogSeverity consoleSeverity;
+    bool consoleJobFilter;
+};
+
+#endif
@@ -0,0 +1,364 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "xEncodingTracksModel.h"
+#include <QApplication>
+#include <QPalette>
+#include <QDebug>
+
+#include <algorithm>
+
+// Delay in ms after the last edit before smart updates are applied.
+const int xEncodingTracksModel_SmartUpdateDelay { 150 };
+
+xEncodingTracksModel::xEncodingTracksModel(QObject* parent):
+        QAbstractTableModel(parent),
+        smartUpdateEnabled(ColumnCount, false) {
+    // Debounce smart updates while typing.
+    smartUpdateTimer = new QTimer(this);
+    smartUpdateTimer->setSingleShot(true);
+    smartUpdateTimer->setInterval(xEncodingTracksModel_SmartUpdateDelay);
+    connect(smartUpdateTimer, &QTimer::timeout, this, &xEncodingTracksModel::applySmartUpdates);
+}
+
+void xEncodingTracksModel::setTracks(const QVector<xAudioFile*>& files) {
+    // Check if the current tracks are kept and new tracks are only appended.
+    auto append = (files.count() >= encodingTracks.count());
+    for (auto row = 0; (append) && (row < encodingTracks.count()); ++row) {
+        append = (encodingTracks[row].audioFile == files[row]);
+    }
+    if (append) {
+        if (files.count() == encodingTracks.count()) {
+            return;
+        }
+        beginInsertRows(QModelIndex(), encodingTracks.count(), files.count()-1);
+    } else {
+        beginResetModel();
+        encodingTracks.clear();
+        // Pending smart updates refer to the previous rows.
+        smartUpdatePending.clear();
+        smartUpdateEdited.clear();
+        smartUpdateTimer->stop();
+    }
+    // Determine the job index used to separate the jobs visually.
+    auto jobIndex = encodingTracks.isEmpty() ? 0 : encodingTracks.last().jobIndex;
+    auto prevJobId = encodingTracks.isEmpty() ? 0 : encodingTracks.last().audioFile->getJobId();
+    for (auto row = encodingTracks.count(); row < files.count(); ++row) {
+        if ((prevJobId != 0) && (prevJobId != files[row]->getJobId())) {
+            ++jobIndex;
+        }
+        prevJobId = files[row]->getJobId();
+        encodingTracks.push_back(xEncodingTrack{ files[row], QString(), false, -1, -1, jobIndex, row });
+        updateEncodedFileName(row);
+    }
+    updateJobLastRows();
+    if (append) {
+        endInsertRows();
+    } else {
+        endResetModel();
+    }
+}
+
+void xEncodingTracksModel::setEncodedFormat(const QString& format) {
+    encodedFormat.compile(format);
+    for (auto row = 0; row < encodingTracks.count(); ++row) {
+        updateEncodedFileName(row);
+    }
+    if (!encodingTracks.isEmpty()) {
+        emit dataChanged(index(0, ColumnEncodedFileName), index(encodingTracks.count()-1, ColumnEncodedFileName));
+    }
+}
+
+void xEncodingTracksModel::setAllSelected(bool select) {
+    for (auto& track : encodingTracks) {
+        track.selected = select;
+    }
+    if (!encodingTracks.isEmpty()) {
+        emit dataChanged(index(0, ColumnSelect), index(encodingTracks.count()-1, ColumnSelect), { Qt::CheckStateRole });
+    }
+    emit isSelectedUpdate();
+}
+
+bool xEncodingTracksModel::isSelected() const {
+    return std::any_of(encodingTracks.begin(), encodingTracks.end(), [](const xEncodingTrack& track) {
+        return track.selected;
+    });
+}
+
+QVector<int> xEncodingTracksModel::getSelectedRows() const {
+    QVector<int> selectedRows;
+    for (auto row = 0; row < encodingTracks.count(); ++row) {
+        if (encodingTracks[row].selected) {
+            selectedRows.push_back(row);
+        }
+    }
+    return selectedRows;
+}
+
+xAudioFile* xEncodingTracksModel::getAudioFile(int row) const {
+    if ((row >= 0) && (row < encodingTracks.count())) {
+        return encodingTracks[row].audioFile;
+    }
+    return nullptr;
+}
+
+QString xEncodingTracksModel::getEncodedFileName(int row) const {
+    if ((row >= 0) && (row < encodingTracks.count())) {
+        return encodingTracks[row].encodedFileName;
+    }
+    return QString();
+}
+
+void xEncodingTracksModel::autofill() {
+    applySmartUpdates();
+    for (auto row = 0; row < encodingTracks.count(); ++row) {
+        setValue(row, ColumnArtist, tr("artist"));
+        setValue(row, ColumnAlbum, tr("album"));
+        setValue(row, ColumnTag, tr(""));
+        setValue(row, ColumnTrackName, tr("track"));
+        updateEncodedFileName(row);
+    }
+    if (!encodingTracks.isEmpty()) {
+        emit dataChanged(index(0, ColumnArtist), index(encodingTracks.count()-1, ColumnEncodedFileName));
+    }
+}
+
+void xEncodingTracksModel::setProgress(int row, int progress) {
+    if ((row >= 0) && (row < encodingTracks.count())) {
+        encodingTracks[row].progress = progress;
+        emit dataChanged(index(row, ColumnEncodedFileName), index(row, ColumnEncodedFileName), { ProgressRole });
+    }
+}
+
+void xEncodingTracksModel::setVerified(int row, int verified) {
+    if ((row >= 0) && (row < encodingTracks.count())) {
+        encodingTracks[row].verified = verified;
+        emit dataChanged(index(row, ColumnEncodedFileName), index(row, ColumnEncodedFileName), { VerifiedRole });
+    }
+}
+
+void xEncodingTracksModel::setSmartUpdate(int column, bool enabled) {
+    if ((column >= 0) && (column < ColumnCount)) {
+        smartUpdateEnabled[column] = enabled;
+    }
+}
+
+int xEncodingTracksModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : encodingTracks.count();
+}
+
+int xEncodingTracksModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant xEncodingTracksModel::data(const QModelIndex& index, int role) const {
+    if ((!index.isValid()) || (index.row() >= encodingTracks.count())) {
+        return QVariant();
+    }
+    const auto& track = encodingTracks[index.row()];
+    switch (role) {
+        case Qt::DisplayRole:
+        case Qt::EditRole: {
+            if (index.column() == ColumnEncodedFileName) {
+                return track.encodedFileName;
+            }
+            if (index.column() != ColumnSelect) {
+                return getValue(index.row(), index.column());
+            }
+        } break;
+        case Qt::CheckStateRole: {
+            if (index.column() == ColumnSelect) {
+                return track.selected ? Qt::Checked : Qt::Unchecked;
+            }
+        } break;
+        case Qt::TextAlignmentRole: {
+            if (index.column() == ColumnTrackNr) {
+                return Qt::AlignCenter;
+            }
+        } break;
+        case Qt::BackgroundRole: {
+            // Shade every other job in order to separate them.
+            if (track.jobIndex % 2) {
+                return QApplication::palette().alternateBase();
+            }
+        } break;
+        case ProgressRole: {
+            return track.progress;
+        }
+        case VerifiedRole: {
+            return track.verified;
+        }
+        default: break;
+    }
+    return QVariant();
+}
+
+QVariant xEncodingTracksModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if ((orientation != Qt::Horizontal) || (role != Qt::DisplayRole)) {
+        return QVariant();
+    }
+    switch (section) {
+        case ColumnArtist: return tr("Artist");
+        case ColumnAlbum: return tr("Album");
+        case ColumnTag: return tr("Tag");
+        case ColumnTrackNr: return tr("Nr");
+        case ColumnTrackName: return tr("Track Name");
+        case ColumnEncodedFileName: return tr("Encoded File Name");
+        default: return QVariant();
+    }
+}
+
+Qt::ItemFlags xEncodingTracksModel::flags(const QModelIndex& index) const {
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    switch (index.column()) {
+        case ColumnSelect: return Qt::ItemIsEnabled|Qt::ItemIsUserCheckable;
+        case ColumnEncodedFileName: return Qt::ItemIsEnabled|Qt::ItemIsSelectable;
+        default: return Qt::ItemIsEnabled|Qt::ItemIsSelectable|Qt::ItemIsEditable;
+    }
+}
+
+bool xEncodingTracksModel::setData(const QModelIndex& index, const QVariant& value, int role) {
+    if ((!index.isValid()) || (index.row() >= encodingTracks.count())) {
+        return false;
+    }
+    auto row = index.row();
+    if ((role == Qt::CheckStateRole) && (index.column() == ColumnSelect)) {
+        encodingTracks[row].selected = (value.toInt() == Qt::Checked);
+        emit dataChanged(index, index, { Qt::CheckStateRole });
+        emit isSelectedUpdate();
+        return true;
+    }
+    if ((role != Qt::EditRole) || (index.column() == ColumnSelect) || (index.column() == ColumnEncodedFileName)) {
+        return false;
+    }
+    auto text = value.toString();
+    // Does the text represents a valid integer.
+    if ((index.column() == ColumnTrackNr) && (text.toInt() <= 0)) {
+        return false;
+    }
+    if (text == getValue(row, index.column())) {
+        return true;
+    }
+    setValue(row, index.column(), text);
+    if (!smartUpdatePending.isEmpty()) {
+        smartUpdateEdited[std::make_pair(row, index.column())] = smartUpdatePending.count();
+    }
+    updateEncodedFileName(row);
+    emit dataChanged(index, this->index(row, ColumnEncodedFileName));
+    smartUpdate(row, index.column());
+    return true;
+}
+
+void xEncodingTracksModel::setValue(int row, int column, const QString& value) {
+    auto audioFile = encodingTracks[row].audioFile;
+    switch (column) {
+        case ColumnArtist: audioFile->setArtist(value); break;
+        case ColumnAlbum: audioFile->setAlbum(value); break;
+        case ColumnTag: audioFile->setTag(value); break;
+        case ColumnTrackNr: audioFile->setTrackNr(value); break;
+        case ColumnTrackName: audioFile->setTrackName(value); break;
+        default: break;
+    }
+}
+
+QString xEncodingTracksModel::getValue(int row, int column) const {
+    auto audioFile = encodingTracks[row].audioFile;
+    switch (column) {
+        case ColumnArtist: return audioFile->getArtist();
+        case ColumnAlbum: return audioFile->getAlbum();
+        case ColumnTag: return audioFile->getTag();
+        case ColumnTrackNr: return audioFile->getTrackNr();
+        case ColumnTrackName: return audioFile->getTrackName();
+        default: return QString();
+    }
+}
+
+void xEncodingTracksModel::smartUpdate(int row, int column) {
+    if ((column == ColumnTrackName) || (!smartUpdateEnabled[column])) {
+        return;
+    }
+    if (row >= encodingTracks[row].jobLastRow) {
+        return;
+    }
+    // Queue the update. Repeated edits of the same cell are only applied once.
+    auto update = std::make_pair(row, column);
+    if ((smartUpdatePending.isEmpty()) || (smartUpdatePending.last() != update)) {
+        smartUpdatePending.push_back(update);
+    }
+    // Restart the timer.
+    smartUpdateTimer->start();
+}
+
+void xEncodingTracksModel::applySmartUpdates() {
+    smartUpdateTimer->stop();
+    if (smartUpdatePending.isEmpty()) {
+        return;
+    }
+    auto firstRow = encodingTracks.count();
+    auto lastRow = -1;
+    // Apply the updates in the order of the edits.
+    for (auto update = 0; update < smartUpdatePending.count(); ++update) {
+        auto [row, column] = smartUpdatePending[update];
+        if (row >= encodingTracks.count()) {
+            continue;
+        }
+        auto jobLastRow = encodingTracks[row].jobLastRow;
+        auto value = getValue(row, column);
+        auto currentTrackNr = value.toInt() + 1;
+        for (auto i = row+1; i <= jobLastRow; ++i) {
+            // Skip cells edited after the update was queued.
+            auto edited = smartUpdateEdited.find(std::make_pair(i, column));
+            if ((edited != smartUpdateEdited.end()) && (update < edited.value())) {
+                ++currentTrackNr;
+                continue;
+            }
+            if (column == ColumnTrackNr) {
+                setValue(i, column, QString("%1").arg(currentTrackNr++, 2, 10, QChar('0')));
+            } else {
+                setValue(i, column, value);
+            }
+        }
+        firstRow = std::min(firstRow, row+1);
+        lastRow = std::max(lastRow, jobLastRow);
+    }
+    smartUpdatePending.clear();
+    smartUpdateEdited.clear();
+    if (firstRow > lastRow) {
+        return;
+    }
+    // Recompute the file names once and notify the views with a single change.
+    for (auto i = firstRow; i <= lastRow; ++i) {
+        updateEncodedFileName(i);
+    }
+    emit dataChanged(index(firstRow, ColumnArtist), index(lastRow, ColumnEncodedFileName));
+}
+
+void xEncodingTracksModel::updateJobLastRows() {
+    auto jobLastRow = encodingTracks.count()-1;
+    for (auto row = encodingTracks.count()-1; row >= 0; --row) {
+        if ((row < encodingTracks.count()-1) &&
+            (encodingTracks[row].audioFile->getJobId() != encodingTracks[row+1].audioFile->getJobId())) {
+            jobLastRow = row;
+        }
+        encodingTracks[row].jobLastRow = jobLastRow;
+    }
+}
+
+void xEncodingTracksModel::updateEncodedFileName(int row) {
+    // Use audiofile to update file names. Render into the existing string.
+    encodedFormat.setValues(encodingTracks[row].audioFile);
+    encodedFormat.render(encodingTracks[row].encodedFileName);
+}
@@ -0,0 +1,200 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __XENCODINGTRACKSMODEL_H__
+#define __XENCODINGTRACKSMODEL_H__
+
+#include "xAudioFile.h"
+#include "xFileNameTemplate.h"
+#include <QAbstractTableModel>
+#include <QTimer>
+#include <QMap>
+#include <QVector>
+#include <QList>
+
+/**
+ * @class xEncodingTracksModel
+ *
+ * @note Table model for the encoding tracks. Each row is attached to an audio
+ * file object. Changes to artist, album, tag, track number and track name are
+ * written to the audio file object directly.
+ */
+class xEncodingTracksModel:public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    // Columns of the model.
+    enum Column {
+        ColumnSelect, ColumnArtist, ColumnAlbum, ColumnTag, ColumnTrackNr, ColumnTrackName, ColumnEncodedFileName, ColumnCount
+    };
+    // Role used to retrieve the progress (-1 if not encoding).
+    static const int ProgressRole = Qt::UserRole+1;
+    // Role used to retrieve the verification result (-1 if not verified, 0 if failed, 1 if passed).
+    static const int VerifiedRole = Qt::UserRole+2;
+    /**
+     * Constructor
+     *
+     * @param parent pointer to the parent object.
+     */
+    explicit xEncodingTracksModel(QObject* parent=nullptr);
+    /**
+     * Destructor. Default.
+     */
+    ~xEncodingTracksModel() override = default;
+    /**
+     * Set the audio file objects. Existing rows with the same audio file are kept.
+     *
+     * @param files vector of audio file objects.
+     */
+    void setTracks(const QVector<xAudioFile*>& files);
+    /**
+     * Set the format string used to determine the encoded file names.
+     *
+     * @param format the new format as string.
+     */
+    void setEncodedFormat(const QString& format);
+    /**
+     * Select or deselect all tracks.
+     *
+     * @param select select if true, deselect otherwise.
+     */
+    void setAllSelected(bool select);
+    /**
+     * Return if any of the tracks are selected.
+     *
+     * @return true if one or more tracks are selected, false otherwise.
+     */
+    [[nodiscard]] bool isSelected() const;
+    /**
+     * Retrieve the rows of the currently selected tracks.
+     *
+     * @return a vector of row indices.
+     */
+    [[nodiscard]] QVector<int> getSelectedRows() const;
+    /**
+     * Retrieve the audio file object for the given row.
+     *
+     * @param row the row index.
+     * @return pointer to the audio file object.
+     */
+    [[nodiscard]] xAudioFile* getAudioFile(int row) const;
+    /**
+     * Retrieve the encoded file name for the given row.
+     *
+     * @param row the row index.
+     * @return the encoded file name as string.
+     */
+    [[nodiscard]] QString getEncodedFileName(int row) const;
+    /**
+     * Set artist, album and track name to generic names for all tracks.
+     */
+    void autofill();
+    /**
+     * Update the progress for the given row.
+     *
+     * @param row the row index.
+     * @param progress the progress in percent.
+     */
+    void setProgress(int row, int progress);
+    /**
+     * Update the verification result for the given row.
+     *
+     * @param row the row index.
+     * @param verified -1 if not verified, 0 if failed, 1 if passed.
+     */
+    void setVerified(int row, int verified);
+    /**
+     * Set the mode for smart update of the given column within a job ID.
+     *
+     * @param column the column (artist, album, tag or track number).
+     * @param enabled update if true, do not update otherwise.
+     */
+    void setSmartUpdate(int column, bool enabled);
+
+    [[nodiscard]] int rowCount(const QModelIndex& parent=QModelIndex()) const override;
+    [[nodiscard]] int columnCount(const QModelIndex& parent=QModelIndex()) const override;
+    [[nodiscard]] QVariant data(const QModelIndex& index, int role=Qt::DisplayRole) const override;
+    [[nodiscard]] QVariant headerData(int section, Qt::Orientation orientation, int role=Qt::DisplayRole) const override;
+    [[nodiscard]] Qt::ItemFlags flags(const QModelIndex& index) const override;
+    bool setData(const QModelIndex& index, const QVariant& value, int role=Qt::EditRole) override;
+
+public slots:
+    /**
+     * Apply all pending smart updates as one model change.
+     */
+    void applySmartUpdates();
+
+signals:
+    /**
+     * Emitted if encoding tracks selection changes.
+     */
+    void isSelectedUpdate();
+
+private:
+    /**
+     * Write the value of the given column into the audio file object.
+     *
+     * @param row the row index.
+     * @param column the column (artist, album, tag, track number or track name).
+     * @param value the new value as string.
+     */
+    void setValue(int row, int column, const QString& value);
+    /**
+     * Retrieve the value of the given column from the audio file object.
+     *
+     * @param row the row index.
+     * @param column the column (artist, album, tag, track number or track name).
+     * @return the value as string.
+     */
+    [[nodiscard]] QString getValue(int row, int column) const;
+    /**
+     * Queue a smart update for all following tracks that match the job ID.
+     *
+     * @param row the row index of the track that was changed.
+     * @param column the column that was changed.
+     */
+    void smartUpdate(int row, int column);
+    /**
+     * Determine the last row of the job for each track.
+     */
+    void updateJobLastRows();
+    /**
+     * Update the file name based on the format string and the audio file.
+     *
+     * @param row the row index.
+     */
+    void updateEncodedFileName(int row);
+
+    typedef struct {
+        xAudioFile* audioFile;
+        QString encodedFileName;
+        bool selected;
+        int progress;
+        int verified;
+        int jobIndex;
+        int jobLastRow;
+    } xEncodingTrack;
+
+    xFileNameTemplate encodedFormat;
+    QVector<xEncodingTrack> encodingTracks;
+    QVector<bool> smartUpdateEnabled;
+    // Pending smart updates as pairs of row and column in order of the edits.
+    QVector<std::pair<int,int>> smartUpdatePending;
+    // Cells edited directly while smart updates are pending. Maps the cell to the number of
+    // updates queued before the edit. These updates must not overwrite the edit.
+    QMap<std::pair<int,int>,int> smartUpdateEdited;
+    QTimer* smartUpdateTimer;
+};
+
+#endif
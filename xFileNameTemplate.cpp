@@ -0,0 +1,158 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "xFileNameTemplate.h"
+#include "xAudioFile.h"
+
+#include <algorithm>
+
+// Field names used in the file name format (same order as the fields).
+const std::array<QString,xFileNameTemplate::FieldCount> xFileNameTemplate_FieldNames {
+    "artist", "album", "tag", "tracknr", "trackname", "disc", "year", "codec"
+};
+
+xFileNameTemplate::xFileNameTemplate():
+        qualifyTrackNr(false) {
+}
+
+xFileNameTemplate::xFileNameTemplate(const QString& format):
+        qualifyTrackNr(false) {
+    compile(format);
+}
+
+bool xFileNameTemplate::compile(const QString& format) {
+    tokens.clear();
+    error.clear();
+    // Unparsable parts of the format are kept as literal text. Only the first error is reported.
+    auto setError = [this](const QString& message) {
+        if (error.isEmpty()) {
+            error = message;
+        }
+    };
+    QString literal;
+    for (auto i = 0; i < format.length(); ++i) {
+        auto c = format.at(i);
+        if (c == '\\') {
+            if (++i >= format.length()) {
+                setError(QString("trailing escape character"));
+                literal.append(c);
+                break;
+            }
+            literal.append(format.at(i));
+        } else if (c == '(') {
+            auto end = format.indexOf(')', i+1);
+            if (end < 0) {
+                setError(QString("missing ')' for field at position %1").arg(i));
+                literal.append(format.mid(i));
+                break;
+            }
+            auto name = format.mid(i+1, end-i-1);
+            auto field = std::find(xFileNameTemplate_FieldNames.begin(), xFileNameTemplate_FieldNames.end(), name);
+            if (field == xFileNameTemplate_FieldNames.end()) {
+                setError(QString("unknown field '(%1)' at position %2").arg(name).arg(i));
+                literal.append(format.mid(i, end-i+1));
+                i = end;
+                continue;
+            }
+            if (!literal.isEmpty()) {
+                tokens.push_back(xFileNameToken{ FieldCount, literal });
+                literal.clear();
+            }
+            tokens.push_back(xFileNameToken{ static_cast<Field>(field-xFileNameTemplate_FieldNames.begin()), QString() });
+            i = end;
+        } else if (c == ')') {
+            setError(QString("unexpected ')' at position %1").arg(i));
+            literal.append(c);
+        } else {
+            literal.append(c);
+        }
+    }
+    if (!literal.isEmpty()) {
+        tokens.push_back(xFileNameToken{ FieldCount, literal });
+    }
+    qualifyTrackNr = !contains(FieldDisc);
+    return error.isEmpty();
+}
+
+bool xFileNameTemplate::isValid() const {
+    return error.isEmpty();
+}
+
+const QString& xFileNameTemplate::getError() const {
+    return error;
+}
+
+bool xFileNameTemplate::contains(Field field) const {
+    return std::any_of(tokens.begin(), tokens.end(), [field](const xFileNameToken& token) {
+        return token.field == field;
+    });
+}
+
+void xFileNameTemplate::setValue(Field field, const QString& value) {
+    if ((field >= 0) && (field < FieldCount)) {
+        values[field] = value;
+    }
+}
+
+void xFileNameTemplate::setValues(const xAudioFile* audioFile) {
+    values[FieldArtist] = audioFile->getArtist();
+    values[FieldAlbum] = audioFile->getAlbum();
+    values[FieldTag] = audioFile->getTag();
+    values[FieldTrackNr] = audioFile->getTrackNr();
+    values[FieldTrackName] = audioFile->getTrackName();
+    values[FieldDisc] = audioFile->getDisc();
+    values[FieldYear] = audioFile->getYear();
+    values[FieldCodec] = audioFile->getCodec();
+}
+
+void xFileNameTemplate::render(QString& buffer) const {
+    // Keep the allocated capacity of the buffer.
+    buffer.resize(0);
+    for (const auto& token : tokens) {
+        if (token.field == FieldCount) {
+            buffer.append(token.literal);
+        } else {
+            if ((token.field == FieldTrackNr) && (qualifyTrackNr) && (!values[FieldDisc].isEmpty())) {
+                buffer.append(values[FieldDisc]);
+                buffer.append('-');
+            }
+            buffer.append(values[token.field]);
+        }
+    }
+}
+
+QString xFileNameTemplate::render() const {
+    QString buffer;
+    render(buffer);
+    return buffer;
+}
+
+
+
+xFileNameReplace::xFileNameReplace(const QList<std::pair<QString,QString>>& replace) {
+    for (const auto& entry : replace) {
+        if (!entry.first.isEmpty()) {
+            replaceList.push_back(entry);
+        }
+    }
+}
+
+QString xFileNameReplace::apply(const QString& text) const {
+    // Entries are applied one after another. Later entries see the result of earlier ones.
+    QString replacedText(text);
+    for (const auto& entry : replaceList) {
+        replacedText.replace(entry.first, entry.second);
+    }
+    return replacedText;
+}
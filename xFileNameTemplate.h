@@ -0,0 +1,144 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __XFILENAMETEMPLATE_H__
+#define __XFILENAMETEMPLATE_H__
+
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <array>
+
+class xAudioFile;
+
+/**
+ * @class xFileNameTemplate
+ *
+ * @note Compiled file name format. The format is parsed once into a sequence
+ * of literals and fields, e.g. "(artist)/(album)(tag)/(tracknr) (trackname)".
+ * Supported fields are artist, album, tag, tracknr, trackname, disc, year and
+ * codec. A backslash escapes the following character, e.g. "\(" for a literal
+ * parenthesis. Parts of an invalid format are kept as literal text. If the
+ * format has no disc field, a non-empty disc is prepended to the track number
+ * (e.g. "2-05") to keep the file names of box sets unique.
+ */
+class xFileNameTemplate {
+public:
+    enum Field {
+        FieldArtist, FieldAlbum, FieldTag, FieldTrackNr, FieldTrackName, FieldDisc, FieldYear, FieldCodec, FieldCount
+    };
+    /**
+     * Constructor. Create an empty template.
+     */
+    xFileNameTemplate();
+    /**
+     * Constructor. Compile the given format.
+     *
+     * @param format the file name format as string.
+     */
+    explicit xFileNameTemplate(const QString& format);
+    ~xFileNameTemplate() = default;
+    /**
+     * Compile the given format into a token sequence.
+     *
+     * @param format the file name format as string.
+     * @return true if the format is valid, false otherwise.
+     */
+    bool compile(const QString& format);
+    /**
+     * Check if the compiled format is valid.
+     *
+     * @return true if valid, false otherwise.
+     */
+    [[nodiscard]] bool isValid() const;
+    /**
+     * Retrieve the error message for an invalid format.
+     *
+     * @return the error message as string, empty if the format is valid.
+     */
+    [[nodiscard]] const QString& getError() const;
+    /**
+     * Check if the given field is used in the format.
+     *
+     * @param field the field to check for.
+     * @return true if the field is used, false otherwise.
+     */
+    [[nodiscard]] bool contains(Field field) const;
+    /**
+     * Set the value for the given field.
+     *
+     * @param field the field to be updated.
+     * @param value the new value as string.
+     */
+    void setValue(Field field, const QString& value);
+    /**
+     * Set the values for all fields from the audio file object.
+     *
+     * @param audioFile pointer to the audio file object.
+     */
+    void setValues(const xAudioFile* audioFile);
+    /**
+     * Render the current values into the given buffer. The buffer is reused.
+     *
+     * @param buffer the string to render into.
+     */
+    void render(QString& buffer) const;
+    /**
+     * Render the current values.
+     *
+     * @return the file name as string.
+     */
+    [[nodiscard]] QString render() const;
+
+private:
+    typedef struct {
+        Field field;
+        QString literal;
+    } xFileNameToken;
+
+    QVector<xFileNameToken> tokens;
+    // Prepend the disc to the track number if the format has no disc field.
+    bool qualifyTrackNr;
+    std::array<QString,FieldCount> values;
+    QString error;
+};
+
+/**
+ * @class xFileNameReplace
+ *
+ * @note Replace list. The entries are applied in order, each one to the
+ * result of the previous ones.
+ */
+class xFileNameReplace {
+public:
+    /**
+     * Constructor.
+     *
+     * @param replace list of pairs of string to replace and replacement.
+     */
+    explicit xFileNameReplace(const QList<std::pair<QString,QString>>& replace);
+    ~xFileNameReplace() = default;
+    /**
+     * Apply the replace list.
+     *
+     * @param text the input string.
+     * @return the string with all entries replaced.
+     */
+    [[nodiscard]] QString apply(const QString& text) const;
+
+private:
+    QList<std::pair<QString,QString>> replaceList;
+};
+
+#endif
@@ -0,0 +1,117 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "xLogSink.h"
+#include <QDateTime>
+#include <QMutexLocker>
+
+// Number of messages kept in the ring buffer.
+const int xLogSink_Capacity { 10000 };
+// Delay in ms before pending messages are forwarded to the views.
+const int xLogSink_FlushDelay { 100 };
+
+// singleton object.
+xLogSink* xLogSink::logSink = nullptr;
+
+xLogSink::xLogSink():
+        QObject(),
+        logEntries(xLogSink_Capacity),
+        logEntriesHead(0),
+        logEntriesCount(0) {
+    logFlushTimer = new QTimer(this);
+    logFlushTimer->setSingleShot(true);
+    logFlushTimer->setInterval(xLogSink_FlushDelay);
+    connect(logFlushTimer, &QTimer::timeout, this, &xLogSink::flush);
+}
+
+xLogSink* xLogSink::sink() {
+    // Create and return singleton.
+    if (logSink == nullptr) {
+        logSink = new xLogSink();
+    }
+    return logSink;
+}
+
+xLogSeverity xLogSink::severityFromMessage(const QString& message) {
+    if ((message.startsWith("[error]")) || (message.startsWith("[abort]"))) {
+        return xLogSeverity::Error;
+    }
+    if (message.startsWith("[warning]")) {
+        return xLogSeverity::Warning;
+    }
+    if (message.startsWith("[debug]")) {
+        return xLogSeverity::Debug;
+    }
+    return xLogSeverity::Info;
+}
+
+double xLogSink::throughput(qint64 bytes, qint64 ms) {
+    // Avoid division by zero for very small inputs.
+    return (ms > 0) ? (static_cast<double>(bytes)/(1024.0*1024.0))/(static_cast<double>(ms)/1000.0) : 0.0;
+}
+
+void xLogSink::log(const QString& source, xLogSeverity severity, const QString& message, quint64 jobId) {
+    xLogEntry entry { QDateTime::currentMSecsSinceEpoch(), severity, source, jobId, message };
+    bool schedule;
+    {
+        QMutexLocker locker(&logLock);
+        // Overwrite the oldest entry if the ring buffer is full.
+        logEntries[(logEntriesHead+logEntriesCount) % xLogSink_Capacity] = entry;
+        if (logEntriesCount < xLogSink_Capacity) {
+            ++logEntriesCount;
+        } else {
+            logEntriesHead = (logEntriesHead+1) % xLogSink_Capacity;
+        }
+        // Pending messages are bounded by the ring buffer as well.
+        if (logPending.count() >= xLogSink_Capacity) {
+            logPending.removeFirst();
+        }
+        logPending.push_back(entry);
+        schedule = (logPending.count() == 1);
+    }
+    if (schedule) {
+        // The timer needs to be started in the thread of the sink.
+        QMetaObject::invokeMethod(this, &xLogSink::scheduleFlush, Qt::QueuedConnection);
+    }
+}
+
+QVector<xLogEntry> xLogSink::entries(const QString& source, xLogSeverity severity, quint64 jobId) const {
+    QVector<xLogEntry> selectedEntries;
+    QMutexLocker locker(&logLock);
+    for (auto i = 0; i < logEntriesCount; ++i) {
+        const auto& entry = logEntries[(logEntriesHead+i) % xLogSink_Capacity];
+        if ((entry.source == source) && (entry.severity >= severity) &&
+            ((jobId == 0) || (entry.jobId == 0) || (entry.jobId == jobId))) {
+            selectedEntries.push_back(entry);
+        }
+    }
+    return selectedEntries;
+}
+
+void xLogSink::scheduleFlush() {
+    if (!logFlushTimer->isActive()) {
+        logFlushTimer->start();
+    }
+}
+
+void xLogSink::flush() {
+    QVector<xLogEntry> entries;
+    {
+        QMutexLocker locker(&logLock);
+        entries.swap(logPending);
+    }
+    if (!entries.isEmpty()) {
+        emit flushed(entries);
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __XLOGSINK_H__
+#define __XLOGSINK_H__
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QTimer>
+#include <QMutex>
+
+enum class xLogSeverity {
+    Debug, Info, Warning, Error
+};
+
+struct xLogEntry {
+    qint64 timestamp;
+    xLogSeverity severity;
+    QString source;
+    quint64 jobId;
+    QString message;
+};
+
+/**
+ * @class xLogSink
+ *
+ * @note Shared sink for all console messages. The messages are stored in a
+ * ring buffer of fixed size and forwarded to the views in timed batches.
+ * Messages can be logged from any thread.
+ */
+class xLogSink:public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * Return the log sink object.
+     *
+     * @return pointer to a singleton of the log sink.
+     */
+    static xLogSink* sink();
+    /**
+     * Determine the severity from the message prefix such as "[error]".
+     *
+     * @param message the message as string.
+     * @return the severity of the message.
+     */
+    static xLogSeverity severityFromMessage(const QString& message);
+    /**
+     * Compute the throughput for the "[timing]" messages.
+     *
+     * @param bytes the number of bytes processed.
+     * @param ms the time required in milliseconds.
+     * @return the throughput in MB/s.
+     */
+    static double throughput(qint64 bytes, qint64 ms);
+    /**
+     * Log a message.
+     *
+     * @param source the source of the message, e.g. "movie".
+     * @param severity the severity of the message.
+     * @param message the message as string.
+     * @param jobId the job ID the message belongs to, 0 if none.
+     */
+    void log(const QString& source, xLogSeverity severity, const QString& message, quint64 jobId=0);
+    /**
+     * Retrieve the messages currently stored in the ring buffer.
+     *
+     * @param source only return messages of this source.
+     * @param severity only return messages with at least this severity.
+     * @param jobId only return messages of this job (and without job), 0 for all.
+     * @return a vector of log entries in chronological order.
+     */
+    [[nodiscard]] QVector<xLogEntry> entries(const QString& source, xLogSeverity severity, quint64 jobId=0) const;
+
+signals:
+    /**
+     * Emitted with the messages logged since the last flush.
+     *
+     * @param entries the new log entries in chronological order.
+     */
+    void flushed(const QVector<xLogEntry>& entries);
+
+private slots:
+    /**
+     * Start the flush timer. Called in the thread of the sink.
+     */
+    void scheduleFlush();
+    /**
+     * Forward all pending messages to the views.
+     */
+    void flush();
+
+private:
+    xLogSink();
+    ~xLogSink() override = default;
+
+    static xLogSink* logSink;
+    mutable QMutex logLock;
+    // Ring buffer.
+    QVector<xLogEntry> logEntries;
+    int logEntriesHead;
+    int logEntriesCount;
+    // Messages not yet flushed.
+    QVector<xLogEntry> logPending;
+    QTimer* logFlushTimer;
+};
+
+#endif
@@ -17,6 +17,7 @@
 #include <QFileDialog>
 #include <QGridLayout>
 #include <QDir>
+#include <QFileInfo>
 #include <QLabel>
 #include <QGroupBox>
 #include <QComboBox>
@@ -37,9 +38,12 @@ xMainArchiveFileWidget::xMainArchiveFileWidget(QWidget *parent, Qt::WindowFlags
     archiveFileAutofillButton = new QPushButton(tr("Autofill"), archiveFileBox);
     archiveFileAnalyzeButton = new QPushButton(tr("Analyze"), archiveFileBox);
     archiveFileTagLookupSelectionList = new QListWidget(archiveFileBox);
-    archiveFileTagLookupSelectionList->addItems(xArchiveFile::TagLookupSchemes);
+    archiveFileTagLookupSelectionList->addItems(xArchiveFileSchemes::schemes()->getNames());
     archiveFileTagLookupButton = new QPushButton(tr("Lookup"), archiveFileBox);
     archiveFileTagHDInputCheck = new QCheckBox(tr("HD input"), archiveFileBox);
+    archiveFileBatchButton = new QPushButton(tr("Batch Import"), archiveFileBox);
+    archiveFileBatchCancelButton = new QPushButton(tr("Cancel Batch"), archiveFileBox);
+    archiveFileBatchCancelButton->setEnabled(false);
     auto archiveFileLayout = new QGridLayout();
     archiveFileLayout->addWidget(new QLabel(tr("Artist"), archiveFileBox), 0, 0, 1, 1);
     archiveFileLayout->addWidget(archiveFileArtistName, 1, 0, 1, 6);
@@ -62,6 +66,8 @@ xMainArchiveFileWidget::xMainArchiveFileWidget(QWidget *parent, Qt::WindowFlags
     archiveFileLayout->addWidget(archiveFileTagHDInputCheck, 14, 5, 1, 1);
     archiveFileLayout->setRowMinimumHeight(15, 50);
     archiveFileLayout->setRowStretch(15, 0);
+    archiveFileLayout->addWidget(archiveFileBatchButton, 16, 0, 1, 3);
+    archiveFileLayout->addWidget(archiveFileBatchCancelButton, 16, 3, 1, 3);
     archiveFileBox->setLayout(archiveFileLayout);
     // Audio tracks box.
     auto archiveAudioTracksBox = new QGroupBox(tr("Audio Tracks"), this);
@@ -85,9 +91,7 @@ xMainArchiveFileWidget::xMainArchiveFileWidget(QWidget *parent, Qt::WindowFlags
     // Console box.
     auto consoleBox = new QGroupBox(tr("Console"), this);
     consoleBox->setFlat(xRipEncodeUseFlatGroupBox);
-    consoleText = new QTextEdit(consoleBox);
-    consoleText->setAcceptRichText(true);
-    consoleText->setReadOnly(true);
+    consoleText = new xConsoleWidget("archive", consoleBox);
     auto consoleLayout = new QGridLayout();
     consoleLayout->addWidget(consoleText, 0, 0, 2, 6);
     consoleBox->setLayout(consoleLayout);
@@ -98,11 +102,17 @@ xMainArchiveFileWidget::xMainArchiveFileWidget(QWidget *parent, Qt::WindowFlags
     // Create audio ripper object and connect object.
     archiveFile = new xArchiveFile(this);
     connect(archiveFile, &xArchiveFile::archivedFiles, this, &xMainArchiveFileWidget::archivedFiles);
+    connect(archiveFile, &xArchiveFile::archivedFilesAppend, archiveAudioTracks, &xAudioTracksWidget::appendTracks);
     connect(archiveFile, &xArchiveFile::messages, this, &xMainArchiveFileWidget::messages);
     connect(archiveFile, &xArchiveFile::extractProgress, archiveAudioTracks, &xAudioTracksWidget::ripProgress);
     connect(archiveFile, &xArchiveFile::finished, this, &xMainArchiveFileWidget::extractFinished);
     // Connect signals for audio files.
     connect(archiveFile, &xArchiveFile::audioFiles, this, &xMainArchiveFileWidget::audioFiles);
+    // Create batch import object and connect object.
+    archiveFileBatch = new xArchiveFileBatch(this);
+    connect(archiveFileBatch, &xArchiveFileBatch::audioFiles, this, &xMainArchiveFileWidget::batchAudioFiles);
+    connect(archiveFileBatch, &xArchiveFileBatch::messages, this, &xMainArchiveFileWidget::messages);
+    connect(archiveFileBatch, &xArchiveFileBatch::finished, this, &xMainArchiveFileWidget::batchFinished);
     // Connect buttons.
     connect(archiveFileDialogButton, &QPushButton::pressed, this, &xMainArchiveFileWidget::openFile);
     connect(archiveFileAnalyzeButton, &QPushButton::pressed, this, &xMainArchiveFileWidget::analyze);
@@ -111,6 +121,8 @@ xMainArchiveFileWidget::xMainArchiveFileWidget(QWidget *parent, Qt::WindowFlags
     connect(archiveAudioTracksSelectButton, &QPushButton::pressed, archiveAudioTracks, &xAudioTracksWidget::selectAll);
     connect(archiveAudioTracksExtractButton, &QPushButton::pressed, this, &xMainArchiveFileWidget::extract);
     connect(archiveAudioTracksExtractCancelButton, &QPushButton::pressed, this, &xMainArchiveFileWidget::extractCancel);
+    connect(archiveFileBatchButton, &QPushButton::pressed, this, &xMainArchiveFileWidget::batch);
+    connect(archiveFileBatchCancelButton, &QPushButton::pressed, this, &xMainArchiveFileWidget::batchCancel);
     // Connect album and artist LineEdit.
     connect(archiveFileArtistName, &QLineEdit::textChanged, this, &xMainArchiveFileWidget::artistOrAlbumChanged);
     connect(archiveFileAlbumName, &QLineEdit::textChanged, this, &xMainArchiveFileWidget::artistOrAlbumChanged);
@@ -130,16 +142,29 @@ void xMainArchiveFileWidget::artistOrAlbumChanged(const QString& text) {
 void xMainArchiveFileWidget::openFile() {
     QString fileName = QFileDialog::getOpenFileName(this, tr("Open Archive File"),
                                                     QDir::cleanPath(archiveFile->getFileName()),
-                                                    tr("Archives (*.tar *.zip)"));
+                                                    tr("Archives (%1)").arg(xArchiveFile::ArchiveFileNameFilters.join(' ')));
     if (!fileName.isEmpty()) {
         archiveFileName->setText(fileName);
     }
 }
 
 void xMainArchiveFileWidget::analyze() {
+    // Keep the view of the running analysis.
+    if (archiveFile->isAnalyzing()) {
+        consoleText->log("[analyze] analysis already in progress");
+        return;
+    }
     // Reset artist, album and track offset on analyzing the file.
     archiveFileArtistName->clear();
     archiveFileAlbumName->clear();
+    archiveFileTrackDiscs.clear();
+    // Tracks are appended while the analysis is running in the background.
+    archiveAudioTracks->clear();
+    archiveAudioTracks->setEnabled(true);
+    archiveFileAnalyzeButton->setEnabled(false);
+    archiveFileTagLookupButton->setEnabled(false);
+    archiveAudioTracksSelectButton->setEnabled(false);
+    archiveAudioTracksExtractButton->setEnabled(false);
     archiveFile->analyze(archiveFileName->text());
 }
 
@@ -154,13 +179,19 @@ void xMainArchiveFileWidget::archivedFiles(const QVector<QString>& fileNames, co
     archiveAudioTracksSelectButton->setEnabled(true);
     archiveAudioTracksExtractButton->setEnabled(isExtractButtonEnabled());
     archiveAudioTracksExtractCancelButton->setEnabled(false);
-    archiveAudioTracks->setTracks(fileSizes.count());
-    archiveAudioTracks->setTrackSizes(fileSizes);
-    archiveAudioTracks->setTrackNames(fileNames);
+    archiveFileAnalyzeButton->setEnabled(true);
+    archiveFileTagLookupButton->setEnabled(true);
+    // Tracks have already been appended. Only recreate in case of errors.
+    if (archiveAudioTracks->getTracks() != fileSizes.count()) {
+        archiveAudioTracks->setTracks(fileSizes.count());
+        archiveAudioTracks->setTrackSizes(fileSizes);
+        archiveAudioTracks->setTrackNames(fileNames);
+    }
 }
 
 void xMainArchiveFileWidget::extract() {
     auto jobId = QRandomGenerator::global()->generate64();
+    consoleText->setJobId(jobId);
     auto tags = xRipEncodeConfiguration::configuration()->getTags();
     auto tagId = static_cast<int>(archiveFileTagHDInputCheck->isChecked());
     qDebug() << "xMainArchiveFileWidget::extract: tags: " << tags;
@@ -182,6 +213,8 @@ void xMainArchiveFileWidget::extract() {
 }
 
 void xMainArchiveFileWidget::extractCancel() {
+    // Abort the wait for temp space.
+    archiveFile->requestInterruption();
     extractFinished();
 }
 
@@ -199,8 +232,32 @@ void xMainArchiveFileWidget::extractFinished() {
     archiveAudioTracksExtractCancelButton->setEnabled(false);
 }
 
-void xMainArchiveFileWidget::messages(const QString& msg) {
-    consoleText->append(msg);
+void xMainArchiveFileWidget::batch() {
+    auto directory = QFileDialog::getExistingDirectory(this, tr("Open Archive Directory"),
+                                                       QFileInfo(archiveFile->getFileName()).absolutePath());
+    if ((directory.isEmpty()) || (!archiveFileBatch->start(directory))) {
+        return;
+    }
+    archiveFileBatchButton->setEnabled(false);
+    archiveFileBatchCancelButton->setEnabled(true);
+}
+
+void xMainArchiveFileWidget::batchCancel() {
+    archiveFileBatchCancelButton->setEnabled(false);
+    archiveFileBatch->cancel();
+}
+
+void xMainArchiveFileWidget::batchFinished() {
+    archiveFileBatchButton->setEnabled(true);
+    archiveFileBatchCancelButton->setEnabled(false);
+}
+
+void xMainArchiveFileWidget::batchDequeued(quint64 jobId) {
+    archiveFileBatch->dequeued(jobId);
+}
+
+void xMainArchiveFileWidget::messages(const QString& msg, quint64 jobId) {
+    consoleText->log(msg, jobId);
 }
 
 void xMainArchiveFileWidget::lookup() {
@@ -212,31 +269,19 @@ void xMainArchiveFileWidget::lookup() {
         archiveAudioTracks->setTrackNames(result.trackName);
         archiveAudioTracks->setTrackSizes(result.trackSize);
         archiveFileTagHDInputCheck->setChecked(result.bitsPerSample == 24);
+        // Number the tracks within each disc for box sets.
+        archiveFileTrackDiscs = result.trackDisc;
+        if (!archiveFileTrackDiscs.isEmpty()) {
+            archiveAudioTracks->setTrackNrs(result.trackDiscNr);
+            consoleText->log(QString("[lookup] %1 tracks on %2 discs").arg(archiveFileTrackDiscs.count()).
+                    arg(QSet<int>(archiveFileTrackDiscs.begin(), archiveFileTrackDiscs.end()).count()));
+        }
     }
 }
 
 QList<xAudioFile*> xMainArchiveFileWidget::getAudioFiles(const QString& tag, int tagId, quint64 jobId) {
-    auto selectedTracks = archiveAudioTracks->getSelected();
-    auto artistName = archiveFileArtistName->text();
-    auto albumName = archiveFileAlbumName->text();
-    auto fileFormat = xRipEncodeConfiguration::configuration()->getFileNameFormat();
-    auto tempDirectory = xRipEncodeConfiguration::configuration()->getTempDirectory();
-    fileFormat.replace("(artist)", artistName);
-    fileFormat.replace("(album)", albumName);
-    // The tag should contain any separators such as a space.
-    fileFormat.replace("(tag)", tag);
-    QList<xAudioFile*> files;
-    for (const auto& track : selectedTracks) {
-        auto trackFileFormat = fileFormat;
-        trackFileFormat.replace("(tracknr)", std::get<1>(track));
-        trackFileFormat.replace("(trackname)", std::get<2>(track));
-        if (!trackFileFormat.endsWith(".flac")) {
-            trackFileFormat.append(".flac");
-        }
-        files.push_back(new xAudioFileFlac(tempDirectory+"/"+trackFileFormat, std::get<0>(track), artistName,
-                                           albumName, std::get<1>(track), std::get<2>(track), tag, tagId, jobId));
-    }
-    return files;
+    return xArchiveFile::createAudioFiles(archiveFileArtistName->text(), archiveFileAlbumName->text(),
+                                          archiveAudioTracks->getSelected(), archiveFileTrackDiscs, tag, tagId, jobId);
 }
 
 bool xMainArchiveFileWidget::isExtractButtonEnabled() {
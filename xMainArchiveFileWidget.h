@@ -16,12 +16,13 @@
 #define __XMAINARCHIVEFILEWIDGET_H__
 
 #include "xArchiveFile.h"
+#include "xArchiveFileBatch.h"
 #include "xAudioTracksWidget.h"
+#include "xConsoleWidget.h"
 #include <QPushButton>
 #include <QCheckBox>
 #include <QSpinBox>
 #include <QListWidget>
-#include <QTextEdit>
 #include <QWidget>
 
 class xMainArchiveFileWidget: public QWidget {
@@ -40,6 +41,14 @@ public:
      */
     ~xMainArchiveFileWidget() override = default;
 
+public slots:
+    /**
+     * Called once the audio files of a batch job are encoded or removed.
+     *
+     * @param jobId the job ID of the batch job.
+     */
+    void batchDequeued(quint64 jobId);
+
 signals:
     /**
      * Signal the list of successfully ripped movie chapter audio tracks.
@@ -47,6 +56,12 @@ signals:
      * @param tracks list of audio file objects containing the necessary information.
      */
     void audioFiles(const QList<xAudioFile*>& files);
+    /**
+     * Signal the extracted audio tracks of one archive file of the batch import.
+     *
+     * @param files list of audio file objects containing the necessary information.
+     */
+    void batchAudioFiles(const QList<xAudioFile*>& files);
 
 private slots:
     /**
@@ -79,6 +94,18 @@ private slots:
      * Update widget upon finishing the extract thread.
      */
     void extractFinished();
+    /**
+     * Open a directory dialog and import all archive files of the selected directory.
+     */
+    void batch();
+    /**
+     * Stop the batch import after the current archive file.
+     */
+    void batchCancel();
+    /**
+     * Update widget upon finishing the batch import.
+     */
+    void batchFinished();
     /**
      * Set the file names of individual files within the archive file.
      *
@@ -90,8 +117,9 @@ private slots:
      * Update the console.
      *
      * @param msg the message appended to the console as string.
+     * @param jobId the job ID the message belongs to, 0 if none.
      */
-    void messages(const QString& msg);
+    void messages(const QString& msg, quint64 jobId);
 
     void lookup();
 
@@ -125,8 +153,13 @@ private:
     QPushButton* archiveAudioTracksExtractButton;
     QPushButton* archiveAudioTracksExtractCancelButton;
     QCheckBox* archiveFileTagHDInputCheck;
-    QTextEdit* consoleText;
+    QPushButton* archiveFileBatchButton;
+    QPushButton* archiveFileBatchCancelButton;
+    xConsoleWidget* consoleText;
     xArchiveFile* archiveFile;
+    xArchiveFileBatch* archiveFileBatch;
+    // Disc of each track for multi-disc archives, empty otherwise.
+    QVector<int> archiveFileTrackDiscs;
 };
 
 #endif
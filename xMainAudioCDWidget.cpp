@@ -100,9 +100,7 @@ xMainAudioCDWidget::xMainAudioCDWidget(QWidget *parent, Qt::WindowFlags flags):
     // Console box.
     auto consoleBox = new QGroupBox(tr("Console"), this);
     consoleBox->setFlat(xRipEncodeUseFlatGroupBox);
-    consoleText = new QTextEdit(consoleBox);
-    consoleText->setAcceptRichText(true);
-    consoleText->setReadOnly(true);
+    consoleText = new xConsoleWidget("audiocd", consoleBox);
     auto consoleLayout = new QGridLayout();
     consoleLayout->addWidget(consoleText, 0, 0, 2, 6);
     consoleBox->setLayout(consoleLayout);
@@ -139,7 +137,7 @@ xMainAudioCDWidget::xMainAudioCDWidget(QWidget *parent, Qt::WindowFlags flags):
 void xMainAudioCDWidget::musicBrainz() {
     // Do not start another lookup while we currently running one.
     if ((audioCDLookup) && (audioCDLookup->isRunning())) {
-        consoleText->append("Lookup already in progress.");
+        consoleText->log("Lookup already in progress.");
         return;
     }
     auto id = audioCD->getID();
@@ -156,7 +154,7 @@ void xMainAudioCDWidget::musicBrainzFinished() {
     lookupResults = audioCDLookup->result();
     if (lookupResults.isEmpty()) {
         // Notify that there are no results.
-        consoleText->append("Lookup failed. No results found.");
+        consoleText->log("Lookup failed. No results found.");
     }
     audioCDLookupResults->clear();
     for (const auto& result : lookupResults) {
@@ -172,10 +170,12 @@ void xMainAudioCDWidget::musicBrainzFinished() {
 void xMainAudioCDWidget::musicBrainzUpdate(int index) {
     if ((index >= 0) && (index < lookupResults.count())) {
         auto result = lookupResults.at(index);
-        result.artist = updateString(result.artist);
-        result.album = updateString(result.album);
+        // Compile the replace list once for all strings.
+        xFileNameReplace replace(xRipEncodeConfiguration::configuration()->getFileNameReplace());
+        result.artist = updateString(result.artist, replace);
+        result.album = updateString(result.album, replace);
         for (auto& track : result.tracks) {
-            track = updateString(track);
+            track = updateString(track, replace);
         }
         audioCDArtistName->setText(result.artist);
         audioCDAlbumName->setText(result.album);
@@ -233,7 +233,7 @@ void xMainAudioCDWidget::rip() {
     // Retrieve selected tracks.
     auto tracks = getTracks();
     if (tracks.isEmpty()) {
-        consoleText->append("No tracks selected.");
+        consoleText->log("No tracks selected.");
         return;
     }
     // Update the UI. Only have "cancel rip" enabled.
@@ -259,22 +259,22 @@ void xMainAudioCDWidget::ripCancel() {
     ripFinished();
 }
 
-void xMainAudioCDWidget::ripMessage(int track, const QString& message) {
+void xMainAudioCDWidget::ripMessage(int track, const QString& message, quint64 jobId) {
     if (track > 0) {
-        consoleText->append(QString("(track %1) %2").arg(track).arg(message));
+        consoleText->log(QString("(track %1) %2").arg(track).arg(message), jobId);
     } else {
-        consoleText->append(message);
+        consoleText->log(message, jobId);
     }
 }
 
-void xMainAudioCDWidget::ripError(int track, const QString& error, bool abort) {
+void xMainAudioCDWidget::ripError(int track, const QString& error, bool abort, quint64 jobId) {
     QString errorMessage;
     if (track > 0) {
         errorMessage = QString("(track %1) %2").arg(track).arg(error);
     } else {
         errorMessage = error;
     }
-    consoleText->append(QString("[%1] %2").arg((abort)?"abort":"error").arg(errorMessage));
+    consoleText->log(QString("[%1] %2").arg((abort)?"abort":"error").arg(errorMessage), jobId);
 }
 
 void xMainAudioCDWidget::ripFinished() {
@@ -298,38 +298,46 @@ void xMainAudioCDWidget::ripFinished() {
 
 QList<xAudioFile*> xMainAudioCDWidget::getTracks() {
     auto jobId = QRandomGenerator::global()->generate64();
+    consoleText->setJobId(jobId);
     auto selectedTracks = audioTracks->getSelected();
     auto artistName = audioCDArtistName->text();
     auto albumName = audioCDAlbumName->text();
     auto tagName = xRipEncodeConfiguration::configuration()->getTags().at(0);
-    auto fileFormat = xRipEncodeConfiguration::configuration()->getFileNameFormat();
     auto tempDirectory = xRipEncodeConfiguration::configuration()->getTempDirectory();
-    fileFormat.replace("(artist)", artistName);
-    fileFormat.replace("(album)", albumName);
-    fileFormat.replace("(tag)", tagName);
+    // Use the year of the selected lookup result if available.
+    QString year;
+    auto lookupIndex = audioCDLookupResults->currentIndex();
+    if ((lookupIndex >= 0) && (lookupIndex < lookupResults.count())) {
+        year = lookupResults.at(lookupIndex).year;
+    }
+    xFileNameTemplate fileNameTemplate(xRipEncodeConfiguration::configuration()->getFileNameFormat());
+    fileNameTemplate.setValue(xFileNameTemplate::FieldArtist, artistName);
+    fileNameTemplate.setValue(xFileNameTemplate::FieldAlbum, albumName);
+    fileNameTemplate.setValue(xFileNameTemplate::FieldTag, tagName);
+    fileNameTemplate.setValue(xFileNameTemplate::FieldYear, year);
+    fileNameTemplate.setValue(xFileNameTemplate::FieldCodec, "cdda");
     QList<xAudioFile*> tracks;
+    QString trackFileName;
     for (const auto& track : selectedTracks) {
-        auto trackFileFormat = fileFormat;
-        trackFileFormat.replace("(tracknr)", std::get<1>(track));
-        trackFileFormat.replace("(trackname)", std::get<2>(track));
-        trackFileFormat.append(".wav");
-        tracks.push_back(new xAudioFileWav(tempDirectory+"/"+trackFileFormat, std::get<0>(track), artistName,
-                                           albumName, std::get<1>(track), std::get<2>(track), tagName, 0, jobId));
+        fileNameTemplate.setValue(xFileNameTemplate::FieldTrackNr, std::get<1>(track));
+        fileNameTemplate.setValue(xFileNameTemplate::FieldTrackName, std::get<2>(track));
+        fileNameTemplate.render(trackFileName);
+        auto file = new xAudioFileWav(tempDirectory+"/"+trackFileName+".wav", std::get<0>(track), artistName,
+                                      albumName, std::get<1>(track), std::get<2>(track), tagName, 0, jobId);
+        file->setYear(year);
+        file->setCodec("cdda");
+        tracks.push_back(file);
     }
     return tracks;
 }
 
-QString xMainAudioCDWidget::updateString(const QString& text) {
+QString xMainAudioCDWidget::updateString(const QString& text, const xFileNameReplace& replace) {
     QString updatedText;
     if (audioCDLowerCase->isChecked()) {
         updatedText = text.toLower();
     } else {
         updatedText = text;
     }
-    auto replace = xRipEncodeConfiguration::configuration()->getFileNameReplace();
-    // Replace all characters if from and to strings are the same length
-    for (const auto& entry : replace) {
-        updatedText.replace(entry.first, entry.second);
-    }
-    return updatedText;
+    // Apply the replace list in a single pass.
+    return replace.apply(updatedText);
 }
\ No newline at end of file
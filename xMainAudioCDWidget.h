@@ -18,13 +18,14 @@
 #include "xAudioCD.h"
 #include "xAudioFile.h"
 #include "xAudioTracksWidget.h"
+#include "xConsoleWidget.h"
+#include "xFileNameTemplate.h"
 #include "xReplaceWidget.h"
 #include <QPushButton>
 #include <QComboBox>
 #include <QCheckBox>
 #include <QSpinBox>
 #include <QListWidget>
-#include <QTextEdit>
 #include <QWidget>
 
 class xMainAudioCDWidget: public QWidget {
@@ -89,16 +90,18 @@ private slots:
      *
      * @param track the ripped track this message belongs to.
      * @param message the message for the ripped track.
+     * @param jobId the job ID of the ripped track.
      */
-    void ripMessage(int track, const QString& message);
+    void ripMessage(int track, const QString& message, quint64 jobId);
     /**
      * Output error messages for the rip thread.
      *
      * @param track the ripped track this error message belongs to.
      * @param error the error message for the ripped track.
      * @param abort indicated if rip for current track was aborted.
+     * @param jobId the job ID of the ripped track.
      */
-    void ripError(int track, const QString& error, bool abort);
+    void ripError(int track, const QString& error, bool abort, quint64 jobId);
     /**
      * Update widget upon finishing the rip thread.
      */
@@ -123,9 +126,10 @@ private:
      * Update strings based on replace strings and lowercase mode.
      *
      * @param text the input as string.
+     * @param replace the compiled replace list.
      * @return an updated string based on the widgets settings.
      */
-    QString updateString(const QString& text);
+    QString updateString(const QString& text, const xFileNameReplace& replace);
 
     QLineEdit* audioCDArtistName;
     QLineEdit* audioCDAlbumName;
@@ -142,7 +146,7 @@ private:
     QPushButton* audioTracksSelectButton;
     QPushButton* audioTracksRipButton;
     QPushButton* audioTracksRipCancelButton;
-    QTextEdit* consoleText;
+    xConsoleWidget* consoleText;
     xAudioCD* audioCD;
     xAudioCDLookup* audioCDLookup;
     QList<xAudioCDLookup::xAudioCDLookupResult> lookupResults;
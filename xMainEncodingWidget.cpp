@@ -14,7 +14,11 @@
 
 #include "xMainEncodingWidget.h"
 #include "xRipEncodeConfiguration.h"
+#include "xFileNameTemplate.h"
+#include "xTempSpace.h"
 
+#include <QMessageBox>
+#include <QFile>
 #include <QListWidget>
 #include <QLineEdit>
 #include <QGridLayout>
@@ -22,10 +26,19 @@
 #include <QButtonGroup>
 #include <QGroupBox>
 #include <QLabel>
+#include <QSet>
+#include <algorithm>
 
 xMainEncodingWidget::xMainEncodingWidget(QWidget *parent, Qt::WindowFlags flags):
         QWidget(parent, flags),
-        encoding(nullptr) {
+        encoding(nullptr),
+        encodingFiles(),
+        fingerprinting(nullptr),
+        fingerprintingFiles(),
+        fingerprintingQueue(),
+        fingerprintIndex(),
+        batchQueue(),
+        batchEncoding(false) {
 
     auto mainLayout = new QGridLayout(this);
     // Create Format Box
@@ -116,6 +129,13 @@ xMainEncodingWidget::xMainEncodingWidget(QWidget *parent, Qt::WindowFlags flags)
     encodingLayout->addWidget(encodingOutputAllButton, 9, 0);
     encodingLayout->addWidget(encodingEditAllButton, 9, 1);
     encodingBox->setLayout(encodingLayout);
+    // Console box.
+    auto consoleBox = new QGroupBox(tr("Console"), this);
+    consoleBox->setFlat(xRipEncodeUseFlatGroupBox);
+    consoleText = new xConsoleWidget("encoding", consoleBox);
+    auto consoleLayout = new QGridLayout();
+    consoleLayout->addWidget(consoleText, 0, 0, 2, 2);
+    consoleBox->setLayout(consoleLayout);
     // Setup main layout
     mainLayout->addWidget(formatBox, 0, 0, 2, 2);
     mainLayout->setRowMinimumHeight(2, 20);
@@ -124,6 +144,7 @@ xMainEncodingWidget::xMainEncodingWidget(QWidget *parent, Qt::WindowFlags flags)
     mainLayout->setRowMinimumHeight(5, 20);
     mainLayout->setRowStretch(5, 0);
     mainLayout->addWidget(encodeBox, 6, 0, 3, 2);
+    mainLayout->addWidget(consoleBox, 10, 0, 1, 2);
     mainLayout->setRowStretch(10, 2);
     mainLayout->addWidget(encodingBox, 0, 3, 11, 7);
     // Fill in configuration.
@@ -139,6 +160,8 @@ xMainEncodingWidget::xMainEncodingWidget(QWidget *parent, Qt::WindowFlags flags)
     connect(encodingOutputAllButton, &QPushButton::pressed, this, &xMainEncodingWidget::outputAll);
     connect(encodingSelectAllButton, &QPushButton::pressed, this, &xMainEncodingWidget::selectAll);
     connect(encodingDeselectAllButton, &QPushButton::pressed, this, &xMainEncodingWidget::deselectAll);
+    // Fingerprints of all previously encoded tracks.
+    fingerprintIndex.load();
     // Enable buttons.
     enableButtons(true);
 }
@@ -219,14 +242,22 @@ void xMainEncodingWidget::encode() {
     auto currentIndex = encodingTracksTab->currentIndex();
     if ((currentIndex >= 0) && (currentIndex < encodingTracksWidgets.count())) {
         auto encodingDirectory = xRipEncodeConfiguration::configuration()->getEncodingDirectory();
-        QList<std::pair<xAudioFile*,QString>> encodingFiles;
+        encodingFiles.clear();
         for (auto& selected : encodingTracksWidgets[currentIndex]->getSelected()) {
-            encodingFiles.push_back(std::make_pair(selected->getAudioFile(), encodingDirectory+"/"+selected->getEncodedFileName()+".flac"));
+            encodingFiles.push_back(std::make_pair(selected.first, encodingDirectory+"/"+selected.second+".flac"));
         }
         if (!encodingFiles.isEmpty()) {
+            // Tracks of batch jobs encoded manually are not encoded again.
+            QList<xAudioFile*> files;
+            for (const auto& encodingFile : encodingFiles) {
+                files.push_back(encodingFile.first);
+            }
+            dequeueBatch(files);
             enableButtons(false);
             encoding = new xAudioFileEncoding(encodingFiles, true);
             connect(encoding, &xAudioFileEncoding::encodingProgress,encodingTracksWidgets[currentIndex], &xEncodingTracksWidget::ripProgress);
+            connect(encoding, &xAudioFileEncoding::encodingVerified, encodingTracksWidgets[currentIndex], &xEncodingTracksWidget::verifyResult);
+            connect(encoding, &xAudioFileEncoding::messages, this, &xMainEncodingWidget::messages);
             connect(encoding, &xAudioFileEncoding::finished, this, &xMainEncodingWidget::encodeFinished);
             encoding->start();
         }
@@ -235,24 +266,61 @@ void xMainEncodingWidget::encode() {
 
 void xMainEncodingWidget::encodeFinished() {
     qDebug() << "xMainEncodingWidget::encodeFinished";
+    // Tracks are numbered from 1..n.
+    QList<xAudioFile*> failedFiles;
+    for (const auto& track : encoding->getFailed()) {
+        if ((track > 0) && (track <= encodingFiles.count())) {
+            failedFiles.push_back(encodingFiles[track-1].first);
+        }
+    }
     delete encoding;
     encoding = nullptr;
-    encodingTracksWidgets[encodingTracksTab->currentIndex()]->setEnabled(false);
-    enableButtons(true);
+    // Add the encoded tracks to the fingerprint index. Use the tags as encoded.
+    for (const auto& encodedFile : encodingFiles) {
+        if ((encodedFile.first->getFingerprint()) && (!failedFiles.contains(encodedFile.first)) &&
+            (QFile::exists(encodedFile.second))) {
+            auto encodedFingerprint = *encodedFile.first->getFingerprint();
+            encodedFingerprint.artist = encodedFile.first->getArtist();
+            encodedFingerprint.album = encodedFile.first->getAlbum();
+            encodedFingerprint.trackName = encodedFile.first->getTrackName();
+            fingerprintIndex.add(encodedFingerprint);
+        }
+    }
+    fingerprintIndex.save();
+    if (batchEncoding) {
+        // Remove the encoded tracks of the batch job. Their temporary files are deleted.
+        // Failed tracks and their temporary files are kept to be encoded manually.
+        for (const auto& encodedFile : encodingFiles) {
+            if (!failedFiles.contains(encodedFile.first)) {
+                removeAudioFile(encodedFile.first);
+            } else {
+                xTempSpace::tempSpace()->release(encodedFile.first->getFileName());
+            }
+        }
+        encodingFiles.clear();
+        batchEncoding = false;
+        createEncodingTracksWidgets();
+    } else {
+        encodingFiles.clear();
+        encodingTracksWidgets[encodingTracksTab->currentIndex()]->setEnabled(false);
+    }
+    enableButtons(fingerprinting == nullptr);
+    encodeBatch();
 }
 
 void xMainEncodingWidget::backup() {
     auto currentIndex = encodingTracksTab->currentIndex();
     if ((currentIndex >= 0) && (currentIndex < encodingTracksWidgets.count())) {
         auto backupDirectory = xRipEncodeConfiguration::configuration()->getBackupDirectory();
-        QList<std::pair<xAudioFile*,QString>> encodingFiles;
+        encodingFiles.clear();
         for (auto& selected : encodingTracksWidgets[currentIndex]->getSelected()) {
-            encodingFiles.push_back(std::make_pair(selected->getAudioFile(), backupDirectory+"/"+selected->getEncodedFileName()+".wv"));
+            encodingFiles.push_back(std::make_pair(selected.first, backupDirectory+"/"+selected.second+".wv"));
         }
         if (!encodingFiles.isEmpty()) {
             enableButtons(false);
             encoding = new xAudioFileEncoding(encodingFiles, false);
             connect(encoding, &xAudioFileEncoding::encodingProgress,encodingTracksWidgets[currentIndex], &xEncodingTracksWidget::ripProgress);
+            connect(encoding, &xAudioFileEncoding::messages, this, &xMainEncodingWidget::messages);
             connect(encoding, &xAudioFileEncoding::finished, this, &xMainEncodingWidget::backupFinished);
             encoding->start();
         }
@@ -263,8 +331,78 @@ void xMainEncodingWidget::backupFinished() {
     qDebug() << "xMainEncodingWidget::backupFinished";
     delete encoding;
     encoding = nullptr;
+    encodingFiles.clear();
     encodingTracksWidgets[encodingTracksTab->currentIndex()]->setEnabled(false);
-    enableButtons(true);
+    enableButtons(fingerprinting == nullptr);
+}
+
+void xMainEncodingWidget::fingerprint() {
+    fingerprintingFiles = fingerprintingQueue;
+    fingerprintingQueue.clear();
+    enableButtons(false);
+    // The fingerprints of the pending tracks are compared in the fingerprinting thread.
+    QList<std::pair<xAudioFile*,xAudioFingerprint>> pending;
+    for (const auto& tagFiles : encodingAudioFiles) {
+        for (const auto& pendingFile : tagFiles) {
+            if ((pendingFile->getFingerprint()) && (!fingerprintingFiles.contains(pendingFile))) {
+                pending.push_back(std::make_pair(pendingFile, *pendingFile->getFingerprint()));
+            }
+        }
+    }
+    fingerprinting = new xAudioFileFingerprinting(fingerprintingFiles, fingerprintIndex, pending);
+    connect(fingerprinting, &xAudioFileFingerprinting::finished, this, &xMainEncodingWidget::fingerprintFinished);
+    fingerprinting->start();
+}
+
+void xMainEncodingWidget::fingerprintFinished() {
+    qDebug() << "xMainEncodingWidget::fingerprintFinished";
+    // The duplicates were determined in the fingerprinting thread.
+    auto duplicates = fingerprinting->getDuplicates();
+    auto lowerResolutionFiles = fingerprinting->getLowerResolutionFiles();
+    delete fingerprinting;
+    fingerprinting = nullptr;
+    // Files currently encoded cannot be removed.
+    for (const auto& encodedFile : encodingFiles) {
+        lowerResolutionFiles.removeAll(encodedFile.first);
+    }
+    // Batch jobs run unattended. Their duplicates are only reported.
+    auto interactive = std::any_of(fingerprintingFiles.begin(), fingerprintingFiles.end(), [this](xAudioFile* file) {
+        return !batchQueue.contains(file);
+    });
+    if ((!duplicates.isEmpty()) && (interactive)) {
+        qWarning() << "xMainEncodingWidget::fingerprintFinished: duplicates: " << duplicates;
+        if (lowerResolutionFiles.isEmpty()) {
+            QMessageBox::information(this, tr("Duplicate Tracks"), duplicates.join("\n"));
+        } else if (QMessageBox::question(this, tr("Duplicate Tracks"), duplicates.join("\n")+"\n\n"+
+                                         tr("Keep only the higher resolution versions?")) == QMessageBox::Yes) {
+            dequeueBatch(lowerResolutionFiles);
+            for (const auto& file : lowerResolutionFiles) {
+                // A file may be lower resolution than several duplicates.
+                if (fingerprintingFiles.removeAll(file) > 0) {
+                    removeAudioFile(file);
+                }
+            }
+            createEncodingTracksWidgets();
+        }
+    } else if (!duplicates.isEmpty()) {
+        qWarning() << "xMainEncodingWidget::fingerprintFinished: batch duplicates: " << duplicates;
+    }
+    fingerprintingFiles.clear();
+    if (!fingerprintingQueue.isEmpty()) {
+        fingerprint();
+    } else {
+        enableButtons(encoding == nullptr);
+        encodeBatch();
+    }
+}
+
+void xMainEncodingWidget::removeAudioFile(xAudioFile* file) {
+    for (auto& tagFiles : encodingAudioFiles) {
+        if (tagFiles.removeOne(file)) {
+            delete file;
+            return;
+        }
+    }
 }
 
 
@@ -272,6 +410,7 @@ void xMainEncodingWidget::clear() {
     auto currentIndex = encodingTracksTab->currentIndex();
     if ((currentIndex >= 0) && (currentIndex < encodingTracksWidgets.count())) {
         encodingTracksWidgets[currentIndex]->clear();
+        dequeueBatch(QList<xAudioFile*>(encodingAudioFiles[currentIndex].begin(), encodingAudioFiles[currentIndex].end()));
         // Delete the corresponding audio file objects before clearing.
         for (auto& audioFile : encodingAudioFiles[currentIndex]) {
             delete audioFile;
@@ -281,6 +420,54 @@ void xMainEncodingWidget::clear() {
     }
 }
 
+void xMainEncodingWidget::messages(const QString& msg) {
+    consoleText->log(msg);
+}
+
+void xMainEncodingWidget::encodeBatch() {
+    // Wait for the running encoding and the duplicate check of the received tracks.
+    if ((encoding != nullptr) || (fingerprinting != nullptr) || (batchQueue.isEmpty())) {
+        return;
+    }
+    // Encode all tracks of the oldest batch job.
+    auto jobId = batchQueue.first()->getJobId();
+    auto encodingDirectory = xRipEncodeConfiguration::configuration()->getEncodingDirectory();
+    xFileNameTemplate encodedFormat((encodeUseFileButton->isChecked()) ? formatFileFormatInput->text() : formatEncodingFormatInput->text());
+    QList<xAudioFile*> files;
+    QString encodedFileName;
+    encodingFiles.clear();
+    for (const auto& file : batchQueue) {
+        if (file->getJobId() == jobId) {
+            encodedFormat.setValues(file);
+            encodedFormat.render(encodedFileName);
+            encodingFiles.push_back(std::make_pair(file, encodingDirectory+"/"+encodedFileName+".flac"));
+            files.push_back(file);
+        }
+    }
+    dequeueBatch(files);
+    batchEncoding = true;
+    enableButtons(false);
+    encoding = new xAudioFileEncoding(encodingFiles, true);
+    connect(encoding, &xAudioFileEncoding::messages, this, &xMainEncodingWidget::messages);
+    connect(encoding, &xAudioFileEncoding::finished, this, &xMainEncodingWidget::encodeFinished);
+    encoding->start();
+}
+
+void xMainEncodingWidget::dequeueBatch(const QList<xAudioFile*>& files) {
+    QSet<quint64> jobIds;
+    for (const auto& file : files) {
+        if (batchQueue.removeAll(file) > 0) {
+            jobIds.insert(file->getJobId());
+        }
+    }
+    for (const auto& file : batchQueue) {
+        jobIds.remove(file->getJobId());
+    }
+    for (const auto& jobId : jobIds) {
+        emit batchDequeued(jobId);
+    }
+}
+
 void xMainEncodingWidget::updateEncodedFileNames() {
     auto encodedFormat = (encodeUseFileButton->isChecked()) ? formatFileFormatInput->text() : formatEncodingFormatInput->text();
     for (const auto& widget : encodingTracksWidgets) {
@@ -300,11 +487,26 @@ void xMainEncodingWidget::createEncodingTracksWidgets() {
     updateButtons();
 }
 
+void xMainEncodingWidget::batchAudioFiles(const QList<xAudioFile*>& files) {
+    // Queue before the duplicate check is started.
+    batchQueue.append(files);
+    audioFiles(files);
+}
+
 void xMainEncodingWidget::audioFiles(const QList<xAudioFile*>& files) {
     // Split among the Tag IDs.
     for (const auto& file : files) {
         encodingAudioFiles[file->getTagId()].push_back(file);
+        // Files of manual jobs wait for the user and must not block the producers.
+        if (!batchQueue.contains(file)) {
+            xTempSpace::tempSpace()->release(file->getFileName());
+        }
     }
     createEncodingTracksWidgets();
     updateEncodedFileNames();
+    // Check for duplicates before the files are encoded.
+    fingerprintingQueue.append(files);
+    if (fingerprinting == nullptr) {
+        fingerprint();
+    }
 }
\ No newline at end of file
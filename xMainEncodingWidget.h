@@ -16,7 +16,9 @@
 #define __XMAINENCODINGWIDGET_H__
 
 #include "xAudioFile.h"
+#include "xAudioFingerprint.h"
 #include "xEncodingTracksWidget.h"
+#include "xConsoleWidget.h"
 #include <QTabWidget>
 #include <QRadioButton>
 #include <QCheckBox>
@@ -45,6 +47,22 @@ public slots:
      * @param files the list of audio file objects to be added.
      */
     void audioFiles(const QList<xAudioFile*>& files);
+    /**
+     * Add the audio file objects of a batch job. The audio files are encoded
+     * without interaction after the duplicate check, one job at a time.
+     *
+     * @param files the list of audio file objects to be added.
+     */
+    void batchAudioFiles(const QList<xAudioFile*>& files);
+
+signals:
+    /**
+     * Signal emitted once no audio file of the batch job is queued anymore,
+     * i.e. the job is encoded, currently encoded or has been removed.
+     *
+     * @param jobId the job ID of the batch job.
+     */
+    void batchDequeued(quint64 jobId);
 
 private slots:
     void enableButtons(bool enabled);
@@ -83,10 +101,21 @@ private slots:
      * Enable buttons after the encoding thread is finished.
      */
     void backupFinished();
+    /**
+     * Check the fingerprints of the received audio files for duplicates. Offer to
+     * keep only the higher resolution versions. Start the next fingerprinting if queued.
+     */
+    void fingerprintFinished();
     /**
      * Remove all items of the current encoding tab. Delete the corresponding audio file objects.
      */
     void clear();
+    /**
+     * Update the console.
+     *
+     * @param msg the message appended to the console as string.
+     */
+    void messages(const QString& msg);
 
 private:
     /**
@@ -97,6 +126,28 @@ private:
      * Create encoding tab widget with encoding track items.
      */
     void createEncodingTracksWidgets();
+    /**
+     * Start the fingerprinting thread for all queued audio files. Disable buttons.
+     */
+    void fingerprint();
+    /**
+     * Remove the audio file from the encoding tracks and delete the audio file object.
+     *
+     * @param file pointer to the audio file object.
+     */
+    void removeAudioFile(xAudioFile* file);
+    /**
+     * Start the encoding thread for the next queued batch job if neither
+     * an encoding nor a fingerprinting thread is running.
+     */
+    void encodeBatch();
+    /**
+     * Remove the audio files from the batch queue. Signal the batch jobs
+     * without any queued audio files.
+     *
+     * @param files the list of audio file objects.
+     */
+    void dequeueBatch(const QList<xAudioFile*>& files);
 
     QVector<QVector<xAudioFile*>> encodingAudioFiles;
     QLineEdit* formatEncodingFormatInput;
@@ -116,7 +167,15 @@ private:
     QPushButton* encodingOutputAllButton;
     QTabWidget* encodingTracksTab;
     QVector<xEncodingTracksWidget*> encodingTracksWidgets;
+    xConsoleWidget* consoleText;
     xAudioFileEncoding* encoding;
+    QList<std::pair<xAudioFile*,QString>> encodingFiles;
+    xAudioFileFingerprinting* fingerprinting;
+    QList<xAudioFile*> fingerprintingFiles;
+    QList<xAudioFile*> fingerprintingQueue;
+    xAudioFingerprintIndex fingerprintIndex;
+    QList<xAudioFile*> batchQueue;
+    bool batchEncoding;
 };
 
 #endif
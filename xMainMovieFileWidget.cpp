@@ -14,6 +14,8 @@
 
 #include "xMainMovieFileWidget.h"
 #include "xRipEncodeConfiguration.h"
+#include "xFileNameTemplate.h"
+#include "xMovieFileDemux.h"
 #include <QFileDialog>
 #include <QGridLayout>
 #include <QDir>
@@ -60,6 +62,10 @@ xMainMovieFileWidget::xMainMovieFileWidget(QWidget *parent, Qt::WindowFlags flag
     movieFileAudioDownMix = new QCheckBox(tr("Down Mix"), movieFileBox);
     movieFileAudioDownMix->setChecked(false);
     movieFileAudioDownMix->setEnabled(false);
+    movieFileAudioCDQuality = new QCheckBox(tr("CD Quality"), movieFileBox);
+    movieFileAudioCDQuality->setToolTip(tr("Add a 44.1kHz/16bit derivative of HD audio streams"));
+    movieFileAudioCDQuality->setChecked(false);
+    movieFileAudioCDQuality->setEnabled(false);
     movieFileLayout->addWidget(movieFileAudioTracksLabel, 8, 0, 1, 6);
     movieFileLayout->addWidget(movieFileAudioStreamInfos, 9, 0, 3, 6);
     movieFileLayout->setRowMinimumHeight(12, 20);
@@ -68,12 +74,13 @@ xMainMovieFileWidget::xMainMovieFileWidget(QWidget *parent, Qt::WindowFlags flag
     movieFileLayout->addWidget(movieFileAudioDownMix, 13, 2, 1, 2);
     movieFileLayout->addWidget(movieFileTrackOffsetLabel, 13, 4, 1, 1);
     movieFileLayout->addWidget(movieFileTrackOffset, 13, 5, 1, 1);
-    movieFileLayout->setRowMinimumHeight(14, 50);
-    movieFileLayout->setRowStretch(14, 0);
-    movieFileLayout->addWidget(movieFileAnalyzeButton, 15, 0, 1, 3);
-    movieFileLayout->addWidget(movieFileAutofillButton, 15, 3, 1, 3);
-    movieFileLayout->setRowMinimumHeight(16, 20);
-    movieFileLayout->setRowStretch(16, 0);
+    movieFileLayout->addWidget(movieFileAudioCDQuality, 14, 2, 1, 2);
+    movieFileLayout->setRowMinimumHeight(15, 30);
+    movieFileLayout->setRowStretch(15, 0);
+    movieFileLayout->addWidget(movieFileAnalyzeButton, 16, 0, 1, 3);
+    movieFileLayout->addWidget(movieFileAutofillButton, 16, 3, 1, 3);
+    movieFileLayout->setRowMinimumHeight(17, 20);
+    movieFileLayout->setRowStretch(17, 0);
     movieFileBox->setLayout(movieFileLayout);
     // Audio tracks box.
     auto movieAudioTracksBox = new QGroupBox(tr("Audio Tracks"), this);
@@ -97,9 +104,7 @@ xMainMovieFileWidget::xMainMovieFileWidget(QWidget *parent, Qt::WindowFlags flag
     // Console box.
     auto consoleBox = new QGroupBox(tr("Console"), this);
     consoleBox->setFlat(xRipEncodeUseFlatGroupBox);
-    consoleText = new QTextEdit(consoleBox);
-    consoleText->setAcceptRichText(true);
-    consoleText->setReadOnly(true);
+    consoleText = new xConsoleWidget("movie", consoleBox);
     auto consoleLayout = new QGridLayout();
     consoleLayout->addWidget(consoleText, 0, 0, 2, 6);
     consoleBox->setLayout(consoleLayout);
@@ -153,10 +158,20 @@ void xMainMovieFileWidget::openFile() {
 }
 
 void xMainMovieFileWidget::analyze() {
+    // Keep the view of the running analysis.
+    if (movieFile->isAnalyzing()) {
+        consoleText->log("[analyze] analysis already in progress");
+        return;
+    }
     // Reset artist, album and track offset on analyzing the file.
     movieFileArtistName->clear();
     movieFileAlbumName->clear();
     movieFileTrackOffset->setValue(0);
+    // Analysis runs in the background. The tracks of the previous movie file cannot be
+    // selected anymore. Rip is enabled again once the track lengths are available.
+    movieAudioTracks->setEnabled(false);
+    movieAudioTracksSelectButton->setEnabled(false);
+    movieAudioTracksRipButton->setEnabled(false);
     movieFile->analyze(movieFileName->text());
 }
 
@@ -180,16 +195,22 @@ void xMainMovieFileWidget::audioStreamInfoSelection() {
         movieFileAudioStreamTag->setEnabled(true);
     }
     movieAudioTracksRipButton->setEnabled(isRipButtonEnabled());
+    auto downMix = false;
+    auto cdQuality = false;
     for (const auto& item : items) {
         auto streamInfo = movieFile->getAudioStreamInfo(movieFileAudioStreamInfos->row(item));
-        if (streamInfo.channels > 2) {
-            movieFileAudioDownMix->setEnabled(true);
-            return;
-        }
+        downMix = (downMix) || (streamInfo.channels > 2);
+        cdQuality = (cdQuality) || (streamInfo.bitsPerSample > 16);
     }
-    // Reset down mix.
-    movieFileAudioDownMix->setChecked(false);
-    movieFileAudioDownMix->setEnabled(false);
+    // Reset down mix and CD quality if not applicable.
+    if (!downMix) {
+        movieFileAudioDownMix->setChecked(false);
+    }
+    movieFileAudioDownMix->setEnabled(downMix);
+    if (!cdQuality) {
+        movieFileAudioCDQuality->setChecked(false);
+    }
+    movieFileAudioCDQuality->setEnabled(cdQuality);
 }
 
 void xMainMovieFileWidget::trackLengths(const QVector<qint64>& lengths) {
@@ -202,30 +223,46 @@ void xMainMovieFileWidget::trackLengths(const QVector<qint64>& lengths) {
 
 void xMainMovieFileWidget::rip() {
     auto jobId = QRandomGenerator::global()->generate64();
+    consoleText->setJobId(jobId);
     auto audioStreams = movieFileAudioStreamInfos->selectedItems();
     auto downMix = movieFileAudioDownMix->isChecked();
+    auto cdQuality = movieFileAudioCDQuality->isChecked();
     auto tags = xRipEncodeConfiguration::configuration()->getTags();
     qDebug() << "xMainMovieFileWidget::rip: tags: " << tags;
     for (const auto& audioStream : audioStreams) {
         auto audioStreamIndex = movieFileAudioStreamInfos->row(audioStream);
         auto audioStreamInfo = movieFile->getAudioStreamInfo(audioStreamIndex);
+        // FLAC and PCM streams are ripped into flac files unless down mixed.
+        auto passthrough = (xRipEncodeConfiguration::configuration()->getMovieFileDemux()) &&
+                           (xRipEncodeConfiguration::configuration()->getMovieFilePassthrough()) &&
+                           (xMovieFileDemux::isPassthrough(audioStreamInfo.codecName));
         if (audioStreamInfo.channels > 2) {
             if (audioStreamInfo.bitsPerSample > 16) {
-                movieFile->queueRip(getAudioFiles(tags[3].arg(audioStreamInfo.channels-1), 3, jobId), audioStreamIndex, false);
+                movieFile->queueRip(getAudioFiles(tags[3].arg(audioStreamInfo.channels-1), 3, audioStreamInfo.codecName, jobId, passthrough), audioStreamIndex, false);
                 if (downMix) {
-                    movieFile->queueRip(getAudioFiles(tags[1], 1, jobId), audioStreamIndex, true);
+                    movieFile->queueRip(getAudioFiles(tags[1], 1, audioStreamInfo.codecName, jobId), audioStreamIndex, true);
+                }
+                // The CD quality derivatives are created from the same decode.
+                if (cdQuality) {
+                    movieFile->queueRip(getAudioFiles(tags[2].arg(audioStreamInfo.channels-1), 2, audioStreamInfo.codecName, jobId), audioStreamIndex, false, true);
+                    if (downMix) {
+                        movieFile->queueRip(getAudioFiles(tags[0], 0, audioStreamInfo.codecName, jobId), audioStreamIndex, true, true);
+                    }
                 }
             } else {
-                movieFile->queueRip(getAudioFiles(tags[2].arg(audioStreamInfo.channels-1), 2, jobId), audioStreamIndex, false);
+                movieFile->queueRip(getAudioFiles(tags[2].arg(audioStreamInfo.channels-1), 2, audioStreamInfo.codecName, jobId, passthrough), audioStreamIndex, false);
                 if (downMix) {
-                    movieFile->queueRip(getAudioFiles(tags[0], 0, jobId), audioStreamIndex, true);
+                    movieFile->queueRip(getAudioFiles(tags[0], 0, audioStreamInfo.codecName, jobId), audioStreamIndex, true);
                 }
             }
         } else {
             if (audioStreamInfo.bitsPerSample > 16) {
-                movieFile->queueRip(getAudioFiles(tags[1], 1, jobId), audioStreamIndex, false);
+                movieFile->queueRip(getAudioFiles(tags[1], 1, audioStreamInfo.codecName, jobId, passthrough), audioStreamIndex, false);
+                if (cdQuality) {
+                    movieFile->queueRip(getAudioFiles(tags[0], 0, audioStreamInfo.codecName, jobId), audioStreamIndex, false, true);
+                }
             } else {
-                movieFile->queueRip(getAudioFiles(tags[0], 0, jobId), audioStreamIndex, false);
+                movieFile->queueRip(getAudioFiles(tags[0], 0, audioStreamInfo.codecName, jobId, passthrough), audioStreamIndex, false);
             }
         }
     }
@@ -246,14 +283,16 @@ void xMainMovieFileWidget::rip() {
 }
 
 void xMainMovieFileWidget::ripCancel() {
+    // Abort the wait for temp space.
+    movieFile->requestInterruption();
     ripFinished();
 }
 
 void xMainMovieFileWidget::ripMessage(int track, const QString& message) {
     if (track > 0) {
-        consoleText->append(QString("(track %1) %2").arg(track).arg(message));
+        consoleText->log(QString("(track %1) %2").arg(track).arg(message));
     } else {
-        consoleText->append(message);
+        consoleText->log(message);
     }
 }
 
@@ -264,7 +303,7 @@ void xMainMovieFileWidget::ripError(int track, const QString& error, bool abort)
     } else {
         errorMessage = error;
     }
-    consoleText->append(QString("[%1] %2").arg((abort)?"abort":"error").arg(errorMessage));
+    consoleText->log(QString("[%1] %2").arg((abort)?"abort":"error").arg(errorMessage));
 }
 
 void xMainMovieFileWidget::ripFinished() {
@@ -284,28 +323,38 @@ void xMainMovieFileWidget::ripFinished() {
     movieAudioTracks->setEnabled(false);
 }
 
-void xMainMovieFileWidget::messages(const QString& msg) {
-    consoleText->append(msg);
+void xMainMovieFileWidget::messages(const QString& msg, quint64 jobId) {
+    consoleText->log(msg, jobId);
 }
 
-QList<xAudioFile*> xMainMovieFileWidget::getAudioFiles(const QString& tag, int tagId, quint64 jobId) {
+QList<xAudioFile*> xMainMovieFileWidget::getAudioFiles(const QString& tag, int tagId, const QString& codec,
+                                                       quint64 jobId, bool passthrough) {
     auto selectedTracks = movieAudioTracks->getSelected();
     auto artistName = movieFileArtistName->text();
     auto albumName = movieFileAlbumName->text();
-    auto fileFormat = xRipEncodeConfiguration::configuration()->getFileNameFormat();
     auto tempDirectory = xRipEncodeConfiguration::configuration()->getTempDirectory();
-    fileFormat.replace("(artist)", artistName);
-    fileFormat.replace("(album)", albumName);
+    xFileNameTemplate fileNameTemplate(xRipEncodeConfiguration::configuration()->getFileNameFormat());
+    fileNameTemplate.setValue(xFileNameTemplate::FieldArtist, artistName);
+    fileNameTemplate.setValue(xFileNameTemplate::FieldAlbum, albumName);
     // The tag should contain any separators such as a space.
-    fileFormat.replace("(tag)", tag);
+    fileNameTemplate.setValue(xFileNameTemplate::FieldTag, tag);
+    fileNameTemplate.setValue(xFileNameTemplate::FieldCodec, codec);
     QList<xAudioFile*> files;
+    QString trackFileName;
     for (const auto& track : selectedTracks) {
-        auto trackFileFormat = fileFormat;
-        trackFileFormat.replace("(tracknr)", std::get<1>(track));
-        trackFileFormat.replace("(trackname)", std::get<2>(track));
-        trackFileFormat.append(".wav");
-        files.push_back(new xAudioFileWav(tempDirectory+"/"+trackFileFormat, std::get<0>(track), artistName,
-                                          albumName, std::get<1>(track), std::get<2>(track), tag, tagId, jobId));
+        fileNameTemplate.setValue(xFileNameTemplate::FieldTrackNr, std::get<1>(track));
+        fileNameTemplate.setValue(xFileNameTemplate::FieldTrackName, std::get<2>(track));
+        fileNameTemplate.render(trackFileName);
+        xAudioFile* file;
+        if (passthrough) {
+            file = new xAudioFileFlac(tempDirectory+"/"+trackFileName+".flac", std::get<0>(track), artistName,
+                                      albumName, std::get<1>(track), std::get<2>(track), tag, tagId, jobId);
+        } else {
+            file = new xAudioFileWav(tempDirectory+"/"+trackFileName+".wav", std::get<0>(track), artistName,
+                                     albumName, std::get<1>(track), std::get<2>(track), tag, tagId, jobId);
+        }
+        file->setCodec(codec);
+        files.push_back(file);
     }
     return files;
 }
@@ -314,6 +363,7 @@ bool xMainMovieFileWidget::isRipButtonEnabled() {
     // Only enable rip button if artist and album is non-empty
     // and the audio streams and tracks are selected.
     return (movieFileAudioStreamInfos->selectedItems().count() != 0) &&
+           (movieAudioTracks->isEnabled()) &&
            (movieAudioTracks->isSelected()) &&
            (!movieFileArtistName->text().isEmpty()) &&
            (!movieFileAlbumName->text().isEmpty()) &&
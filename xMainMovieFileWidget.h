@@ -17,12 +17,12 @@
 
 #include "xMovieFile.h"
 #include "xAudioTracksWidget.h"
+#include "xConsoleWidget.h"
 #include <QPushButton>
 #include <QComboBox>
 #include <QCheckBox>
 #include <QSpinBox>
 #include <QListWidget>
-#include <QTextEdit>
 #include <QWidget>
 
 class xMainMovieFileWidget: public QWidget {
@@ -115,8 +115,9 @@ private slots:
      * Update the console.
      *
      * @param msg the message appended to the console as string.
+     * @param jobId the job ID the message belongs to, 0 if none.
      */
-    void messages(const QString& msg);
+    void messages(const QString& msg, quint64 jobId);
 
 private:
     /**
@@ -124,10 +125,12 @@ private:
      *
      * @param tag the HD/multi-channel tag to be used.
      * @param tagId the corresponding tag ID.
+     * @param codec the codec of the audio stream.
      * @param jobId the job ID the files belong to.
+     * @param passthrough rip into flac files instead of wav files if true.
      * @return a list of audio file objects containing the necessary information.
      */
-    QList<xAudioFile*> getAudioFiles(const QString& tag, int tagId, quint64 jobId);
+    QList<xAudioFile*> getAudioFiles(const QString& tag, int tagId, const QString& codec, quint64 jobId, bool passthrough=false);
     /**
      * Determine the state of the rip button.
      *
@@ -143,13 +146,14 @@ private:
     QPushButton* movieFileDialogButton;
     QSpinBox* movieFileTrackOffset;
     QCheckBox* movieFileAudioDownMix;
+    QCheckBox* movieFileAudioCDQuality;
     QCheckBox* movieFileAudioStreamTag;
     QListWidget* movieFileAudioStreamInfos;
     xAudioTracksWidget* movieAudioTracks;
     QPushButton* movieAudioTracksSelectButton;
     QPushButton* movieAudioTracksRipButton;
     QPushButton* movieAudioTracksRipCancelButton;
-    QTextEdit* consoleText;
+    xConsoleWidget* consoleText;
     xMovieFile* movieFile;
 };
 
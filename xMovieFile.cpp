@@ -13,20 +13,190 @@
  */
 
 #include "xMovieFile.h"
+#include "xMovieFileDemux.h"
+#include "xTempSpace.h"
 #include "xRipEncodeConfiguration.h"
 #include <QRegularExpression>
 #include <QTemporaryFile>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QDir>
+#include <QSet>
+#include <QTime>
 #include <QDebug>
 
-#include <boost/property_tree/ptree.hpp>
-#include <boost/property_tree/json_parser.hpp>
+#include <algorithm>
 
 const char* xMovieFile_TemporaryFileBase { "riptmpfile" };
+// Matchers for the mkvmerge output in gui mode.
+const QRegularExpression xMovieFile_MKVMergeProgress { R"(^#GUI#progress\s+(\d+)%)" };
+const QRegularExpression xMovieFile_MKVMergeOpened { R"(The file '.*-(\d\d\d)' has been opened for writing)" };
 const QStringList xMovieFile_HighResProfiles { "DTS-HD HRA", "DTS 96/24", "DTS 48/24" };
+// Sample rate and bits per sample of CD quality derivatives.
+const int xMovieFile_DerivativeSampleRate { 44100 };
+const int xMovieFile_DerivativeBitsPerSample { 16 };
+// Increase the version if the cached analysis results change.
+const quint32 xMovieFileAnalyze_CacheVersion { 2 };
 
+/**
+ * xMovieFileAnalyze
+ *
+ * This class analyzes the movie file in a separate thread. The results are
+ * cached using the path, modification time and size of the movie file.
+ */
+xMovieFileAnalyze::xMovieFileAnalyze(const QString& file, QObject* parent):
+        QThread(parent),
+        movieFile(file) {
+    movieFileResult.valid = false;
+    movieFileResult.cached = false;
+}
+
+const xMovieFileAnalyzeResult& xMovieFileAnalyze::result() const {
+    return movieFileResult;
+}
+
+void xMovieFileAnalyze::run() {
+    auto fileName = cacheFileName();
+    if ((!fileName.isEmpty()) && (readCache(fileName))) {
+        movieFileResult.valid = true;
+        movieFileResult.cached = true;
+        return;
+    }
+    movieFileResult.valid = analyzeFFProbe();
+    if ((movieFileResult.valid) && (!fileName.isEmpty())) {
+        writeCache(fileName);
+    }
+}
+
+bool xMovieFileAnalyze::analyzeFFProbe() {
+    // Start ffprobe in order to analyze the movie file.
+    QProcess ffprobe;
+    ffprobe.start(xRipEncodeConfiguration::configuration()->getFFProbe(),
+                  { {"-v"}, {"quiet"}, {"-print_format"}, {"json"}, {"-show_streams"},
+                  {"-show_chapters"}, {"-show_format"}, movieFile });
+    // Parse the json output incrementally while ffprobe is running.
+    xMovieFileProbe movieFileProbe;
+    auto parsed = true;
+    while ((parsed) && (ffprobe.waitForReadyRead(-1))) {
+        parsed = movieFileProbe.parse(ffprobe.readAllStandardOutput());
+    }
+    ffprobe.waitForFinished(-1);
+    if (parsed) {
+        parsed = movieFileProbe.parse(ffprobe.readAllStandardOutput());
+    }
+    if ((!parsed) || (!movieFileProbe.isComplete())) {
+        qCritical() << "xMovieFileAnalyze: unable to read movie file info.";
+        return false;
+    }
+    // Extract infos.
+    movieFileResult.audioStreams = movieFileProbe.getAudioStreams();
+    for (auto& movieFileAudioTrack : movieFileResult.audioStreams) {
+        if (!movieFileAudioTrack.bitsPerSample) {
+            // No bits per sample found. Resolve by using the profile.
+            if (xMovieFile_HighResProfiles.contains(movieFileAudioTrack.profile, Qt::CaseInsensitive)) {
+                movieFileAudioTrack.bitsPerSample = 24;
+            } else {
+                movieFileAudioTrack.bitsPerSample = 16;
+            }
+        }
+    }
+    movieFileResult.chapters = movieFileProbe.getChapters();
+    // No actual chapter information found. Extract necessary infos from format section.
+    if (movieFileResult.chapters.isEmpty()) {
+        movieFileResult.chapters.push_back(std::make_pair(0.0, movieFileProbe.getDuration()));
+    }
+    return true;
+}
+
+QString xMovieFileAnalyze::cacheFileName() const {
+    QFileInfo movieFileInfo(movieFile);
+    QDir cacheDirectory(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)+"/xRipEncode/analyze");
+    if (!cacheDirectory.mkpath(".")) {
+        qCritical() << "xMovieFileAnalyze: unable to create cache directory: " << cacheDirectory.path();
+        return QString();
+    }
+    // Key is given by the absolute path, modification time and size.
+    QCryptographicHash cacheKey(QCryptographicHash::Sha1);
+    cacheKey.addData(movieFileInfo.absoluteFilePath().toUtf8());
+    cacheKey.addData(QByteArray::number(movieFileInfo.lastModified().toMSecsSinceEpoch()));
+    cacheKey.addData(QByteArray::number(movieFileInfo.size()));
+    return cacheDirectory.absoluteFilePath(QString::fromLatin1(cacheKey.result().toHex()));
+}
+
+bool xMovieFileAnalyze::readCache(const QString& fileName) {
+    QFile cacheFile(fileName);
+    if (!cacheFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream cacheStream(&cacheFile);
+    quint32 cacheVersion;
+    cacheStream >> cacheVersion;
+    if (cacheVersion != xMovieFileAnalyze_CacheVersion) {
+        return false;
+    }
+    qint32 audioStreams, chapters;
+    cacheStream >> audioStreams;
+    movieFileResult.audioStreams.clear();
+    for (auto i = 0; (i < audioStreams) && (cacheStream.status() == QDataStream::Ok); ++i) {
+        xMovieFileAudioStream audioStream;
+        cacheStream >> audioStream.codecName >> audioStream.codecLongName >> audioStream.profile
+                    >> audioStream.sampleFormat >> audioStream.sampleRate >> audioStream.bitsPerSample
+                    >> audioStream.bitRate >> audioStream.channels >> audioStream.channelLayout;
+        movieFileResult.audioStreams.push_back(audioStream);
+    }
+    cacheStream >> chapters;
+    movieFileResult.chapters.clear();
+    for (auto i = 0; (i < chapters) && (cacheStream.status() == QDataStream::Ok); ++i) {
+        double startTime, endTime;
+        cacheStream >> startTime >> endTime;
+        movieFileResult.chapters.push_back(std::make_pair(startTime, endTime));
+    }
+    return (cacheStream.status() == QDataStream::Ok) && (!movieFileResult.chapters.isEmpty());
+}
+
+void xMovieFileAnalyze::writeCache(const QString& fileName) {
+    QFile cacheFile(fileName);
+    if (!cacheFile.open(QIODevice::WriteOnly)) {
+        qCritical() << "xMovieFileAnalyze: unable to write cache file: " << fileName;
+        return;
+    }
+    QDataStream cacheStream(&cacheFile);
+    cacheStream << xMovieFileAnalyze_CacheVersion;
+    cacheStream << static_cast<qint32>(movieFileResult.audioStreams.count());
+    for (const auto& audioStream : movieFileResult.audioStreams) {
+        cacheStream << audioStream.codecName << audioStream.codecLongName << audioStream.profile
+                    << audioStream.sampleFormat << audioStream.sampleRate << audioStream.bitsPerSample
+                    << audioStream.bitRate << audioStream.channels << audioStream.channelLayout;
+    }
+    cacheStream << static_cast<qint32>(movieFileResult.chapters.count());
+    for (const auto& chapter : movieFileResult.chapters) {
+        cacheStream << chapter.first << chapter.second;
+    }
+}
+
+/**
+ * xMovieFile
+ *
+ * This class handles the analysis and the rip process for movie files.
+ */
 xMovieFile::xMovieFile(QObject* parent):
         QThread(parent),
-        process(nullptr) {
+        process(nullptr),
+        ripWorkTotal(0),
+        ripProgressStep(0),
+        ripJobId(0),
+        movieFileAnalyzer(nullptr) {
+}
+
+xMovieFile::~xMovieFile() {
+    if (movieFileAnalyzer) {
+        movieFileAnalyzer->wait();
+    }
+    // Abort the wait for temp space on shutdown.
+    requestInterruption();
+    wait();
 }
 
 int xMovieFile::getTracks() const {
@@ -55,64 +225,46 @@ const QString& xMovieFile::getFileName() const {
     return movieFile;
 }
 
+bool xMovieFile::isAnalyzing() const {
+    return movieFileAnalyzer != nullptr;
+}
+
 void xMovieFile::analyze(const QString& file) {
     // Check if we really have a file.
     if (!std::filesystem::is_regular_file(file.toStdString())) {
         qCritical() << "xMovieFile::analyze: illegal file name: " << file;
         return;
     }
+    if (movieFileAnalyzer) {
+        emit messages("[analyze] analysis already in progress", 0);
+        return;
+    }
     movieFile = file;
+    // Measure the time required by ffprobe and the parsing.
+    movieFileAnalyzeTimer.start();
     // Clear currently stored audio streams and queued tracks.
     movieFileAudioStreams.clear();
     queue.clear();
-    // Start ffprobe in order to analyze the movie file.
-    process = new QProcess();
-    process->setProcessChannelMode(QProcess::MergedChannels);
-    process->start(xRipEncodeConfiguration::configuration()->getFFProbe(),
-                   { {"-v"}, {"quiet"}, {"-print_format"}, {"json"}, {"-show_streams"},
-                   {"-show_chapters"}, {"-show_format"}, movieFile });
-    process->waitForFinished(-1);
-    // Process standard output (includes stderr) and interpret json.
-    std::stringstream processOutput;
-    processOutput << process->readAllStandardOutput().toStdString();
-    // Delete process.
-    delete process;
-    boost::property_tree::ptree movieFileInfo;
-    try {
-        boost::property_tree::read_json(processOutput, movieFileInfo);
-    } catch (boost::property_tree::json_parser_error& e) {
-        qCritical() << "xMovieFile::analyze: unable to read movie file info.";
+    movieFileAnalyzer = new xMovieFileAnalyze(movieFile, this);
+    connect(movieFileAnalyzer, &xMovieFileAnalyze::finished, this, &xMovieFile::analyzeFinished);
+    movieFileAnalyzer->start();
+}
+
+void xMovieFile::analyzeFinished() {
+    if (!movieFileAnalyzer) {
+        return;
+    }
+    auto movieFileResult = movieFileAnalyzer->result();
+    movieFileAnalyzer->deleteLater();
+    movieFileAnalyzer = nullptr;
+    if (!movieFileResult.valid) {
+        emit messages(QString("[error] unable to analyze movie file: %1").arg(movieFile), 0);
         return;
     }
     // Extract infos.
+    movieFileAudioStreams = movieFileResult.audioStreams;
     QStringList movieFileAudioTrackInfos;
-    auto childStreams = movieFileInfo.get_child("streams");
-    for (boost::property_tree::ptree::value_type& childStream : childStreams) {
-        if (childStream.second.get<std::string>("codec_type") != "audio") {
-            continue;
-        }
-        xMovieFileAudioStream movieFileAudioTrack;
-        movieFileAudioTrack.codecName = QString::fromStdString(childStream.second.get<std::string>("codec_name", ""));
-        movieFileAudioTrack.codecLongName = QString::fromStdString(childStream.second.get<std::string>("codec_long_name", ""));
-        movieFileAudioTrack.profile = QString::fromStdString(childStream.second.get<std::string>("profile", ""));
-        movieFileAudioTrack.sampleFormat = QString::fromStdString(childStream.second.get<std::string>("sample_fmt", ""));
-        movieFileAudioTrack.sampleRate = childStream.second.get<uint32_t >("sample_rate", 44100);
-        movieFileAudioTrack.bitsPerSample = childStream.second.get<uint32_t>("bits_per_sample", 0);
-        if (!movieFileAudioTrack.bitsPerSample) {
-            movieFileAudioTrack.bitsPerSample = childStream.second.get<uint32_t>("bits_per_raw_sample", 0);
-            if (!movieFileAudioTrack.bitsPerSample) {
-                // Still no bits per sample found. Resolve by using the profile.
-                if (xMovieFile_HighResProfiles.contains(movieFileAudioTrack.profile, Qt::CaseInsensitive)) {
-                    movieFileAudioTrack.bitsPerSample = 24;
-                } else {
-                    movieFileAudioTrack.bitsPerSample = 16;
-                }
-            }
-        }
-        movieFileAudioTrack.bitRate = childStream.second.get<uint32_t>("bit_rate", 0);
-        movieFileAudioTrack.channels = childStream.second.get<uint32_t>("channels", 2);
-        movieFileAudioTrack.channelLayout = QString::fromStdString(childStream.second.get<std::string>("channelLayout", ""));
-        movieFileAudioStreams.push_back(movieFileAudioTrack);
+    for (const auto& movieFileAudioTrack : movieFileAudioStreams) {
         if (movieFileAudioTrack.profile.isEmpty()) {
             movieFileAudioTrackInfos.push_back(QString("%1, %2Hz, %3-bit, %4 channels").arg(movieFileAudioTrack.codecLongName).
                     arg(movieFileAudioTrack.sampleRate).arg(movieFileAudioTrack.bitsPerSample).arg(movieFileAudioTrack.channels));
@@ -124,28 +276,21 @@ void xMovieFile::analyze(const QString& file) {
     emit audioStreamInfos(movieFileAudioTrackInfos);
     clearTracks();
     QVector<qint64> movieFileTrackLengths;
-    auto childTracks = movieFileInfo.get_child("chapters");
-    for (boost::property_tree::ptree::value_type& childTrack : childTracks) {
+    for (const auto& chapter : movieFileResult.chapters) {
         // Retrieve start and end time for each track (chapter)
-        auto movieFileTrack = new xMovieFileTrack(childTrack.second.get<double>("start_time", 0.0),
-                                                    childTrack.second.get<double>("end_time", 0.0), this);
-        movieFileTracks.push_back(movieFileTrack);
-        // Update track length.
-        movieFileTrackLengths.push_back(movieFileTrack->getLength());
-    }
-    // No actual chapter information found. Extract necessary infos from format section.
-    if (movieFileTracks.isEmpty()) {
-        auto movieFileTrack = new xMovieFileTrack(0.0, movieFileInfo.get<double>("format.duration"), this);
+        auto movieFileTrack = new xMovieFileTrack(chapter.first, chapter.second, this);
         movieFileTracks.push_back(movieFileTrack);
         // Update track length.
         movieFileTrackLengths.push_back(movieFileTrack->getLength());
     }
+    emit messages(QString("[timing] analyze: %1 streams, %2 chapters in %3 ms%4").arg(movieFileAudioStreams.count()).
+            arg(movieFileTracks.count()).arg(movieFileAnalyzeTimer.elapsed()).arg(movieFileResult.cached ? " (cached)" : ""), 0);
     emit trackLengths(movieFileTrackLengths);
     // Resize the queue. Index start with 0 not with 1 as the track index does.
     queue.resize(getTracks());
 }
 
-void xMovieFile::queueRip(const QList<xAudioFile*>& files, int stream, bool downMix) {
+void xMovieFile::queueRip(const QList<xAudioFile*>& files, int stream, bool downMix, bool derivative) {
     if ((stream < 0) || (stream >= movieFileAudioStreams.count())) {
         qCritical() << "Illegal audio stream: " << stream;
         return;
@@ -158,20 +303,87 @@ void xMovieFile::queueRip(const QList<xAudioFile*>& files, int stream, bool down
             continue;
         }
         // queue starts with index 0.
-        queue[file->getAudioTrackNr()-1].push_back(xMovieFileQueue{ file, stream, audioStreamInfo.bitsPerSample, downMix });
+        if (derivative) {
+            queue[file->getAudioTrackNr()-1].push_back(xMovieFileQueue{ file, stream, xMovieFile_DerivativeSampleRate,
+                                                                        xMovieFile_DerivativeBitsPerSample, downMix });
+        } else {
+            // A sample rate of 0 keeps the sample rate of the audio stream.
+            queue[file->getAudioTrackNr()-1].push_back(xMovieFileQueue{ file, stream, 0, audioStreamInfo.bitsPerSample, downMix });
+        }
         qDebug() << "Added to rip queue: " << file->getFileName();
     }
 }
 
 void xMovieFile::processOutput() {
-    QString ripOutput = process->readAllStandardOutput();
-    QRegularExpression regExp(R"(.*The file '.*-(?<track>\d\d\d)' has been opened for writing.*)");
-    QRegularExpressionMatch regExpMatch = regExp.match(ripOutput);
-    if (regExpMatch.hasMatch()) {
-        auto track = regExpMatch.captured("track").toInt();
-        emit ripProgress(track, 50);
+    processOutputBuffer.append(process->readAllStandardOutput());
+    QStringList ripOutput;
+    int lineStart = 0;
+    int lineEnd;
+    // Only process complete lines. Keep the remainder for the next chunk.
+    while ((lineEnd = processOutputBuffer.indexOf('\n', lineStart)) >= 0) {
+        auto line = QString::fromUtf8(processOutputBuffer.constData()+lineStart, lineEnd-lineStart).trimmed();
+        lineStart = lineEnd+1;
+        auto progressMatch = xMovieFile_MKVMergeProgress.match(line);
+        if (progressMatch.hasMatch()) {
+            updateSplitProgress(progressMatch.capturedRef(1).toInt());
+            continue;
+        }
+        // The previous chapter is complete once the next file is opened.
+        auto openedMatch = xMovieFile_MKVMergeOpened.match(line);
+        if ((openedMatch.hasMatch()) && (openedMatch.capturedRef(1).toInt() > 1)) {
+            auto previous = openedMatch.capturedRef(1).toInt()-1;
+            if ((previous <= ripTrackProgress.count()) && (ripTrackProgress[previous-1] < 50)) {
+                ripTrackProgress[previous-1] = 50;
+                emit ripProgress(previous, 50);
+            }
+        }
+        if (!line.isEmpty()) {
+            ripOutput.push_back(line);
+        }
+    }
+    processOutputBuffer.remove(0, lineStart);
+    if (!ripOutput.isEmpty()) {
+        emit messages(ripOutput.join('\n'), ripJobId);
     }
-    emit messages(ripOutput);
+}
+
+void xMovieFile::updateSplitProgress(int progress) {
+    if (ripChapterEnds.isEmpty()) {
+        return;
+    }
+    // Map the overall progress to a position within the movie file.
+    auto position = ripChapterEnds.last()*std::clamp(progress, 0, 100)/100;
+    for (auto index = 0; index < ripChapterEnds.count(); ++index) {
+        auto chapterStart = (index > 0) ? ripChapterEnds[index-1] : 0;
+        auto chapterLength = ripChapterEnds[index]-chapterStart;
+        if (position <= chapterStart) {
+            break;
+        }
+        // The split accounts for the first 50% of each track.
+        auto chapterProgress = (chapterLength > 0) ?
+                static_cast<int>(std::min(position-chapterStart, chapterLength)*50/chapterLength) : 50;
+        if (chapterProgress > ripTrackProgress[index]) {
+            ripTrackProgress[index] = chapterProgress;
+            emit ripProgress(index+1, chapterProgress);
+        }
+    }
+    updateRipWork(position);
+}
+
+void xMovieFile::updateRipWork(qint64 done) {
+    if (ripWorkTotal <= 0) {
+        return;
+    }
+    auto progress = static_cast<int>(std::clamp(done*100/ripWorkTotal, static_cast<qint64>(0), static_cast<qint64>(100)));
+    if ((progress/10 <= ripProgressStep) || (progress == 0)) {
+        return;
+    }
+    ripProgressStep = progress/10;
+    auto elapsed = ripTimer.elapsed();
+    auto remaining = elapsed*(100-progress)/progress;
+    emit messages(QString("[progress] %1% done, %2 elapsed, ETA %3").arg(progress).
+            arg(QTime(0, 0).addMSecs(static_cast<int>(elapsed)).toString("hh:mm:ss")).
+            arg(QTime(0, 0).addMSecs(static_cast<int>(remaining)).toString("hh:mm:ss")), ripJobId);
 }
 
 void xMovieFile::run() {
@@ -181,53 +393,189 @@ void xMovieFile::run() {
                     << movieFileTracks.count() << "," << queue.count();
         return;
     }
-    // First we need to split the movie file into tracks.
-    movieFilePath = xRipEncodeConfiguration::configuration()->getTempDirectory();
-    auto movieFileOutput = movieFilePath + "/" + xMovieFile_TemporaryFileBase;
-    if (movieFileTracks.count() > 1) {
-        // Redirect output only if necessary.
-        process = new QProcess();
-        process->setProcessChannelMode(QProcess::MergedChannels);
-        connect(process, &QProcess::readyReadStandardOutput, this, &xMovieFile::processOutput);
-        process->start(xRipEncodeConfiguration::configuration()->getMKVMerge(),
-                       { {"--split"}, {"chapters:all"}, movieFile, {"-o"}, movieFileOutput });
-        process->waitForFinished(-1);
-        disconnect(process, &QProcess::readyReadStandardOutput, this, &xMovieFile::processOutput);
-    } else {
-        // Create file name according to our scheme.
-        auto copyMovieFileOutput = movieFileOutput+"-001";
-        try {
-            // Copy the file as the copy will be removed after audio file extraction.
-            std::filesystem::copy_file(movieFile.toStdString(), copyMovieFileOutput.toStdString(),
-                                       std::filesystem::copy_options::overwrite_existing);
-            emit ripProgress(1, 50);
-        } catch (std::filesystem::filesystem_error& e) {
-            qCritical() << "Unable to copy \"" << movieFile << "\" to \"" << copyMovieFileOutput << "\", error: " << e.what();
-            return;
-        }
-        // Avoid issue with delete later on.
-        process = nullptr;
-    }
-    // Attach the temporary file names to the movie tracks.
-    for (auto index = 0; index < movieFileTracks.count(); ++index) {
-        // File names start with index 1.
-        movieFileTracks[index]->attachFile(movieFileOutput+QString("-%1").arg(index+1, 3, 10, QChar('0')));
+    // Extract the chapters directly out of the movie file if the internal demuxer is enabled.
+    auto demux = xRipEncodeConfiguration::configuration()->getMovieFileDemux();
+    // Measure the time for the split and the extraction.
+    ripTimer.start();
+    // Determine the work for the split (whole movie file) and the extraction (each queued entry).
+    qint64 ripWorkSplit = 0;
+    ripChapterEnds.clear();
+    for (const auto& track : movieFileTracks) {
+        ripWorkSplit += track->getLength();
+        ripChapterEnds.push_back(ripWorkSplit);
     }
-    // Run through the queue
-    QList<xAudioFile*> files;
+    ripTrackProgress.fill(0, movieFileTracks.count());
+    if ((demux) || (movieFileTracks.count() <= 1)) {
+        ripWorkSplit = 0;
+    }
+    // Group the queued entries of each chapter. The internal demuxer extracts all entries
+    // of a chapter with a single read and decodes each selected audio stream only once.
+    QVector<QList<QList<xMovieFileQueue>>> ripGroups(queue.count());
+    ripWorkTotal = ripWorkSplit;
     for (auto index = 0; index < queue.count(); ++index) {
-        auto queueEntry = queue[index];
-        if (queueEntry.isEmpty()) {
-            continue;
+        for (const auto& entry : queue[index]) {
+            if ((demux) && (!ripGroups[index].isEmpty())) {
+                ripGroups[index].first().push_back(entry);
+            } else {
+                ripGroups[index].push_back({ entry });
+            }
+        }
+        ripWorkTotal += ripGroups[index].count()*movieFileTracks[index]->getLength();
+    }
+    ripProgressStep = 0;
+    // All queued audio files belong to the same rip job.
+    ripJobId = 0;
+    for (const auto& queueEntries : queue) {
+        if (!queueEntries.isEmpty()) {
+            ripJobId = queueEntries.first().audioFile->getJobId();
+            break;
+        }
+    }
+    // Reserve the temp space for the split chapters and the extracted audio files.
+    auto movieFileOutput = xRipEncodeConfiguration::configuration()->getTempDirectory() + "/" + xMovieFile_TemporaryFileBase;
+    QList<std::pair<QString,qint64>> ripFileSizes;
+    if (!demux) {
+        auto movieFileSize = QFileInfo(movieFile).size();
+        auto movieFileLength = std::max(ripChapterEnds.last(), static_cast<qint64>(1));
+        for (auto index = 0; index < movieFileTracks.count(); ++index) {
+            // File names start with index 1.
+            ripFileSizes.push_back({ movieFileOutput+QString("-%1").arg(index+1, 3, 10, QChar('0')),
+                                     movieFileSize*movieFileTracks[index]->getLength()/movieFileLength });
+        }
+    }
+    for (auto index = 0; index < queue.count(); ++index) {
+        for (const auto& entry : queue[index]) {
+            const auto& stream = movieFileAudioStreams[entry.audioStream];
+            auto sampleRate = (entry.sampleRate > 0) ? entry.sampleRate : stream.sampleRate;
+            auto bitsPerSample = (entry.bitsPerSample > 0) ? entry.bitsPerSample : ((stream.bitsPerSample <= 16) ? 16 : 24);
+            auto channels = (entry.downMix) ? 2 : stream.channels;
+            // Estimate for a wav file. Flac files are smaller.
+            ripFileSizes.push_back({ entry.audioFile->getFileName(), movieFileTracks[index]->getLength()*
+                                     sampleRate/1000*channels*bitsPerSample/8+44 });
+        }
+    }
+    qint64 ripFileSizeTotal = 0;
+    for (const auto& file : ripFileSizes) {
+        ripFileSizeTotal += file.second;
+    }
+    if (!xTempSpace::tempSpace()->available(ripFileSizeTotal)) {
+        emit messages(QString("[temp] waiting for temp space: %1 MB reserved").arg(xTempSpace::tempSpace()->reserved()/(1024*1024)), ripJobId);
+    }
+    if (!xTempSpace::tempSpace()->reserve(ripFileSizes)) {
+        emit messages("[abort] waiting for temp space canceled", ripJobId);
+        return;
+    }
+    // Avoid issue with delete later on.
+    process = nullptr;
+    // The split accounts for the first half of the track progress.
+    auto ripSplitProgress = (demux) ? 0 : 50;
+    if (!demux) {
+        // First we need to split the movie file into tracks.
+        movieFilePath = xRipEncodeConfiguration::configuration()->getTempDirectory();
+        if (movieFileTracks.count() > 1) {
+            // Redirect output only if necessary.
+            process = new QProcess();
+            process->setProcessChannelMode(QProcess::MergedChannels);
+            processOutputBuffer.clear();
+            // Parse the output in the rip thread. The process is owned by this thread.
+            connect(process, &QProcess::readyReadStandardOutput, this, &xMovieFile::processOutput, Qt::DirectConnection);
+            process->start(xRipEncodeConfiguration::configuration()->getMKVMerge(),
+                           { {"--gui-mode"}, {"--split"}, {"chapters:all"}, movieFile, {"-o"}, movieFileOutput });
+            process->waitForFinished(-1);
+            processOutput();
+            disconnect(process, &QProcess::readyReadStandardOutput, this, &xMovieFile::processOutput);
+            updateSplitProgress(100);
+        } else {
+            // Create file name according to our scheme.
+            auto copyMovieFileOutput = movieFileOutput+"-001";
+            try {
+                // Copy the file as the copy will be removed after audio file extraction.
+                std::filesystem::copy_file(movieFile.toStdString(), copyMovieFileOutput.toStdString(),
+                                           std::filesystem::copy_options::overwrite_existing);
+                emit ripProgress(1, 50);
+            } catch (std::filesystem::filesystem_error& e) {
+                qCritical() << "Unable to copy \"" << movieFile << "\" to \"" << copyMovieFileOutput << "\", error: " << e.what();
+                for (const auto& file : ripFileSizes) {
+                    xTempSpace::tempSpace()->release(file.first);
+                }
+                return;
+            }
+        }
+        // Attach the temporary file names to the movie tracks.
+        for (auto index = 0; index < movieFileTracks.count(); ++index) {
+            // File names start with index 1.
+            movieFileTracks[index]->attachFile(movieFileOutput+QString("-%1").arg(index+1, 3, 10, QChar('0')));
         }
-        for (auto i = 0; i < queueEntry.count(); ++i) {
-            auto entry = queueEntry.at(i);
-            if (movieFileTracks[index]->extract(entry.audioFile->getFileName(), entry.audioStream+1,
-                                                entry.bitsPerSample, entry.downMix)) {
-                files.push_back(entry.audioFile);
+    }
+    auto splitTime = ripTimer.elapsed();
+    emit messages(QString("[timing] split: %1 chapters in %2 ms%3").arg(movieFileTracks.count()).
+            arg(splitTime).arg((demux) ? " (skipped)" : ""), ripJobId);
+    // The demuxer keeps the movie file open for all chapters.
+    xMovieFileDemux movieFileDemux(movieFile);
+    connect(&movieFileDemux, &xMovieFileDemux::messages, this, [this](const QString& msg) {
+        emit messages(msg, ripJobId);
+    }, Qt::DirectConnection);
+    // Run through the queue
+    QList<xAudioFile*> files;
+    auto extractWorkDone = ripWorkSplit;
+    for (auto index = 0; index < ripGroups.count(); ++index) {
+        const auto& groups = ripGroups[index];
+        auto track = movieFileTracks[index];
+        auto trackLength = track->getLength();
+        for (auto i = 0; i < groups.count(); ++i) {
+            const auto& group = groups.at(i);
+            // Map the extraction progress to the remainder of the track progress.
+            auto updateProgress = [=](int progress) {
+                // Track index starts with 1.
+                emit ripProgress(index+1, ripSplitProgress + (i*100+progress)*(100-ripSplitProgress)/(groups.count()*100));
+                updateRipWork(extractWorkDone + trackLength*progress/100);
+            };
+            if (demux) {
+                QVector<xMovieFileDemuxOutput> outputs;
+                for (const auto& entry : group) {
+                    outputs.push_back(xMovieFileDemuxOutput{ entry.audioFile->getFileName(), entry.audioStream,
+                                                             entry.sampleRate, entry.bitsPerSample, entry.downMix });
+                }
+                auto progressConnection = connect(&movieFileDemux, &xMovieFileDemux::extractProgress,
+                                                  this, updateProgress, Qt::DirectConnection);
+                auto extracted = movieFileDemux.extract(outputs, track->getStartTime(), track->getEndTime());
+                disconnect(progressConnection);
+                for (auto e = 0; e < group.count(); ++e) {
+                    if (extracted[e]) {
+                        files.push_back(group[e].audioFile);
+                    }
+                }
+            } else {
+                const auto& entry = group.first();
+                auto progressConnection = connect(track, &xMovieFileTrack::extractProgress, this, updateProgress, Qt::DirectConnection);
+                auto messagesConnection = connect(track, &xMovieFileTrack::messages, this, [this](const QString& msg) {
+                    emit messages(msg, ripJobId);
+                }, Qt::DirectConnection);
+                if (track->extract(entry.audioFile->getFileName(), entry.audioStream+1, entry.sampleRate,
+                                   entry.bitsPerSample, entry.downMix)) {
+                    files.push_back(entry.audioFile);
+                }
+                disconnect(progressConnection);
+                disconnect(messagesConnection);
             }
+            extractWorkDone += trackLength;
             // Update rip progress. Track index starts with 1.
-            emit ripProgress(index+1, 50 + ((i+1)*50/queueEntry.count()));
+            emit ripProgress(index+1, ripSplitProgress + ((i+1)*(100-ripSplitProgress)/groups.count()));
+            updateRipWork(extractWorkDone);
+        }
+    }
+    emit messages(QString("[timing] extract: %1 files in %2 ms (total %3 ms)").arg(files.count()).
+            arg(ripTimer.elapsed()-splitTime).arg(ripTimer.elapsed()), ripJobId);
+    // Release the space of the audio files that could not be extracted.
+    QSet<QString> extractedFileNames;
+    for (const auto& file : files) {
+        extractedFileNames.insert(file->getFileName());
+    }
+    for (const auto& queueEntries : queue) {
+        for (const auto& entry : queueEntries) {
+            if (!extractedFileNames.contains(entry.audioFile->getFileName())) {
+                xTempSpace::tempSpace()->release(entry.audioFile->getFileName());
+            }
         }
     }
     // Emit extracted audio file queue.
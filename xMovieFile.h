@@ -13,25 +13,90 @@
  */
 
 #include "xMovieFileTrack.h"
+#include "xMovieFileProbe.h"
 #include "xAudioFile.h"
 
 #include <QThread>
 #include <QProcess>
 #include <QVector>
+#include <QElapsedTimer>
 
 #ifndef __XMOVIEFILE_H__
 #define __XMOVIEFILE_H__
 
-struct xMovieFileAudioStream {
-    QString codecName;
-    QString codecLongName;
-    QString profile;
-    QString sampleFormat;
-    int sampleRate;
-    int bitsPerSample;
-    int bitRate;
-    int channels;
-    QString channelLayout;
+/**
+ * Result of the movie file analysis. Each chapter is given by its start
+ * and end time in seconds. Files without chapters contain a single chapter
+ * covering the whole file.
+ */
+struct xMovieFileAnalyzeResult {
+    bool valid;
+    bool cached;
+    QVector<xMovieFileAudioStream> audioStreams;
+    QVector<std::pair<double,double>> chapters;
+};
+
+class xMovieFileAnalyze:public QThread {
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor
+     *
+     * @param file path to the movie file as string.
+     * @param parent pointer to the parent object.
+     */
+    explicit xMovieFileAnalyze(const QString& file, QObject* parent=nullptr);
+    /**
+     * Destructor (default)
+     */
+    ~xMovieFileAnalyze() override = default;
+    /**
+     * Analyze the movie file.
+     *
+     * The analysis is run in a separate thread. The results are read from the
+     * cache if the movie file (path, modification time and size) is unchanged.
+     * Otherwise ffprobe is used and the results are stored in the cache.
+     * After the analysis is finished, the signal finished is emitted. Only then
+     * the results can be requested.
+     */
+    void run() override;
+    /**
+     * Return the results of the analysis.
+     *
+     * @return the audio streams and chapters as structure.
+     */
+    [[nodiscard]] const xMovieFileAnalyzeResult& result() const;
+
+private:
+    /**
+     * Run ffprobe and parse its json output while reading from the pipe.
+     *
+     * @return true if the output was parsed successfully, false otherwise.
+     */
+    bool analyzeFFProbe();
+    /**
+     * Determine the cache file for the movie file.
+     *
+     * @return the path to the cache file as string, empty on error.
+     */
+    [[nodiscard]] QString cacheFileName() const;
+    /**
+     * Read the results from the cache.
+     *
+     * @param fileName path to the cache file.
+     * @return true if the cache entry is valid, false otherwise.
+     */
+    bool readCache(const QString& fileName);
+    /**
+     * Write the results to the cache.
+     *
+     * @param fileName path to the cache file.
+     */
+    void writeCache(const QString& fileName);
+
+    QString movieFile;
+    xMovieFileAnalyzeResult movieFileResult;
 };
 
 class xMovieFile:public QThread {
@@ -39,13 +104,25 @@ class xMovieFile:public QThread {
 
 public:
     explicit xMovieFile(QObject* parent=nullptr);
-    ~xMovieFile() override = default;
+    /**
+     * Destructor. Wait for a running analysis.
+     */
+    ~xMovieFile() override;
     /**
      * Analyze the given file.
      *
+     * The analysis is performed in a separate thread. The signals audioStreamInfos
+     * and trackLengths are emitted after the analysis is finished.
+     *
      * @param file path to the movie file as string.
      */
     void analyze(const QString& file);
+    /**
+     * Check if an analysis is running. A new analysis is rejected until it finished.
+     *
+     * @return true if the analysis is running, false otherwise.
+     */
+    [[nodiscard]] bool isAnalyzing() const;
     /**
      * Determine the number of tracks in the movie file.
      *
@@ -77,8 +154,9 @@ public:
      * @param files list of audio files containing all information.
      * @param audio index of the audio stream (starting at 0).
      * @param downMix down mix to stereo if true, false otherwise.
+     * @param derivative create a CD quality (44.1kHz/16bit) derivative if true.
      */
-    void queueRip(const QList<xAudioFile*>& files, int stream, bool downMix);
+    void queueRip(const QList<xAudioFile*>& files, int stream, bool downMix, bool derivative=false);
     /**
      * Rip all tracks queued.
      */
@@ -111,11 +189,12 @@ signals:
      */
     void ripProgress(int track, int progress);
     /**
-     * Signal the output of the rip process.
+     * Signal the output of the analysis and the rip process.
      *
      * @param msg the current output as string.
+     * @param jobId the job ID of the rip, 0 if none.
      */
-    void messages(const QString& msg);
+    void messages(const QString& msg, quint64 jobId);
 
 
 private slots:
@@ -123,16 +202,33 @@ private slots:
      * Process the output of the rip process.
      */
     void processOutput();
+    /**
+     * Called if the analysis thread is finished.
+     */
+    void analyzeFinished();
 
 private:
     /**
      * Clear all tracks for the movie file.
      */
     void clearTracks();
+    /**
+     * Update the split progress of all chapters based on the overall mkvmerge progress.
+     *
+     * @param progress the overall split progress in percent.
+     */
+    void updateSplitProgress(int progress);
+    /**
+     * Update the overall work done and report progress and ETA in steps of 10%.
+     *
+     * @param done the work done in milliseconds of audio.
+     */
+    void updateRipWork(qint64 done);
 
     typedef struct {
         xAudioFile* audioFile;
         int audioStream;
+        int sampleRate;
         int bitsPerSample;
         bool downMix;
     } xMovieFileQueue;
@@ -142,6 +238,17 @@ private:
     QVector<xMovieFileAudioStream> movieFileAudioStreams;
     QVector<xMovieFileTrack*> movieFileTracks;
     QProcess* process;
+    QByteArray processOutputBuffer;
+    // Progress and ETA of the rip. Work is measured in milliseconds of audio.
+    QElapsedTimer ripTimer;
+    QVector<qint64> ripChapterEnds;
+    QVector<int> ripTrackProgress;
+    qint64 ripWorkTotal;
+    int ripProgressStep;
+    // Job of the queued audio files. Attached to the messages of the rip.
+    quint64 ripJobId;
+    xMovieFileAnalyze* movieFileAnalyzer;
+    QElapsedTimer movieFileAnalyzeTimer;
     QVector<QList<xMovieFileQueue>> queue;
 };
 
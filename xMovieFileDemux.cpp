@@ -0,0 +1,860 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "xMovieFileDemux.h"
+#include "xRipEncodeConfiguration.h"
+#include "xAudioDownMix.h"
+#include "xAudioResample.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <cstring>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/channel_layout.h>
+#include <libswresample/swresample.h>
+}
+
+// The AVChannelLayout API replaces the channel masks with FFmpeg 5.1.
+#define xMovieFileDemux_ChannelLayoutAPI (LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(59, 24, 100))
+
+// GUID of the PCM sub format used in the extensible wav header.
+const char xMovieFileDemux_SubFormatPCM[] {
+    '\x01', '\x00', '\x00', '\x00', '\x00', '\x00', '\x10', '\x00',
+    '\x80', '\x00', '\x00', '\xAA', '\x00', '\x38', '\x9B', '\x71'
+};
+
+// Sample rate used for the conversion of DSD streams.
+const int xMovieFileDemux_DSDSampleRate { 88200 };
+
+// Size of the flac STREAMINFO block and offsets of the total samples and the MD5 signature.
+const int xMovieFileDemux_StreamInfoSize { 34 };
+const int xMovieFileDemux_StreamInfoTotalSamples { 13 };
+const int xMovieFileDemux_StreamInfoMD5 { 18 };
+// The STREAMINFO block follows the "fLaC" marker and the block header.
+const int xMovieFileDemux_StreamInfoOffset { 8 };
+
+// Release the libav structures.
+struct xMovieFileDemuxFree {
+    void operator() (AVCodecContext* context) const { avcodec_free_context(&context); }
+    void operator() (AVPacket* packet) const { av_packet_free(&packet); }
+    void operator() (AVFrame* frame) const { av_frame_free(&frame); }
+    void operator() (SwrContext* context) const { swr_free(&context); }
+    // Only used for output contexts.
+    void operator() (AVFormatContext* context) const {
+        if (context->pb) {
+            avio_closep(&context->pb);
+        }
+        avformat_free_context(context);
+    }
+};
+
+// Resampler shared by all outputs with the same sample rate and down mix.
+struct xMovieFileDemuxResample {
+    std::unique_ptr<xAudioResample> resample;
+    std::vector<std::vector<float>> output;
+};
+
+// State of one output during the extraction.
+struct xMovieFileDemuxSink {
+    xMovieFileDemuxOutput output;
+    int index = 0;
+    int sampleRate = 0;
+    bool flac = false;
+    bool remux = false;
+    // Samples copied into a remuxed output.
+    int64_t remuxSamples = 0;
+    // Outputs down mixed or resampled are converted from float samples.
+    bool converted = false;
+    xMovieFileDemuxResample* resample = nullptr;
+    std::unique_ptr<xAudioDither> dither;
+    QFile file;
+    QProcess process;
+    QIODevice* device = nullptr;
+    std::unique_ptr<SwrContext,xMovieFileDemuxFree> converter;
+    std::unique_ptr<AVFormatContext,xMovieFileDemuxFree> muxer;
+    AVStream* muxerStream = nullptr;
+    int channels = 0;
+    quint32 channelMask = 0;
+    qint64 dataSize = 0;
+    bool failed = false;
+};
+
+// State of one selected audio stream during the extraction.
+struct xMovieFileDemuxStream {
+    int stream = 0;
+    AVStream* avStream = nullptr;
+    int sampleRate = 0;
+    int channels = 0;
+    int64_t startSample = 0;
+    int64_t endSample = 0;
+    std::unique_ptr<AVCodecContext,xMovieFileDemuxFree> codecContext;
+    // Planar float samples, the down mix and the resamplers are shared by all converted outputs.
+    std::unique_ptr<SwrContext,xMovieFileDemuxFree> planarConverter;
+    std::unique_ptr<xAudioDownMix> downMix;
+    std::map<std::pair<int,bool>,xMovieFileDemuxResample> resamples;
+    std::vector<xMovieFileDemuxSink*> sinks;
+    std::vector<xMovieFileDemuxSink*> remuxSinks;
+    std::vector<uint8_t> convertBuffer;
+    std::vector<float> planarBuffer;
+    std::vector<float> leftBuffer;
+    std::vector<float> rightBuffer;
+    QByteArray writeBuffer;
+    int64_t position = AV_NOPTS_VALUE;
+    int64_t firstPacketSample = AV_NOPTS_VALUE;
+    bool started = false;
+    bool decodeDone = false;
+    bool remuxDone = false;
+    int progress = 0;
+};
+
+#if xMovieFileDemux_ChannelLayoutAPI
+/**
+ * Determine the channel layout of the decoder. Use the default layout if unspecified.
+ */
+static void xMovieFileDemuxLayout(const AVCodecContext* codecContext, AVChannelLayout* layout) {
+    if (codecContext->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC) {
+        av_channel_layout_default(layout, codecContext->ch_layout.nb_channels);
+    } else {
+        av_channel_layout_copy(layout, &codecContext->ch_layout);
+    }
+}
+#else
+/**
+ * Determine the channel layout of the decoder. Use the default layout if unspecified.
+ */
+static uint64_t xMovieFileDemuxLayout(const AVCodecContext* codecContext) {
+    return (codecContext->channel_layout) ? codecContext->channel_layout :
+           static_cast<uint64_t>(av_get_default_channel_layout(codecContext->channels));
+}
+#endif
+
+/**
+ * Determine the speaker position (wav channel mask bit) of each channel, 0 if unknown.
+ */
+static QVector<quint64> xMovieFileDemuxSpeakers(const AVCodecContext* codecContext) {
+    QVector<quint64> speakers;
+#if xMovieFileDemux_ChannelLayoutAPI
+    AVChannelLayout layout {};
+    xMovieFileDemuxLayout(codecContext, &layout);
+    for (auto c = 0; c < layout.nb_channels; ++c) {
+        auto channel = av_channel_layout_channel_from_index(&layout, static_cast<unsigned int>(c));
+        speakers.push_back(((layout.order == AV_CHANNEL_ORDER_NATIVE) && (channel >= 0) && (channel < 64)) ?
+                           (1ULL << channel) : 0);
+    }
+    av_channel_layout_uninit(&layout);
+#else
+    auto layout = xMovieFileDemuxLayout(codecContext);
+    for (auto c = 0; c < av_get_channel_layout_nb_channels(layout); ++c) {
+        speakers.push_back(av_channel_layout_extract_channel(layout, c));
+    }
+#endif
+    return speakers;
+}
+
+/**
+ * Create a converter from the decoder sample format to the given format. The layout is not changed.
+ */
+static SwrContext* xMovieFileDemuxConverter(const AVCodecContext* codecContext, AVSampleFormat format) {
+    SwrContext* context = nullptr;
+#if xMovieFileDemux_ChannelLayoutAPI
+    AVChannelLayout layout {};
+    xMovieFileDemuxLayout(codecContext, &layout);
+    swr_alloc_set_opts2(&context, &layout, format, codecContext->sample_rate,
+                        &layout, codecContext->sample_fmt, codecContext->sample_rate, 0, nullptr);
+    av_channel_layout_uninit(&layout);
+#else
+    auto layout = static_cast<int64_t>(xMovieFileDemuxLayout(codecContext));
+    context = swr_alloc_set_opts(nullptr, layout, format, codecContext->sample_rate,
+                                 layout, codecContext->sample_fmt, codecContext->sample_rate, 0, nullptr);
+#endif
+    if ((context) && (swr_init(context) < 0)) {
+        swr_free(&context);
+    }
+    return context;
+}
+
+/**
+ * Pack little endian integer samples into the output size by dropping the lowest bytes.
+ */
+static void xMovieFileDemuxPack(const uint8_t* samples, int count, int sampleBytes, int outputBytes, QByteArray& buffer) {
+    buffer.resize(count*outputBytes);
+    if (sampleBytes == outputBytes) {
+        std::memcpy(buffer.data(), samples, static_cast<size_t>(count)*outputBytes);
+        return;
+    }
+    auto output = buffer.data();
+    for (auto i = 0; i < count; ++i, samples += sampleBytes, output += outputBytes) {
+        std::copy(samples+sampleBytes-outputBytes, samples+sampleBytes, output);
+    }
+}
+
+/**
+ * Set the total number of samples (36 bits) of the flac STREAMINFO block.
+ */
+static void xMovieFileDemuxTotalSamples(uint8_t* streamInfo, int64_t samples) {
+    auto total = static_cast<uint64_t>(std::clamp<int64_t>(samples, 0, 0xFFFFFFFFFLL));
+    auto data = streamInfo+xMovieFileDemux_StreamInfoTotalSamples;
+    data[0] = static_cast<uint8_t>((data[0] & 0xF0) | ((total >> 32) & 0x0F));
+    data[1] = static_cast<uint8_t>(total >> 24);
+    data[2] = static_cast<uint8_t>(total >> 16);
+    data[3] = static_cast<uint8_t>(total >> 8);
+    data[4] = static_cast<uint8_t>(total);
+}
+
+xMovieFileDemux::xMovieFileDemux(const QString& file, QObject* parent):
+        QObject(parent),
+        movieFile(file),
+        formatContext(nullptr) {
+}
+
+xMovieFileDemux::~xMovieFileDemux() {
+    if (formatContext) {
+        avformat_close_input(&formatContext);
+    }
+}
+
+bool xMovieFileDemux::isPassthrough(const QString& codecName) {
+    return (codecName == "flac") || (codecName.startsWith("pcm_"));
+}
+
+bool xMovieFileDemux::open() {
+    if (formatContext) {
+        return true;
+    }
+    if (avformat_open_input(&formatContext, movieFile.toUtf8().constData(), nullptr, nullptr) < 0) {
+        emit messages(QString("[error] unable to open movie file: %1").arg(movieFile));
+        formatContext = nullptr;
+        return false;
+    }
+    if (avformat_find_stream_info(formatContext, nullptr) < 0) {
+        emit messages(QString("[error] unable to read stream info: %1").arg(movieFile));
+        avformat_close_input(&formatContext);
+        return false;
+    }
+    return true;
+}
+
+QVector<bool> xMovieFileDemux::extract(const QVector<xMovieFileDemuxOutput>& outputs, double startTime, double endTime) {
+    QVector<bool> extracted(outputs.count(), false);
+    if ((outputs.isEmpty()) || (startTime >= endTime) || (!open())) {
+        return extracted;
+    }
+    // Discard all streams of the movie file unless selected by an output.
+    QVector<int> audioStreams;
+    for (unsigned int index = 0; index < formatContext->nb_streams; ++index) {
+        formatContext->streams[index]->discard = AVDISCARD_ALL;
+        if (formatContext->streams[index]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
+            audioStreams.push_back(static_cast<int>(index));
+        }
+    }
+    // Create the plan for the chapter. Each selected stream is read and decoded once for all its outputs.
+    std::vector<std::unique_ptr<xMovieFileDemuxSink>> sinks;
+    std::map<int,std::unique_ptr<xMovieFileDemuxStream>> streams;
+    for (auto index = 0; index < outputs.count(); ++index) {
+        const auto& output = outputs[index];
+        if ((output.stream < 0) || (output.stream >= audioStreams.count())) {
+            emit messages(QString("[error] illegal audio stream: %1").arg(output.stream));
+            continue;
+        }
+        auto& stream = streams[audioStreams[output.stream]];
+        if (!stream) {
+            stream = std::make_unique<xMovieFileDemuxStream>();
+            stream->stream = output.stream;
+            stream->avStream = formatContext->streams[audioStreams[output.stream]];
+            stream->avStream->discard = AVDISCARD_DEFAULT;
+        }
+        auto sink = std::make_unique<xMovieFileDemuxSink>();
+        sink->output = output;
+        sink->index = index;
+        sink->flac = output.fileName.endsWith(".flac", Qt::CaseInsensitive);
+        sink->converted = (output.downMix) || (output.sampleRate > 0);
+        // FLAC streams are copied into flac files without decoding.
+        sink->remux = (sink->flac) && (!sink->converted) && (stream->avStream->codecpar->codec_id == AV_CODEC_ID_FLAC);
+        if (sink->remux) {
+            stream->remuxSinks.push_back(sink.get());
+        } else {
+            stream->sinks.push_back(sink.get());
+        }
+        sinks.push_back(std::move(sink));
+    }
+    for (auto& [streamIndex, stream] : streams) {
+        Q_UNUSED(streamIndex)
+        stream->sampleRate = stream->avStream->codecpar->sample_rate;
+        stream->remuxDone = stream->remuxSinks.empty();
+        stream->decodeDone = stream->sinks.empty();
+        if ((stream->sampleRate <= 0) || (!setupDecoder(stream.get()))) {
+            if (stream->sampleRate <= 0) {
+                emit messages(QString("[error] unknown sample rate for audio stream: %1").arg(stream->stream));
+            }
+            for (auto sink : stream->sinks) {
+                sink->failed = true;
+            }
+            for (auto sink : stream->remuxSinks) {
+                sink->failed = true;
+            }
+            stream->remuxDone = stream->decodeDone = true;
+            continue;
+        }
+        stream->startSample = std::llround(startTime*stream->sampleRate);
+        stream->endSample = std::llround(endTime*stream->sampleRate);
+        for (auto sink : stream->remuxSinks) {
+            sink->sampleRate = stream->sampleRate;
+            setupRemux(stream.get(), sink);
+        }
+        // The samples are either written into a wav file or piped into the flac encoder.
+        for (auto sink : stream->sinks) {
+            sink->sampleRate = (sink->output.sampleRate > 0) ? sink->output.sampleRate : stream->sampleRate;
+            if (sink->flac) {
+                sink->device = &sink->process;
+            } else {
+                sink->file.setFileName(sink->output.fileName);
+                if (!sink->file.open(QIODevice::WriteOnly|QIODevice::Truncate)) {
+                    emit messages(QString("[error] unable to create file: %1").arg(sink->output.fileName));
+                    sink->failed = true;
+                }
+                sink->device = &sink->file;
+            }
+        }
+    }
+    // Seek all streams to the start of the chapter. The boundaries are applied on the samples.
+    if (av_seek_frame(formatContext, -1, static_cast<int64_t>(startTime*AV_TIME_BASE), AVSEEK_FLAG_BACKWARD) < 0) {
+        emit messages(QString("[error] unable to seek to %1s in movie file: %2").arg(startTime).arg(movieFile));
+        for (auto& sink : sinks) {
+            sink->failed = true;
+        }
+        // Close and remove the outputs already created.
+        for (auto& [streamIndex, stream] : streams) {
+            Q_UNUSED(streamIndex)
+            for (auto sink : stream->remuxSinks) {
+                finish(stream.get(), sink);
+            }
+            for (auto sink : stream->sinks) {
+                finish(stream.get(), sink);
+            }
+        }
+        return extracted;
+    }
+    std::unique_ptr<AVPacket,xMovieFileDemuxFree> packet(av_packet_alloc());
+    std::unique_ptr<AVFrame,xMovieFileDemuxFree> frame(av_frame_alloc());
+    auto isDone = [&]() {
+        return std::all_of(streams.begin(), streams.end(), [](const auto& stream) {
+            return (stream.second->decodeDone) && (stream.second->remuxDone);
+        });
+    };
+    auto progress = 0;
+    while (!isDone()) {
+        if (av_read_frame(formatContext, packet.get()) < 0) {
+            // End of file. Flush the decoders.
+            for (auto& [streamIndex, stream] : streams) {
+                Q_UNUSED(streamIndex)
+                if (stream->decodeDone) {
+                    continue;
+                }
+                avcodec_send_packet(stream->codecContext.get(), nullptr);
+                while ((!stream->decodeDone) && (avcodec_receive_frame(stream->codecContext.get(), frame.get()) == 0)) {
+                    processFrame(stream.get(), frame.get());
+                    av_frame_unref(frame.get());
+                }
+            }
+            break;
+        }
+        auto found = streams.find(packet->stream_index);
+        if (found != streams.end()) {
+            auto stream = found->second.get();
+            if (!stream->remuxDone) {
+                processPacket(stream, packet.get());
+            }
+            if (!stream->decodeDone) {
+                // Decoding errors are skipped as ffmpeg does.
+                avcodec_send_packet(stream->codecContext.get(), packet.get());
+                while ((!stream->decodeDone) && (avcodec_receive_frame(stream->codecContext.get(), frame.get()) == 0)) {
+                    processFrame(stream, frame.get());
+                    av_frame_unref(frame.get());
+                }
+            }
+            // The overall progress is given by the average over all streams.
+            auto currentProgress = 0;
+            for (const auto& entry : streams) {
+                currentProgress += entry.second->progress;
+            }
+            currentProgress /= static_cast<int>(streams.size());
+            if (currentProgress > progress) {
+                progress = currentProgress;
+                emit extractProgress(progress);
+            }
+        }
+        av_packet_unref(packet.get());
+    }
+    // Complete all outputs.
+    for (auto& [streamIndex, stream] : streams) {
+        Q_UNUSED(streamIndex)
+        if ((!stream->sinks.empty()) && (!stream->started) && (stream->codecContext)) {
+            emit messages(QString("[error] no audio found for chapter %1s - %2s").arg(startTime).arg(endTime));
+        }
+        // Write the samples remaining in the resamplers.
+        if ((stream->started) && (!stream->resamples.empty())) {
+            processConverted(stream.get(), nullptr, 0);
+        }
+        for (auto sink : stream->remuxSinks) {
+            extracted[sink->index] = finish(stream.get(), sink);
+        }
+        for (auto sink : stream->sinks) {
+            extracted[sink->index] = finish(stream.get(), sink);
+        }
+    }
+    emit extractProgress(100);
+    return extracted;
+}
+
+bool xMovieFileDemux::convert(const QString& fileName) {
+    if (!open()) {
+        return false;
+    }
+    AVCodecParameters* codecParameters = nullptr;
+    for (unsigned int index = 0; (index < formatContext->nb_streams) && (!codecParameters); ++index) {
+        if (formatContext->streams[index]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
+            codecParameters = formatContext->streams[index]->codecpar;
+        }
+    }
+    if ((!codecParameters) || (formatContext->duration == AV_NOPTS_VALUE)) {
+        emit messages(QString("[error] no audio stream with known duration: %1").arg(movieFile));
+        return false;
+    }
+    xMovieFileDemuxOutput output { fileName, 0, 0, 0, false };
+    switch (codecParameters->codec_id) {
+        case AV_CODEC_ID_DSD_LSBF:
+        case AV_CODEC_ID_DSD_MSBF:
+        case AV_CODEC_ID_DSD_LSBF_PLANAR:
+        case AV_CODEC_ID_DSD_MSBF_PLANAR:
+            output.sampleRate = xMovieFileDemux_DSDSampleRate;
+            output.bitsPerSample = 24;
+            break;
+        default: {
+            // Only lossless streams are archived as flac, e.g. ALAC but not AAC in m4a files.
+            auto descriptor = avcodec_descriptor_get(codecParameters->codec_id);
+            if ((!descriptor) || (!(descriptor->props & AV_CODEC_PROP_LOSSLESS)) || (descriptor->props & AV_CODEC_PROP_LOSSY)) {
+                emit messages(QString("[error] lossy or unknown audio codec %1: %2").
+                        arg((descriptor) ? descriptor->name : "unknown").arg(movieFile));
+                return false;
+            }
+        } break;
+    }
+    // Extract the whole file as one chapter. The end is only used as boundary.
+    auto duration = static_cast<double>(formatContext->duration)/AV_TIME_BASE;
+    return extract({ output }, 0.0, duration+1.0).value(0, false);
+}
+
+bool xMovieFileDemux::setupDecoder(xMovieFileDemuxStream* stream) {
+    if (stream->sinks.empty()) {
+        return true;
+    }
+    auto codec = avcodec_find_decoder(stream->avStream->codecpar->codec_id);
+    stream->codecContext.reset(avcodec_alloc_context3(codec));
+    if ((!codec) || (!stream->codecContext) ||
+        (avcodec_parameters_to_context(stream->codecContext.get(), stream->avStream->codecpar) < 0)) {
+        emit messages(QString("[error] no decoder for audio stream: %1").arg(stream->stream));
+        return false;
+    }
+    stream->codecContext->pkt_timebase = stream->avStream->time_base;
+    if (avcodec_open2(stream->codecContext.get(), codec, nullptr) < 0) {
+        emit messages(QString("[error] unable to open decoder for audio stream: %1").arg(stream->stream));
+        return false;
+    }
+    return true;
+}
+
+void xMovieFileDemux::setupOutputs(xMovieFileDemuxStream* stream) {
+    auto codecContext = stream->codecContext.get();
+    auto speakers = xMovieFileDemuxSpeakers(codecContext);
+    // The channel mask is only valid if all speaker positions are known.
+    quint64 speakerMask = 0;
+    for (const auto& speaker : speakers) {
+        speakerMask |= speaker;
+    }
+    if (speakers.contains(0)) {
+        speakerMask = 0;
+    }
+    auto noiseShaping = xRipEncodeConfiguration::configuration()->getDitherNoiseShaping();
+    stream->channels = speakers.count();
+    for (auto sink : stream->sinks) {
+        if (sink->failed) {
+            continue;
+        }
+        if (sink->converted) {
+            if (!stream->planarConverter) {
+                stream->planarConverter.reset(xMovieFileDemuxConverter(codecContext, AV_SAMPLE_FMT_FLTP));
+            }
+            if ((sink->output.downMix) && (!stream->downMix)) {
+                auto levels = xRipEncodeConfiguration::configuration()->getDownMixLevels();
+                stream->downMix = std::make_unique<xAudioDownMix>(speakers, xAudioDownMixLevels{ levels[0], levels[1], levels[2], levels[3] });
+            }
+            sink->channels = (sink->output.downMix) ? 2 : speakers.count();
+            sink->channelMask = (sink->output.downMix) ? 0x3 : static_cast<quint32>(speakerMask);
+            // Outputs with the same sample rate and channels share the resampler.
+            if (sink->sampleRate != stream->sampleRate) {
+                auto& resample = stream->resamples[std::make_pair(sink->sampleRate, sink->output.downMix)];
+                if (!resample.resample) {
+                    resample.resample = std::make_unique<xAudioResample>(sink->channels, stream->sampleRate, sink->sampleRate);
+                }
+                sink->resample = &resample;
+            }
+            sink->dither = std::make_unique<xAudioDither>(sink->channels, sink->output.bitsPerSample, noiseShaping);
+        } else {
+            if (sink->output.bitsPerSample <= 0) {
+                // Keep the bits per sample of the stream. Wider samples (e.g. float) are stored as 24 bit.
+                auto bitsPerSample = (codecContext->bits_per_raw_sample > 0) ? codecContext->bits_per_raw_sample :
+                        av_get_bytes_per_sample(codecContext->sample_fmt)*8;
+                sink->output.bitsPerSample = (bitsPerSample <= 16) ? 16 : 24;
+            }
+            auto format = (sink->output.bitsPerSample <= 16) ? AV_SAMPLE_FMT_S16 : AV_SAMPLE_FMT_S32;
+            sink->converter.reset(xMovieFileDemuxConverter(codecContext, format));
+            sink->channels = speakers.count();
+            sink->channelMask = static_cast<quint32>(speakerMask);
+        }
+        if (((sink->converted) && (!stream->planarConverter)) || ((!sink->converted) && (!sink->converter)) ||
+            (sink->channels <= 0)) {
+            emit messages(QString("[error] unable to convert audio stream: %1").arg(stream->stream));
+            sink->failed = true;
+        } else if (sink->flac) {
+            if (!startEncoder(sink->process, sink->output.fileName, sink->channels, sink->sampleRate, sink->output.bitsPerSample)) {
+                emit messages(QString("[error] unable to start flac encoder for file: %1").arg(sink->output.fileName));
+                sink->failed = true;
+            }
+        } else {
+            // Write a preliminary header. The sizes are updated once the chapter is complete.
+            writeHeader(sink->file, sink->channels, sink->sampleRate, sink->output.bitsPerSample, sink->channelMask, 0);
+        }
+    }
+}
+
+void xMovieFileDemux::setupRemux(xMovieFileDemuxStream* stream, xMovieFileDemuxSink* sink) {
+    auto fileName = sink->output.fileName.toUtf8();
+    AVFormatContext* context = nullptr;
+    if (avformat_alloc_output_context2(&context, nullptr, "flac", fileName.constData()) < 0) {
+        emit messages(QString("[error] unable to create file: %1").arg(sink->output.fileName));
+        sink->failed = true;
+        return;
+    }
+    sink->muxer.reset(context);
+    sink->muxerStream = avformat_new_stream(context, nullptr);
+    if ((!sink->muxerStream) || (avcodec_parameters_copy(sink->muxerStream->codecpar, stream->avStream->codecpar) < 0) ||
+        (avio_open(&context->pb, fileName.constData(), AVIO_FLAG_WRITE) < 0)) {
+        emit messages(QString("[error] unable to create file: %1").arg(sink->output.fileName));
+        sink->failed = true;
+        return;
+    }
+    sink->muxerStream->codecpar->codec_tag = 0;
+    sink->muxerStream->time_base = AVRational{ 1, stream->sampleRate };
+    // The stream info of the source describes the whole stream. The MD5 signature is cleared
+    // (not computed) and the number of samples is updated once the chapter is complete.
+    auto codecParameters = sink->muxerStream->codecpar;
+    auto streamInfo = codecParameters->extradata;
+    if ((codecParameters->extradata_size >= xMovieFileDemux_StreamInfoOffset+xMovieFileDemux_StreamInfoSize) &&
+        (std::memcmp(streamInfo, "fLaC", 4) == 0)) {
+        streamInfo += xMovieFileDemux_StreamInfoOffset;
+    }
+    if ((streamInfo) && (codecParameters->extradata+codecParameters->extradata_size-streamInfo >= xMovieFileDemux_StreamInfoSize)) {
+        xMovieFileDemuxTotalSamples(streamInfo, 0);
+        std::memset(streamInfo+xMovieFileDemux_StreamInfoMD5, 0, xMovieFileDemux_StreamInfoSize-xMovieFileDemux_StreamInfoMD5);
+    }
+    if (avformat_write_header(context, nullptr) < 0) {
+        emit messages(QString("[error] unable to write file: %1").arg(sink->output.fileName));
+        sink->failed = true;
+    }
+}
+
+void xMovieFileDemux::processPacket(xMovieFileDemuxStream* stream, AVPacket* packet) {
+    if (packet->pts == AV_NOPTS_VALUE) {
+        return;
+    }
+    // A packet belongs to the chapter its first sample is in. Consecutive chapters
+    // are therefore split at the frame boundary next to the chapter start.
+    AVRational sampleTimeBase { 1, stream->sampleRate };
+    auto position = av_rescale_q(packet->pts, stream->avStream->time_base, sampleTimeBase);
+    if (position < stream->startSample) {
+        return;
+    }
+    if (position >= stream->endSample) {
+        stream->remuxDone = true;
+        return;
+    }
+    if (stream->firstPacketSample == AV_NOPTS_VALUE) {
+        stream->firstPacketSample = position;
+    }
+    for (auto sink : stream->remuxSinks) {
+        if (sink->failed) {
+            continue;
+        }
+        std::unique_ptr<AVPacket,xMovieFileDemuxFree> copy(av_packet_clone(packet));
+        if (!copy) {
+            sink->failed = true;
+            continue;
+        }
+        copy->stream_index = 0;
+        copy->pts = copy->dts = av_rescale_q(position-stream->firstPacketSample, sampleTimeBase, sink->muxerStream->time_base);
+        copy->duration = av_rescale_q(packet->duration, stream->avStream->time_base, sink->muxerStream->time_base);
+        copy->pos = -1;
+        auto size = copy->size;
+        auto samples = copy->duration;
+        if (av_write_frame(sink->muxer.get(), copy.get()) < 0) {
+            emit messages(QString("[error] unable to write file: %1").arg(sink->output.fileName));
+            sink->failed = true;
+            continue;
+        }
+        sink->dataSize += size;
+        // The muxer time base is one sample.
+        sink->remuxSamples = position-stream->firstPacketSample+samples;
+    }
+    stream->remuxDone = std::all_of(stream->remuxSinks.begin(), stream->remuxSinks.end(),
+                                    [](const auto& sink) { return sink->failed; });
+    stream->progress = std::max(stream->progress, static_cast<int>(std::clamp<int64_t>(
+            (position-stream->startSample)*100/std::max<int64_t>(stream->endSample-stream->startSample, 1), 0, 100)));
+}
+
+void xMovieFileDemux::processFrame(xMovieFileDemuxStream* stream, AVFrame* frame) {
+    // Only the first timestamp is used. Subsequent frames are positioned by counting samples.
+    if (stream->position == AV_NOPTS_VALUE) {
+        if (frame->best_effort_timestamp == AV_NOPTS_VALUE) {
+            return;
+        }
+        stream->position = av_rescale_q(frame->best_effort_timestamp, stream->avStream->time_base,
+                                        AVRational{ 1, stream->sampleRate });
+    }
+    auto frameStart = stream->position;
+    auto frameEnd = stream->position+frame->nb_samples;
+    stream->position = frameEnd;
+    if (frameEnd <= stream->startSample) {
+        return;
+    }
+    if (frameStart >= stream->endSample) {
+        stream->decodeDone = true;
+        return;
+    }
+    if (!stream->started) {
+        setupOutputs(stream);
+        stream->started = true;
+    }
+    // Cut the frame at the chapter boundaries.
+    auto skip = static_cast<int>(std::max<int64_t>(stream->startSample-frameStart, 0));
+    auto count = static_cast<int>(std::min<int64_t>(stream->endSample, frameEnd)-frameStart)-skip;
+    if (count <= 0) {
+        return;
+    }
+    auto inputData = const_cast<const uint8_t**>(frame->extended_data);
+    // Convert the frame for each native output.
+    for (auto sink : stream->sinks) {
+        if ((sink->failed) || (sink->converted)) {
+            continue;
+        }
+        auto format = (sink->output.bitsPerSample <= 16) ? AV_SAMPLE_FMT_S16 : AV_SAMPLE_FMT_S32;
+        auto convertBytes = av_get_bytes_per_sample(format);
+        auto capacity = swr_get_out_samples(sink->converter.get(), frame->nb_samples);
+        stream->convertBuffer.resize(static_cast<size_t>(std::max(capacity, 0))*sink->channels*convertBytes);
+        auto convertData = stream->convertBuffer.data();
+        auto converted = swr_convert(sink->converter.get(), &convertData, capacity, inputData, frame->nb_samples);
+        if (converted < skip+count) {
+            emit messages(QString("[error] unable to convert audio stream: %1").arg(stream->stream));
+            sink->failed = true;
+            continue;
+        }
+        xMovieFileDemuxPack(stream->convertBuffer.data()+static_cast<size_t>(skip)*sink->channels*convertBytes,
+                            count*sink->channels, convertBytes, sink->output.bitsPerSample/8, stream->writeBuffer);
+        write(sink, stream->writeBuffer);
+    }
+    // Convert the frame once into planar float samples for all converted outputs.
+    if (stream->planarConverter) {
+        auto capacity = std::max(swr_get_out_samples(stream->planarConverter.get(), frame->nb_samples), 0);
+        stream->planarBuffer.resize(static_cast<size_t>(capacity)*stream->channels);
+        std::vector<uint8_t*> planes(static_cast<size_t>(stream->channels));
+        std::vector<const float*> inputPlanes(static_cast<size_t>(stream->channels));
+        for (auto c = 0; c < stream->channels; ++c) {
+            planes[c] = reinterpret_cast<uint8_t*>(stream->planarBuffer.data()+static_cast<size_t>(c)*capacity);
+            inputPlanes[c] = stream->planarBuffer.data()+static_cast<size_t>(c)*capacity+skip;
+        }
+        auto converted = swr_convert(stream->planarConverter.get(), planes.data(), capacity, inputData, frame->nb_samples);
+        if (converted < skip+count) {
+            emit messages(QString("[error] unable to convert audio stream: %1").arg(stream->stream));
+            for (auto sink : stream->sinks) {
+                sink->failed = (sink->failed) || (sink->converted);
+            }
+            stream->planarConverter.reset();
+        } else {
+            // Down mix the frame once for all down mix outputs.
+            if (stream->downMix) {
+                stream->leftBuffer.resize(static_cast<size_t>(count));
+                stream->rightBuffer.resize(static_cast<size_t>(count));
+                stream->downMix->process(inputPlanes.data(), count, stream->leftBuffer.data(), stream->rightBuffer.data());
+            }
+            processConverted(stream, inputPlanes.data(), count);
+        }
+    }
+    // Stop decoding if all outputs failed.
+    stream->decodeDone = std::all_of(stream->sinks.begin(), stream->sinks.end(), [](const auto& sink) { return sink->failed; });
+    stream->progress = std::max(stream->progress, static_cast<int>(std::clamp<int64_t>(
+            (frameStart+skip+count-stream->startSample)*100/std::max<int64_t>(stream->endSample-stream->startSample, 1), 0, 100)));
+}
+
+void xMovieFileDemux::processConverted(xMovieFileDemuxStream* stream, const float* const* samples, int count) {
+    const float* stereo[] = { stream->leftBuffer.data(), stream->rightBuffer.data() };
+    // Resample once for each sample rate.
+    for (auto& [key, resample] : stream->resamples) {
+        if (samples) {
+            resample.resample->process((key.second) ? stereo : samples, count, resample.output);
+        } else {
+            resample.resample->flush(resample.output);
+        }
+    }
+    std::vector<const float*> resampled;
+    for (auto sink : stream->sinks) {
+        if ((sink->failed) || (!sink->converted)) {
+            continue;
+        }
+        if (sink->resample) {
+            resampled.clear();
+            for (const auto& channel : sink->resample->output) {
+                resampled.push_back(channel.data());
+            }
+            sink->dither->process(resampled.data(), static_cast<int>(sink->resample->output[0].size()), stream->writeBuffer);
+        } else if (samples) {
+            sink->dither->process((sink->output.downMix) ? stereo : samples, count, stream->writeBuffer);
+        } else {
+            continue;
+        }
+        write(sink, stream->writeBuffer);
+    }
+}
+
+void xMovieFileDemux::write(xMovieFileDemuxSink* sink, const QByteArray& samples) {
+    if (sink->device->write(samples) != samples.size()) {
+        emit messages(QString("[error] unable to write file: %1").arg(sink->output.fileName));
+        sink->failed = true;
+        return;
+    }
+    // Do not buffer more than one frame for the encoder.
+    if (sink->flac) {
+        sink->process.waitForBytesWritten(-1);
+    }
+    sink->dataSize += samples.size();
+}
+
+bool xMovieFileDemux::finish(xMovieFileDemuxStream* stream, xMovieFileDemuxSink* sink) {
+    auto failed = sink->failed;
+    if (sink->remux) {
+        if ((!failed) && (stream->firstPacketSample == AV_NOPTS_VALUE)) {
+            emit messages(QString("[error] no audio found for file: %1").arg(sink->output.fileName));
+            failed = true;
+        }
+        if ((!failed) && (av_write_trailer(sink->muxer.get()) < 0)) {
+            emit messages(QString("[error] unable to write file: %1").arg(sink->output.fileName));
+            failed = true;
+        }
+        sink->muxer.reset();
+        // The muxer does not update the stream info for copied packets.
+        if ((!failed) && (!updateStreamInfo(sink->output.fileName, sink->remuxSamples))) {
+            emit messages(QString("[error] unable to update stream info: %1").arg(sink->output.fileName));
+            failed = true;
+        }
+    } else if (sink->flac) {
+        failed = (failed) || (!stream->started);
+        if (sink->process.state() != QProcess::NotRunning) {
+            if (failed) {
+                sink->process.kill();
+            }
+            sink->process.closeWriteChannel();
+            sink->process.waitForFinished(-1);
+            if ((!failed) && ((sink->process.exitStatus() != QProcess::NormalExit) || (sink->process.exitCode() != 0))) {
+                emit messages(QString("[error] flac encoder failed: %1").arg(QString::fromUtf8(sink->process.readAll()).trimmed()));
+                failed = true;
+            }
+        }
+    } else {
+        failed = (failed) || (!stream->started);
+        if ((!failed) && (sink->file.isOpen())) {
+            // Pad odd sized data chunks and update the header.
+            if (sink->dataSize % 2) {
+                sink->file.write("\0", 1);
+            }
+            sink->file.seek(0);
+            writeHeader(sink->file, sink->channels, sink->sampleRate, sink->output.bitsPerSample, sink->channelMask,
+                        static_cast<quint32>(std::min<qint64>(sink->dataSize, 0xFFFFFF00)));
+        }
+        sink->file.close();
+    }
+    if (failed) {
+        QFile::remove(sink->output.fileName);
+        return false;
+    }
+    qDebug() << "xMovieFileDemux::finish: " << sink->output.fileName << ", bytes: " << sink->dataSize;
+    return true;
+}
+
+bool xMovieFileDemux::startEncoder(QProcess& process, const QString& fileName, int channels, int sampleRate, int bitsPerSample) {
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    process.start(xRipEncodeConfiguration::configuration()->getFlac(), {
+            {"-8"}, {"-s"}, {"-f"}, {"--force-raw-format"}, {"--endian=little"}, {"--sign=signed"},
+            QString("--channels=%1").arg(channels), QString("--bps=%1").arg(bitsPerSample),
+            QString("--sample-rate=%1").arg(sampleRate), {"-o"}, fileName, {"-"} });
+    qDebug() << "xMovieFileDemux::startEncoder: process arguments: " << process.arguments();
+    return process.waitForStarted(-1);
+}
+
+bool xMovieFileDemux::updateStreamInfo(const QString& fileName, qint64 samples) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+    auto header = file.read(xMovieFileDemux_StreamInfoOffset+xMovieFileDemux_StreamInfoSize);
+    // The first metadata block is the STREAMINFO block (type 0).
+    if ((header.size() != xMovieFileDemux_StreamInfoOffset+xMovieFileDemux_StreamInfoSize) ||
+        (!header.startsWith("fLaC")) || ((header.at(4) & 0x7F) != 0)) {
+        return false;
+    }
+    auto streamInfo = reinterpret_cast<uint8_t*>(header.data())+xMovieFileDemux_StreamInfoOffset;
+    xMovieFileDemuxTotalSamples(streamInfo, samples);
+    return (file.seek(xMovieFileDemux_StreamInfoOffset)) &&
+           (file.write(header.mid(xMovieFileDemux_StreamInfoOffset)) == xMovieFileDemux_StreamInfoSize);
+}
+
+void xMovieFileDemux::writeHeader(QFile& file, int channels, int sampleRate, int bitsPerSample,
+                                  quint32 channelMask, quint32 dataSize) {
+    // Use the extensible format for multi-channel and high resolution, as ffmpeg does.
+    auto extensible = (channels > 2) || (bitsPerSample > 16);
+    auto blockAlign = channels*bitsPerSample/8;
+    quint32 formatSize = (extensible) ? 40 : 16;
+    QByteArray header;
+    QDataStream headerStream(&header, QIODevice::WriteOnly);
+    headerStream.setByteOrder(QDataStream::LittleEndian);
+    headerStream.writeRawData("RIFF", 4);
+    headerStream << static_cast<quint32>(4+8+formatSize+8+dataSize+(dataSize%2));
+    headerStream.writeRawData("WAVE", 4);
+    headerStream.writeRawData("fmt ", 4);
+    headerStream << formatSize << static_cast<quint16>((extensible) ? 0xFFFE : 1) << static_cast<quint16>(channels)
+                 << static_cast<quint32>(sampleRate) << static_cast<quint32>(sampleRate*blockAlign)
+                 << static_cast<quint16>(blockAlign) << static_cast<quint16>(bitsPerSample);
+    if (extensible) {
+        headerStream << static_cast<quint16>(22) << static_cast<quint16>(bitsPerSample) << channelMask;
+        headerStream.writeRawData(xMovieFileDemux_SubFormatPCM, sizeof(xMovieFileDemux_SubFormatPCM));
+    }
+    headerStream.writeRawData("data", 4);
+    headerStream << dataSize;
+    file.write(header);
+}
@@ -0,0 +1,212 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __XMOVIEFILEDEMUX_H__
+#define __XMOVIEFILEDEMUX_H__
+
+#include <QObject>
+#include <QString>
+#include <QFile>
+#include <QProcess>
+#include <QVector>
+
+struct AVFormatContext;
+struct AVFrame;
+struct AVPacket;
+struct xMovieFileDemuxStream;
+struct xMovieFileDemuxSink;
+
+/**
+ * Output file for an extracted chapter. A sample rate of 0 keeps the sample rate
+ * and samples of the stream, otherwise the samples are resampled and dithered.
+ * Bits per sample of 0 keep the bits per sample of the stream.
+ */
+struct xMovieFileDemuxOutput {
+    QString fileName;
+    int stream;
+    int sampleRate;
+    int bitsPerSample;
+    bool downMix;
+};
+
+/**
+ * @class xMovieFileDemux
+ *
+ * @note Extract chapters out of a movie file using libavformat and libavcodec.
+ * The movie file is opened once and each chapter is extracted by seeking to its
+ * start time. The outputs of a chapter are combined into a plan: the chapter is
+ * read once, each selected audio stream is decoded once and the samples are
+ * distributed to all outputs of the stream (e.g. multi-channel, stereo down mix
+ * or a resampled and dithered CD quality derivative). All other streams are
+ * discarded by the demuxer.
+ * The chapter boundaries are applied on sample level.
+ * If the output is a flac file, FLAC streams are copied without decoding and
+ * all other streams are piped into the flac encoder without a wav file.
+ */
+class xMovieFileDemux:public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor
+     *
+     * @param file path to the movie file as string.
+     * @param parent pointer to the parent object.
+     */
+    explicit xMovieFileDemux(const QString& file, QObject* parent=nullptr);
+    /**
+     * Destructor. Close the movie file.
+     */
+    ~xMovieFileDemux() override;
+    /**
+     * Check if the codec can be passed through into a flac file.
+     *
+     * @param codecName the codec name of the audio stream as reported by ffprobe.
+     * @return true for FLAC and PCM streams, false otherwise.
+     */
+    [[nodiscard]] static bool isPassthrough(const QString& codecName);
+    /**
+     * Extract a chapter into several wav or flac files.
+     *
+     * @param outputs the output files. A file name ending with ".flac" creates a flac file.
+     * @param startTime start of the chapter in seconds.
+     * @param endTime end of the chapter in seconds.
+     * @return a vector with true for each output extracted successfully.
+     */
+    QVector<bool> extract(const QVector<xMovieFileDemuxOutput>& outputs, double startTime, double endTime);
+    /**
+     * Convert the first audio stream of the file into a flac file. DSD streams
+     * are decimated to 24 bit PCM, all other streams keep their format. Streams
+     * of lossy codecs (e.g. AAC in m4a files) are rejected.
+     *
+     * @param fileName the output file name.
+     * @return true if the file was converted successfully, false otherwise.
+     */
+    bool convert(const QString& fileName);
+
+signals:
+    /**
+     * Signal the progress of the extraction. Emitted in the thread calling extract.
+     *
+     * @param progress the extraction progress in percent.
+     */
+    void extractProgress(int progress);
+    /**
+     * Signal errors during the extraction.
+     *
+     * @param msg the error message as string.
+     */
+    void messages(const QString& msg);
+
+private:
+    /**
+     * Open the movie file and read the stream information if necessary.
+     *
+     * @return true if the movie file is open, false otherwise.
+     */
+    bool open();
+    /**
+     * Setup the decoder of the stream if any output requires decoding.
+     *
+     * @param stream the stream state.
+     * @return true if the stream is ready, false otherwise.
+     */
+    bool setupDecoder(xMovieFileDemuxStream* stream);
+    /**
+     * Setup the converters and outputs of the stream after the first frame is decoded.
+     *
+     * @param stream the stream state.
+     */
+    void setupOutputs(xMovieFileDemuxStream* stream);
+    /**
+     * Setup the flac muxer for a copy of the stream.
+     *
+     * @param stream the stream state.
+     * @param sink the output state.
+     */
+    void setupRemux(xMovieFileDemuxStream* stream, xMovieFileDemuxSink* sink);
+    /**
+     * Copy a packet of the stream into all flac muxers.
+     *
+     * @param stream the stream state.
+     * @param packet the packet read from the movie file.
+     */
+    void processPacket(xMovieFileDemuxStream* stream, AVPacket* packet);
+    /**
+     * Cut a decoded frame at the chapter boundaries and write it to all outputs of the stream.
+     *
+     * @param stream the stream state.
+     * @param frame the decoded frame.
+     */
+    void processFrame(xMovieFileDemuxStream* stream, AVFrame* frame);
+    /**
+     * Resample and dither float samples for all outputs of the stream that require conversion.
+     *
+     * @param stream the stream state.
+     * @param samples pointers to the planar samples of each channel, nullptr to flush the resamplers.
+     * @param count number of samples per channel.
+     */
+    void processConverted(xMovieFileDemuxStream* stream, const float* const* samples, int count);
+    /**
+     * Write the converted samples to the output.
+     *
+     * @param sink the output state.
+     * @param samples the samples in output format.
+     */
+    void write(xMovieFileDemuxSink* sink, const QByteArray& samples);
+    /**
+     * Complete the output file. Remove the file on errors.
+     *
+     * @param stream the stream state.
+     * @param sink the output state.
+     * @return true if the output was created successfully, false otherwise.
+     */
+    bool finish(xMovieFileDemuxStream* stream, xMovieFileDemuxSink* sink);
+    /**
+     * Start the flac encoder reading raw samples from stdin.
+     *
+     * @param process the encoder process.
+     * @param fileName the output file name.
+     * @param channels number of channels.
+     * @param sampleRate sample rate in Hz.
+     * @param bitsPerSample bits per sample.
+     * @return true if the encoder was started, false otherwise.
+     */
+    static bool startEncoder(QProcess& process, const QString& fileName, int channels, int sampleRate, int bitsPerSample);
+    /**
+     * Write or update the wav header.
+     *
+     * @param file the output file positioned at the start.
+     * @param channels number of channels.
+     * @param sampleRate sample rate in Hz.
+     * @param bitsPerSample bits per sample.
+     * @param channelMask the speaker positions, 0 if unknown.
+     * @param dataSize size of the sample data in bytes.
+     */
+    static void writeHeader(QFile& file, int channels, int sampleRate, int bitsPerSample,
+                            quint32 channelMask, quint32 dataSize);
+    /**
+     * Update the total number of samples in the stream info of a remuxed flac file.
+     *
+     * @param fileName the flac file.
+     * @param samples the number of samples in the file.
+     * @return true if the stream info was updated, false otherwise.
+     */
+    static bool updateStreamInfo(const QString& fileName, qint64 samples);
+
+    QString movieFile;
+    AVFormatContext* formatContext;
+};
+
+#endif
@@ -0,0 +1,324 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "xMovieFileProbe.h"
+#include <QDebug>
+
+#include <cctype>
+
+// Fields of the stream objects we are interested in.
+const QVector<QByteArray> xMovieFileProbe_StreamKeys {
+    "codec_type", "codec_name", "codec_long_name", "profile", "sample_fmt", "sample_rate",
+    "bits_per_sample", "bits_per_raw_sample", "bit_rate", "channels", "channel_layout"
+};
+// Fields of the chapter objects we are interested in.
+const QVector<QByteArray> xMovieFileProbe_ChapterKeys { "start_time", "end_time" };
+
+xMovieFileProbe::xMovieFileProbe():
+        parserState(State::Value),
+        parserValueIsKey(false),
+        parserValueRequired(false),
+        parserUnicodeDigits(0),
+        parserUnicode(0),
+        stream { "", "", "", "", 44100, 0, 0, 2, "" },
+        streamBitsPerRawSample(0),
+        chapter(0.0, 0.0),
+        duration(0.0) {
+}
+
+bool xMovieFileProbe::parse(const QByteArray& data) {
+    return parse(data.constData(), data.size());
+}
+
+bool xMovieFileProbe::parse(const char* data, qint64 size) {
+    for (qint64 i = 0; i < size; ++i) {
+        // A character terminating a literal needs to be processed again.
+        while (!process(data[i])) {
+        }
+        if (parserState == State::Error) {
+            qCritical() << "xMovieFileProbe: syntax error in json output.";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool xMovieFileProbe::isComplete() const {
+    return (parserState == State::Done);
+}
+
+const QVector<xMovieFileAudioStream>& xMovieFileProbe::getAudioStreams() const {
+    return audioStreams;
+}
+
+const QVector<std::pair<double,double>>& xMovieFileProbe::getChapters() const {
+    return chapters;
+}
+
+double xMovieFileProbe::getDuration() const {
+    return duration;
+}
+
+bool xMovieFileProbe::process(char c) {
+    auto whiteSpace = (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t');
+    switch (parserState) {
+        case State::Value:
+        case State::ValueOrArrayEnd: {
+            if (!whiteSpace) {
+                if ((parserState == State::ValueOrArrayEnd) && (c == ']')) {
+                    endContainer(false);
+                } else {
+                    beginValue(c);
+                }
+            }
+        } break;
+        case State::KeyOrObjectEnd:
+        case State::Key: {
+            if (!whiteSpace) {
+                if ((parserState == State::KeyOrObjectEnd) && (c == '}')) {
+                    endContainer(true);
+                } else if (c == '"') {
+                    parserValue.clear();
+                    parserValueIsKey = true;
+                    parserState = State::String;
+                } else {
+                    parserState = State::Error;
+                }
+            }
+        } break;
+        case State::Colon: {
+            if (!whiteSpace) {
+                parserState = (c == ':') ? State::Value : State::Error;
+            }
+        } break;
+        case State::CommaOrEnd: {
+            if (!whiteSpace) {
+                auto object = parserStack.last().object;
+                if (c == ',') {
+                    parserState = object ? State::Key : State::Value;
+                } else if ((c == '}') && (object)) {
+                    endContainer(true);
+                } else if ((c == ']') && (!object)) {
+                    endContainer(false);
+                } else {
+                    parserState = State::Error;
+                }
+            }
+        } break;
+        case State::String: {
+            if (c == '"') {
+                endValue();
+            } else if (c == '\\') {
+                parserState = State::StringEscape;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                parserState = State::Error;
+            } else if ((parserValueIsKey) || (parserValueRequired)) {
+                parserValue.append(c);
+            }
+        } break;
+        case State::StringEscape: {
+            parserState = State::String;
+            switch (c) {
+                case '"': parserValue.append('"'); break;
+                case '\\': parserValue.append('\\'); break;
+                case '/': parserValue.append('/'); break;
+                case 'b': parserValue.append('\b'); break;
+                case 'f': parserValue.append('\f'); break;
+                case 'n': parserValue.append('\n'); break;
+                case 'r': parserValue.append('\r'); break;
+                case 't': parserValue.append('\t'); break;
+                case 'u': {
+                    parserUnicode = 0;
+                    parserUnicodeDigits = 0;
+                    parserState = State::StringUnicode;
+                } break;
+                default: parserState = State::Error; break;
+            }
+        } break;
+        case State::StringUnicode: {
+            auto digit = QByteArray(1, c).toUInt(nullptr, 16);
+            if (!std::isxdigit(static_cast<unsigned char>(c))) {
+                parserState = State::Error;
+                break;
+            }
+            parserUnicode = (parserUnicode << 4) | digit;
+            if (++parserUnicodeDigits == 4) {
+                parserValue.append(QString(QChar(static_cast<ushort>(parserUnicode))).toUtf8());
+                parserState = State::String;
+            }
+        } break;
+        case State::Literal: {
+            if ((std::isalnum(static_cast<unsigned char>(c))) || (c == '+') || (c == '-') || (c == '.')) {
+                parserValue.append(c);
+            } else {
+                endValue();
+                // Process the terminating character again.
+                return (parserState == State::Error);
+            }
+        } break;
+        case State::Done: {
+            if (!whiteSpace) {
+                parserState = State::Error;
+            }
+        } break;
+        case State::Error: break;
+    }
+    return true;
+}
+
+void xMovieFileProbe::beginValue(char c) {
+    if (c == '{') {
+        parserStack.push_back(Container{ true, currentKey() });
+        startObject();
+        parserState = State::KeyOrObjectEnd;
+    } else if (c == '[') {
+        parserStack.push_back(Container{ false, currentKey() });
+        parserState = State::ValueOrArrayEnd;
+    } else if (c == '"') {
+        parserValue.clear();
+        parserValueIsKey = false;
+        parserValueRequired = isRequired();
+        parserState = State::String;
+    } else if ((c == '-') || (std::isalnum(static_cast<unsigned char>(c)))) {
+        parserValue = QByteArray(1, c);
+        parserValueIsKey = false;
+        parserValueRequired = isRequired();
+        parserState = State::Literal;
+    } else {
+        parserState = State::Error;
+    }
+}
+
+void xMovieFileProbe::endValue() {
+    if (parserValueIsKey) {
+        parserKey = parserValue;
+        parserState = State::Colon;
+        return;
+    }
+    if (parserState == State::Literal) {
+        // Validate literal.
+        auto valid = false;
+        if ((parserValue != "true") && (parserValue != "false") && (parserValue != "null")) {
+            parserValue.toDouble(&valid);
+        } else {
+            valid = true;
+        }
+        if (!valid) {
+            parserState = State::Error;
+            return;
+        }
+    }
+    if ((parserValueRequired) && ((parserState != State::Literal) || (parserValue != "null"))) {
+        scalar(parserValue);
+    }
+    parserState = parserStack.isEmpty() ? State::Done : State::CommaOrEnd;
+}
+
+void xMovieFileProbe::endContainer(bool object) {
+    if (object) {
+        endObject();
+    }
+    parserStack.pop_back();
+    parserState = parserStack.isEmpty() ? State::Done : State::CommaOrEnd;
+}
+
+void xMovieFileProbe::startObject() {
+    if (parserStack.count() != 3) {
+        return;
+    }
+    if (parserStack[1].key == "streams") {
+        stream = xMovieFileAudioStream { "", "", "", "", 44100, 0, 0, 2, "" };
+        streamCodecType.clear();
+        streamBitsPerRawSample = 0;
+    } else if (parserStack[1].key == "chapters") {
+        chapter = std::make_pair(0.0, 0.0);
+    }
+}
+
+void xMovieFileProbe::endObject() {
+    if (parserStack.count() != 3) {
+        return;
+    }
+    if (parserStack[1].key == "streams") {
+        if (streamCodecType == "audio") {
+            if (!stream.bitsPerSample) {
+                stream.bitsPerSample = streamBitsPerRawSample;
+            }
+            audioStreams.push_back(stream);
+        }
+    } else if (parserStack[1].key == "chapters") {
+        chapters.push_back(chapter);
+    }
+}
+
+void xMovieFileProbe::scalar(const QByteArray& value) {
+    if (parserStack.count() == 2) {
+        // Only the duration in the format section is required.
+        duration = value.toDouble();
+        return;
+    }
+    if (parserStack[1].key == "streams") {
+        if (parserKey == "codec_type") {
+            streamCodecType = QString::fromUtf8(value);
+        } else if (parserKey == "codec_name") {
+            stream.codecName = QString::fromUtf8(value);
+        } else if (parserKey == "codec_long_name") {
+            stream.codecLongName = QString::fromUtf8(value);
+        } else if (parserKey == "profile") {
+            stream.profile = QString::fromUtf8(value);
+        } else if (parserKey == "sample_fmt") {
+            stream.sampleFormat = QString::fromUtf8(value);
+        } else if (parserKey == "sample_rate") {
+            stream.sampleRate = value.toInt();
+        } else if (parserKey == "bits_per_sample") {
+            stream.bitsPerSample = value.toInt();
+        } else if (parserKey == "bits_per_raw_sample") {
+            streamBitsPerRawSample = value.toInt();
+        } else if (parserKey == "bit_rate") {
+            stream.bitRate = value.toInt();
+        } else if (parserKey == "channels") {
+            stream.channels = value.toInt();
+        } else if (parserKey == "channel_layout") {
+            stream.channelLayout = QString::fromUtf8(value);
+        }
+    } else if (parserStack[1].key == "chapters") {
+        if (parserKey == "start_time") {
+            chapter.first = value.toDouble();
+        } else if (parserKey == "end_time") {
+            chapter.second = value.toDouble();
+        }
+    }
+}
+
+QByteArray xMovieFileProbe::currentKey() const {
+    if ((parserStack.isEmpty()) || (!parserStack.last().object)) {
+        return QByteArray();
+    }
+    return parserKey;
+}
+
+bool xMovieFileProbe::isRequired() const {
+    if ((parserStack.count() == 2) && (parserStack[1].object)) {
+        return (parserStack[1].key == "format") && (parserKey == "duration");
+    }
+    if ((parserStack.count() == 3) && (parserStack[2].object) && (!parserStack[1].object)) {
+        if (parserStack[1].key == "streams") {
+            return xMovieFileProbe_StreamKeys.contains(parserKey);
+        }
+        if (parserStack[1].key == "chapters") {
+            return xMovieFileProbe_ChapterKeys.contains(parserKey);
+        }
+    }
+    return false;
+}
@@ -0,0 +1,164 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __XMOVIEFILEPROBE_H__
+#define __XMOVIEFILEPROBE_H__
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+struct xMovieFileAudioStream {
+    QString codecName;
+    QString codecLongName;
+    QString profile;
+    QString sampleFormat;
+    int sampleRate;
+    int bitsPerSample;
+    int bitRate;
+    int channels;
+    QString channelLayout;
+};
+
+/**
+ * @class xMovieFileProbe
+ *
+ * @note Streaming (SAX-style) parser for the json output of ffprobe. The output
+ * can be passed in arbitrary chunks. Only the fields required for the audio
+ * streams, the chapters and the duration are kept. All other values are
+ * validated but skipped without building any intermediate tree.
+ */
+class xMovieFileProbe {
+public:
+    xMovieFileProbe();
+    ~xMovieFileProbe() = default;
+    /**
+     * Parse the next chunk of the ffprobe output.
+     *
+     * @param data pointer to the chunk.
+     * @param size the size of the chunk in bytes.
+     * @return true if the chunk was parsed successfully, false on syntax errors.
+     */
+    bool parse(const char* data, qint64 size);
+    /**
+     * Parse the next chunk of the ffprobe output.
+     *
+     * @param data the chunk as byte array.
+     * @return true if the chunk was parsed successfully, false on syntax errors.
+     */
+    bool parse(const QByteArray& data);
+    /**
+     * Check if the complete json document has been parsed.
+     *
+     * @return true if the document is complete and valid, false otherwise.
+     */
+    [[nodiscard]] bool isComplete() const;
+    /**
+     * Retrieve the audio streams found.
+     *
+     * @return a vector of audio stream structures.
+     */
+    [[nodiscard]] const QVector<xMovieFileAudioStream>& getAudioStreams() const;
+    /**
+     * Retrieve the chapters found.
+     *
+     * @return a vector of pairs of start and end time in seconds.
+     */
+    [[nodiscard]] const QVector<std::pair<double,double>>& getChapters() const;
+    /**
+     * Retrieve the duration of the movie file from the format section.
+     *
+     * @return the duration in seconds.
+     */
+    [[nodiscard]] double getDuration() const;
+
+private:
+    enum class State {
+        Value, ValueOrArrayEnd, KeyOrObjectEnd, Key, Colon, CommaOrEnd,
+        String, StringEscape, StringUnicode, Literal, Done, Error
+    };
+    struct Container {
+        bool object;
+        QByteArray key;
+    };
+    /**
+     * Process a single character.
+     *
+     * @param c the current character.
+     * @return true if the character was consumed, false if it needs to be processed again.
+     */
+    bool process(char c);
+    /**
+     * Begin a new value (object, array, string or literal).
+     *
+     * @param c the first character of the value.
+     */
+    void beginValue(char c);
+    /**
+     * Finish the current scalar value (string or literal).
+     */
+    void endValue();
+    /**
+     * Finish the current container (object or array).
+     *
+     * @param object true if an object is closed, false for an array.
+     */
+    void endContainer(bool object);
+    /**
+     * Start a new object. Begin a stream or chapter if applicable.
+     */
+    void startObject();
+    /**
+     * End the current object. Store a stream or chapter if applicable.
+     */
+    void endObject();
+    /**
+     * Store the scalar value if it belongs to a field we are interested in.
+     *
+     * @param value the scalar value as byte array.
+     */
+    void scalar(const QByteArray& value);
+    /**
+     * Determine the key for a new value in the current container.
+     *
+     * @return the key if the current container is an object, empty otherwise.
+     */
+    [[nodiscard]] QByteArray currentKey() const;
+    /**
+     * Determine if the next scalar value at the current position is required.
+     *
+     * @return true if the value is required, false otherwise.
+     */
+    [[nodiscard]] bool isRequired() const;
+
+    State parserState;
+    QVector<Container> parserStack;
+    QByteArray parserKey;
+    QByteArray parserValue;
+    bool parserValueIsKey;
+    bool parserValueRequired;
+    int parserUnicodeDigits;
+    uint parserUnicode;
+    // Current stream and chapter object.
+    QString streamCodecType;
+    xMovieFileAudioStream stream;
+    int streamBitsPerRawSample;
+    std::pair<double,double> chapter;
+    // Results.
+    QVector<xMovieFileAudioStream> audioStreams;
+    QVector<std::pair<double,double>> chapters;
+    double duration;
+};
+
+#endif
@@ -14,19 +14,27 @@
 
 #include "xMovieFileTrack.h"
 #include "xRipEncodeConfiguration.h"
+#include "xTempSpace.h"
 
 #include <QDebug>
 #include <QProcess>
 #include <QStringList>
+#include <QRegularExpression>
 #include <filesystem>
 #include <cmath>
+#include <algorithm>
+
+// Matches the key/value lines written by ffmpeg with "-progress".
+const QRegularExpression xMovieFileTrack_ProgressLine { R"(^(\w+)=(.*)$)" };
 
 xMovieFileTrack::xMovieFileTrack(double startTime, double endTime, QObject* parent):
     QObject(parent),
     trackStartTime(startTime),
     trackEndTime(endTime),
     trackFileName(),
-    extractProcess(nullptr) {
+    extractProcess(nullptr),
+    extractOutput(),
+    extractProgressPercent(0) {
     // required assertion.
     assert(trackStartTime <= trackEndTime);
 }
@@ -45,6 +53,7 @@ void xMovieFileTrack::removeFile() {
         } catch (std::filesystem::filesystem_error& e)  {
             qCritical() << "Unable to remove track filename: " << trackFileName << ", error: " << e.what();
         }
+        xTempSpace::tempSpace()->release(trackFileName);
 
     }
 }
@@ -54,10 +63,18 @@ qint64 xMovieFileTrack::getLength() const {
     return static_cast<qint64>(std::round((trackEndTime-trackStartTime)*1000.0));
 }
 
-bool xMovieFileTrack::extract(const QString& fileName, int stream, int bitsPerSample, bool downMix) {
+double xMovieFileTrack::getStartTime() const {
+    return trackStartTime;
+}
+
+double xMovieFileTrack::getEndTime() const {
+    return trackEndTime;
+}
+
+bool xMovieFileTrack::extract(const QString& fileName, int stream, int sampleRate, int bitsPerSample, bool downMix) {
     // Prepare arguments for audio track extraction
     QStringList extractArguments {
-            "-v", "error", "-y", "-i", trackFileName, "-map", QString("0:%1").arg(stream),
+            "-v", "error", "-nostats", "-progress", "pipe:1", "-y", "-i", trackFileName, "-map", QString("0:%1").arg(stream),
             "-acodec", QString("pcm_s%1le").arg(bitsPerSample)
     };
     if (downMix) {
@@ -65,14 +82,24 @@ bool xMovieFileTrack::extract(const QString& fileName, int stream, int bitsPerSa
         extractArguments.push_back("-ac");
         extractArguments.push_back("2");
     }
+    if (sampleRate > 0) {
+        // Use the same dither as the internal demuxer.
+        extractArguments.push_back("-af");
+        extractArguments.push_back(QString("aresample=%1:dither_method=%2").arg(sampleRate).
+                arg(xRipEncodeConfiguration::configuration()->getDitherNoiseShaping() ? "lipshitz" : "triangular"));
+    }
     extractArguments.push_back(fileName);
     qDebug() << "xMovieFileTrack::extract: arguments: " << extractArguments.join(" ");
     // Setup extraction process.
     extractProcess = new QProcess();
     extractProcess->setProcessChannelMode(QProcess::MergedChannels);
-    connect(extractProcess, &QProcess::readyReadStandardOutput, this, &xMovieFileTrack::processExtractOutput);
+    extractOutput.clear();
+    extractProgressPercent = 0;
+    // Parse the output in the thread waiting for the process.
+    connect(extractProcess, &QProcess::readyReadStandardOutput, this, &xMovieFileTrack::processExtractOutput, Qt::DirectConnection);
     extractProcess->start(xRipEncodeConfiguration::configuration()->getFFMpeg(), extractArguments);
     extractProcess->waitForFinished(-1);
+    processExtractOutput();
     disconnect(extractProcess, &QProcess::readyReadStandardOutput, this, &xMovieFileTrack::processExtractOutput);
     auto exitCode = extractProcess->exitCode();
     delete extractProcess;
@@ -89,8 +116,36 @@ bool xMovieFileTrack::extract(const QString& fileName, int stream, int bitsPerSa
 }
 
 void xMovieFileTrack::processExtractOutput() {
-    QString processOutput(extractProcess->readAllStandardOutput());
-    emit
-    qDebug() << "stdOut: " << processOutput;
+    extractOutput.append(extractProcess->readAllStandardOutput());
+    auto trackLength = (trackEndTime-trackStartTime)*1000000.0;
+    int lineStart = 0;
+    int lineEnd;
+    // Only process complete lines. Keep the remainder for the next chunk.
+    while ((lineEnd = extractOutput.indexOf('\n', lineStart)) >= 0) {
+        auto line = QString::fromUtf8(extractOutput.constData()+lineStart, lineEnd-lineStart).trimmed();
+        lineStart = lineEnd+1;
+        auto lineMatch = xMovieFileTrack_ProgressLine.match(line);
+        if (!lineMatch.hasMatch()) {
+            if (!line.isEmpty()) {
+                emit messages(line);
+            }
+            continue;
+        }
+        auto key = lineMatch.capturedRef(1);
+        int percent;
+        if ((key == QLatin1String("out_time_us")) || (key == QLatin1String("out_time_ms"))) {
+            // Both values are in microseconds.
+            auto outTime = lineMatch.capturedRef(2).toLongLong();
+            percent = (trackLength > 0) ? static_cast<int>(std::clamp(outTime*100.0/trackLength, 0.0, 100.0)) : 0;
+        } else if ((key == QLatin1String("progress")) && (lineMatch.capturedRef(2) == QLatin1String("end"))) {
+            percent = 100;
+        } else {
+            continue;
+        }
+        if (percent > extractProgressPercent) {
+            extractProgressPercent = percent;
+            emit extractProgress(extractProgressPercent);
+        }
+    }
+    extractOutput.remove(0, lineStart);
 }
-
@@ -40,6 +40,18 @@ public:
      * @return length of the track in milliseconds.
      */
     [[nodiscard]] qint64 getLength() const;
+    /**
+     * Return the start of the current track.
+     *
+     * @return start of the track within the movie file in seconds.
+     */
+    [[nodiscard]] double getStartTime() const;
+    /**
+     * Return the end of the current track.
+     *
+     * @return end of the track within the movie file in seconds.
+     */
+    [[nodiscard]] double getEndTime() const;
     /**
      * Attach a filename to the current track.
      *
@@ -55,12 +67,30 @@ public:
      *
      * @param fileName the output file name.
      * @param stream the index of the audio stream.
+     * @param sampleRate resample the audio stream if not 0.
      * @param bitsPerSample bits per sample for the audio stream.
      * @param downMix down mix the audio stream to stereo if true.
      */
-    bool extract(const QString& fileName, int stream, int bitsPerSample, bool downMix);
+    bool extract(const QString& fileName, int stream, int sampleRate, int bitsPerSample, bool downMix);
+
+signals:
+    /**
+     * Signal the progress of the extraction. Emitted in the thread calling extract.
+     *
+     * @param progress the extraction progress in percent.
+     */
+    void extractProgress(int progress);
+    /**
+     * Signal the output of the extraction process that is not progress information.
+     *
+     * @param msg the output as string.
+     */
+    void messages(const QString& msg);
 
 private slots:
+    /**
+     * Parse the key/value progress output of ffmpeg line by line.
+     */
     void processExtractOutput();
 
 private:
@@ -68,6 +98,8 @@ private:
     double trackEndTime;
     QString trackFileName;
     QProcess* extractProcess;
+    QByteArray extractOutput;
+    int extractProgressPercent;
 };
 
 #endif
@@ -15,6 +15,7 @@
 #include "xRipEncodeConfiguration.h"
 
 #include <filesystem>
+#include <QCoreApplication>
 #include <QList>
 #include <QUrl>
 #include <QRegularExpression>
@@ -22,6 +23,7 @@
 
 // Configuration strings.
 const char* xRipEncodeConfiguration_TempDirectory { "xRipEncode/TempDirectory" };
+const char* xRipEncodeConfiguration_TempSpaceQuota { "xRipEncode/TempSpaceQuota" };
 const char* xRipEncodeConfiguration_BackupDirectory { "xRipEncode/BackupDirectory" };
 const char* xRipEncodeConfiguration_EncodingDirectory { "xRipEncode/EncodingDirectory" };
 const char* xRipEncodeConfiguration_FileNameFormat { "xRipEncode/FileNameFormat" };
@@ -36,10 +38,20 @@ const char* xRipEncodeConfiguration_MKVExtract { "xRipEncode/MKVExtract" };
 const char* xRipEncodeConfiguration_Flac { "xRipEncode/Flac" };
 const char* xRipEncodeConfiguration_WavPack { "xRipEncode/WavPack" };
 const char* xRipEncodeConfiguration_LLTag { "xRipEncode/LLTag" };
+const char* xRipEncodeConfiguration_MovieFileDemux { "xRipEncode/MovieFileDemux" };
+const char* xRipEncodeConfiguration_MovieFilePassthrough { "xRipEncode/MovieFilePassthrough" };
+const char* xRipEncodeConfiguration_ArchiveFileIntegrityScan { "xRipEncode/ArchiveFileIntegrityScan" };
+const char* xRipEncodeConfiguration_AudioCDMaxRetries { "xRipEncode/AudioCDMaxRetries" };
+const char* xRipEncodeConfiguration_DownMixLevels { "xRipEncode/DownMixLevels" };
+const char* xRipEncodeConfiguration_DitherNoiseShaping { "xRipEncode/DitherNoiseShaping" };
+const char* xRipEncodeConfiguration_ReplayGain { "xRipEncode/ReplayGain" };
+const char* xRipEncodeConfiguration_Verify { "xRipEncode/Verify" };
 const char* xRipEncodeConfiguration_Tags { "xRipEncode/Tags" };
 const char* xRipEncodeConfiguration_TagInfos { "xRipEncode/TagInfos" };
+const char* xRipEncodeConfiguration_TagLookupSchemes { "xRipEncode/TagLookupSchemes" };
 // Default values.
 const char* xRipEncodeConfiguration_TempDirectory_Default { "/tmp" };
+const int xRipEncodeConfiguration_TempSpaceQuota_Default = 0;
 const char* xRipEncodeConfiguration_BackupDirectory_Default { "/tmp" };
 const char* xRipEncodeConfiguration_EncodingDirectory_Default { "/tmp" };
 const char* xRipEncodeConfiguration_FileNameFormat_Default { "(artist)#(album)(tag)#(tracknr) (trackname)" };
@@ -54,8 +66,28 @@ const char* xRipEncodeConfiguration_MKVExtract_Default { "/usr/bin/mkvextract" }
 const char* xRipEncodeConfiguration_Flac_Default { "/usr/bin/flac" };
 const char* xRipEncodeConfiguration_WavPack_Default { "/usr/bin/wavpack" };
 const char* xRipEncodeConfiguration_LLTag_Default { "/usr/bin/lltag" };
+const bool xRipEncodeConfiguration_MovieFileDemux_Default = true;
+const bool xRipEncodeConfiguration_MovieFilePassthrough_Default = true;
+const bool xRipEncodeConfiguration_ArchiveFileIntegrityScan_Default = true;
+// Default of paranoia.
+const int xRipEncodeConfiguration_AudioCDMaxRetries_Default = 20;
+// Levels for center, lfe, surround and back channels.
+const char* xRipEncodeConfiguration_DownMixLevels_Default { "0.7071|0|0.7071|0.7071" };
+const bool xRipEncodeConfiguration_DitherNoiseShaping_Default = false;
+const bool xRipEncodeConfiguration_ReplayGain_Default = true;
+const bool xRipEncodeConfiguration_Verify_Default = true;
 const char* xRipEncodeConfiguration_Tags_Default { "| [hd]| [%1.1]| [hd-%1.1]" };
 const char* xRipEncodeConfiguration_TagInfos_Default { "CD/Stereo|HD/Stereo|CD/MultiChannel|HD/MultiChannel" };
+// Scheme definitions: name;bits per sample;quality markers;flags;pattern
+const QStringList xRipEncodeConfiguration_TagLookupSchemes_Default {
+    R"(Qobuz;0;smr=24,smrp=24,lls=16;underscores;^(?<artist>.*?)-(?<album>.*)/(?<disc>\d\d)-(?<nr>\d+)-(?:\k<artist>-)?(?<name>.*)-(?<quality>smrp|smr|lls)\.flac$)",
+    R"(7Digital;16;;;^(?<artist>.*)/(?<album>.*)/(.*) - (?<nr>\d\d)\. (?<name>.*)\.\w+$)",
+    R"(Bandcamp;16;;;^(?<artist>.*?) - (?<album>.*) - (?<nr>\d\d) (?<name>.*)\.\w+$)",
+    R"(HighResAudio;24;;;^(?:.*/)?(?<artist>[^/]*?) - (?<album>[^/]*)/(?<nr>\d+)[ ._-]+(?<name>[^/]*)\.\w+$)",
+    R"(HDtracks;24;;;^(?:.*/)?(?<artist>[^/]*?) - (?<album>[^/]*)/(?:(?<disc>\d+)-)?(?<nr>\d\d)[ ._-]+(?<name>[^/]*)\.\w+$)"
+};
+// Delay in ms before changed settings are written to disk.
+const int xRipEncodeConfiguration_SyncDelay { 1000 };
 
 // singleton object.
 xRipEncodeConfiguration* xRipEncodeConfiguration::ripEncodeConfiguration = nullptr;
@@ -64,6 +96,73 @@ xRipEncodeConfiguration::xRipEncodeConfiguration():
         QObject() {
     // Settings.
     settings = new QSettings(xRipEncodeConfiguration::OrganisationName, xRipEncodeConfiguration::ApplicationName, this);
+    // Coalesce writing the settings to disk.
+    settingsSyncTimer = new QTimer(this);
+    settingsSyncTimer->setSingleShot(true);
+    settingsSyncTimer->setInterval(xRipEncodeConfiguration_SyncDelay);
+    connect(settingsSyncTimer, &QTimer::timeout, settings, &QSettings::sync);
+    if (QCoreApplication::instance()) {
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, settings, &QSettings::sync);
+    }
+    updateSnapshot();
+}
+
+std::shared_ptr<const xRipEncodeConfigurationSnapshot> xRipEncodeConfiguration::snapshot() const {
+    QReadLocker locker(&configurationSnapshotLock);
+    return configurationSnapshot;
+}
+
+void xRipEncodeConfiguration::updateSnapshot() {
+    auto newSnapshot = std::make_shared<xRipEncodeConfigurationSnapshot>();
+    newSnapshot->tempDirectory = settings->value(xRipEncodeConfiguration_TempDirectory,
+                                                 xRipEncodeConfiguration_TempDirectory_Default).toString();
+    newSnapshot->tempSpaceQuota = settings->value(xRipEncodeConfiguration_TempSpaceQuota,
+                                                  xRipEncodeConfiguration_TempSpaceQuota_Default).toInt();
+    newSnapshot->backupDirectory = settings->value(xRipEncodeConfiguration_BackupDirectory,
+                                                   xRipEncodeConfiguration_BackupDirectory_Default).toString();
+    newSnapshot->encodingDirectory = settings->value(xRipEncodeConfiguration_EncodingDirectory,
+                                                     xRipEncodeConfiguration_EncodingDirectory_Default).toString();
+    newSnapshot->fileNameFormat = settings->value(xRipEncodeConfiguration_FileNameFormat,
+                                                  xRipEncodeConfiguration_FileNameFormat_Default).toString();
+    newSnapshot->fileNameReplace = xRipEncodeConfiguration::stringsToList(
+            settings->value(xRipEncodeConfiguration_FileNameReplaceFrom, xRipEncodeConfiguration_FileNameReplaceFrom_Default).toString(),
+            settings->value(xRipEncodeConfiguration_FileNameReplaceTo, xRipEncodeConfiguration_FileNameReplaceTo_Default).toString());
+    newSnapshot->fileNameLowerCase = settings->value(xRipEncodeConfiguration_FileNameLowerCase,
+                                                     xRipEncodeConfiguration_FileNameLower_Default).toBool();
+    newSnapshot->encodingFormat = settings->value(xRipEncodeConfiguration_EncodingFormat,
+                                                  xRipEncodeConfiguration_EncodingFormat_Default).toString();
+    newSnapshot->ffmpeg = settings->value(xRipEncodeConfiguration_FFMpeg, xRipEncodeConfiguration_FFMpeg_Default).toString();
+    newSnapshot->ffprobe = settings->value(xRipEncodeConfiguration_FFProbe, xRipEncodeConfiguration_FFProbe_Default).toString();
+    newSnapshot->mkvmerge = settings->value(xRipEncodeConfiguration_MKVMerge, xRipEncodeConfiguration_MKVMerge_Default).toString();
+    newSnapshot->mkvextract = settings->value(xRipEncodeConfiguration_MKVExtract, xRipEncodeConfiguration_MKVExtract_Default).toString();
+    newSnapshot->flac = settings->value(xRipEncodeConfiguration_Flac, xRipEncodeConfiguration_Flac_Default).toString();
+    newSnapshot->wavpack = settings->value(xRipEncodeConfiguration_WavPack, xRipEncodeConfiguration_WavPack_Default).toString();
+    newSnapshot->lltag = settings->value(xRipEncodeConfiguration_LLTag, xRipEncodeConfiguration_LLTag_Default).toString();
+    newSnapshot->movieFileDemux = settings->value(xRipEncodeConfiguration_MovieFileDemux,
+                                                  xRipEncodeConfiguration_MovieFileDemux_Default).toBool();
+    newSnapshot->movieFilePassthrough = settings->value(xRipEncodeConfiguration_MovieFilePassthrough,
+                                                        xRipEncodeConfiguration_MovieFilePassthrough_Default).toBool();
+    newSnapshot->archiveFileIntegrityScan = settings->value(xRipEncodeConfiguration_ArchiveFileIntegrityScan,
+                                                            xRipEncodeConfiguration_ArchiveFileIntegrityScan_Default).toBool();
+    newSnapshot->audioCDMaxRetries = settings->value(xRipEncodeConfiguration_AudioCDMaxRetries,
+                                                     xRipEncodeConfiguration_AudioCDMaxRetries_Default).toInt();
+    newSnapshot->downMixLevels = xRipEncodeConfiguration::stringToLevels(
+            settings->value(xRipEncodeConfiguration_DownMixLevels, xRipEncodeConfiguration_DownMixLevels_Default).toString());
+    newSnapshot->ditherNoiseShaping = settings->value(xRipEncodeConfiguration_DitherNoiseShaping,
+                                                      xRipEncodeConfiguration_DitherNoiseShaping_Default).toBool();
+    newSnapshot->replayGain = settings->value(xRipEncodeConfiguration_ReplayGain, xRipEncodeConfiguration_ReplayGain_Default).toBool();
+    newSnapshot->verify = settings->value(xRipEncodeConfiguration_Verify, xRipEncodeConfiguration_Verify_Default).toBool();
+    newSnapshot->tags = settings->value(xRipEncodeConfiguration_Tags, xRipEncodeConfiguration_Tags_Default).toString().split('|');
+    newSnapshot->tagInfos = settings->value(xRipEncodeConfiguration_TagInfos, xRipEncodeConfiguration_TagInfos_Default).toString().split('|');
+    newSnapshot->tagLookupSchemes = settings->value(xRipEncodeConfiguration_TagLookupSchemes,
+                                                    xRipEncodeConfiguration_TagLookupSchemes_Default).toStringList();
+    QWriteLocker locker(&configurationSnapshotLock);
+    configurationSnapshot = std::move(newSnapshot);
+}
+
+void xRipEncodeConfiguration::updateSettings() {
+    updateSnapshot();
+    settingsSyncTimer->start();
 }
 
 xRipEncodeConfiguration* xRipEncodeConfiguration::configuration() {
@@ -77,15 +176,22 @@ xRipEncodeConfiguration* xRipEncodeConfiguration::configuration() {
 void xRipEncodeConfiguration::setTempDirectory(const QString& directory) {
     if ((directory != getTempDirectory()) && (std::filesystem::is_directory(directory.toStdString()))) {
         settings->setValue(xRipEncodeConfiguration_TempDirectory, directory);
-        settings->sync();
+        updateSettings();
         emit updatedTempDirectory();
     }
 }
 
+void xRipEncodeConfiguration::setTempSpaceQuota(int quota) {
+    if (quota != getTempSpaceQuota()) {
+        settings->setValue(xRipEncodeConfiguration_TempSpaceQuota, quota);
+        updateSettings();
+    }
+}
+
 void xRipEncodeConfiguration::setBackupDirectory(const QString& directory) {
     if ((directory != getBackupDirectory()) && (std::filesystem::is_directory(directory.toStdString()))) {
         settings->setValue(xRipEncodeConfiguration_BackupDirectory, directory);
-        settings->sync();
+        updateSettings();
         emit updatedBackupDirectory();
     }
 }
@@ -93,7 +199,7 @@ void xRipEncodeConfiguration::setBackupDirectory(const QString& directory) {
 void xRipEncodeConfiguration::setEncodingDirectory(const QString& directory) {
     if ((directory != getEncodingDirectory()) && (std::filesystem::is_directory(directory.toStdString()))) {
         settings->setValue(xRipEncodeConfiguration_EncodingDirectory, directory);
-        settings->sync();
+        updateSettings();
         emit updatedEncodingDirectory();
     }
 }
@@ -101,7 +207,7 @@ void xRipEncodeConfiguration::setEncodingDirectory(const QString& directory) {
 void xRipEncodeConfiguration::setFileNameFormat(const QString& format) {
     if (format != getFileNameFormat()) {
         settings->setValue(xRipEncodeConfiguration_FileNameFormat, format);
-        settings->sync();
+        updateSettings();
         emit updatedFileNameFormat();
     }
 }
@@ -110,14 +216,11 @@ void xRipEncodeConfiguration::setFileNameReplace(const QList<std::pair<QString,
     // New values
     auto [nReplaceFrom,nReplaceTo] = xRipEncodeConfiguration::listToString(replace);
     // Retrieve current values.
-    auto replaceFrom = settings->value(xRipEncodeConfiguration_FileNameReplaceFrom,
-                                       xRipEncodeConfiguration_FileNameReplaceFrom_Default).toString();
-    auto replaceTo = settings->value(xRipEncodeConfiguration_FileNameReplaceTo,
-                                     xRipEncodeConfiguration_FileNameReplaceTo_Default).toString();
+    auto [replaceFrom,replaceTo] = xRipEncodeConfiguration::listToString(getFileNameReplace());
     if ((nReplaceFrom != replaceFrom) || (nReplaceTo != replaceTo)) {
         settings->setValue(xRipEncodeConfiguration_FileNameReplaceFrom, nReplaceFrom);
         settings->setValue(xRipEncodeConfiguration_FileNameReplaceTo, nReplaceTo);
-        settings->sync();
+        updateSettings();
         emit updatedFileNameReplace();
     }
 }
@@ -125,7 +228,7 @@ void xRipEncodeConfiguration::setFileNameReplace(const QList<std::pair<QString,
 void xRipEncodeConfiguration::setFileNameLowerCase(bool lowerCase) {
     if (lowerCase != getFileNameLowerCase()) {
         settings->setValue(xRipEncodeConfiguration_FileNameLowerCase, lowerCase);
-        settings->sync();
+        updateSettings();
         emit updatedFileNameLowerCase();
     }
 }
@@ -133,7 +236,7 @@ void xRipEncodeConfiguration::setFileNameLowerCase(bool lowerCase) {
 void xRipEncodeConfiguration::setEncodingFormat(const QString& format) {
     if (format != getEncodingFormat()) {
         settings->setValue(xRipEncodeConfiguration_EncodingFormat, format);
-        settings->sync();
+        updateSettings();
         emit updatedEncodingFormat();
     }
 }
@@ -141,134 +244,228 @@ void xRipEncodeConfiguration::setEncodingFormat(const QString& format) {
 void xRipEncodeConfiguration::setFFMpeg(const QString& path) {
     if ((path != getFFMpeg()) && (std::filesystem::is_regular_file(path.toStdString()))) {
         settings->setValue(xRipEncodeConfiguration_FFMpeg, path);
-        settings->sync();
+        updateSettings();
     }
 }
 
 void xRipEncodeConfiguration::setFFProbe(const QString& path) {
     if ((path != getFFProbe()) && (std::filesystem::is_regular_file(path.toStdString()))) {
         settings->setValue(xRipEncodeConfiguration_FFProbe, path);
-        settings->sync();
+        updateSettings();
     }
 }
 
 void xRipEncodeConfiguration::setMKVMerge(const QString& path) {
     if ((path != getMKVMerge()) && (std::filesystem::is_regular_file(path.toStdString()))) {
         settings->setValue(xRipEncodeConfiguration_MKVMerge, path);
-        settings->sync();
+        updateSettings();
     }
 }
 
 void xRipEncodeConfiguration::setMKVExtract(const QString& path) {
     if ((path != getMKVExtract()) && (std::filesystem::is_regular_file(path.toStdString()))) {
         settings->setValue(xRipEncodeConfiguration_MKVExtract, path);
-        settings->sync();
+        updateSettings();
     }
 }
 
 void xRipEncodeConfiguration::setFlac(const QString& path) {
     if ((path != getFlac()) && (std::filesystem::is_regular_file(path.toStdString()))) {
         settings->setValue(xRipEncodeConfiguration_Flac, path);
-        settings->sync();
+        updateSettings();
     }
 }
 
 void xRipEncodeConfiguration::setWavPack(const QString& path) {
     if ((path != getWavPack()) && (std::filesystem::is_regular_file(path.toStdString()))) {
         settings->setValue(xRipEncodeConfiguration_WavPack, path);
-        settings->sync();
+        updateSettings();
     }
 }
 
 void xRipEncodeConfiguration::setLLTag(const QString& path) {
     if ((path != getLLTag()) && (std::filesystem::is_regular_file(path.toStdString()))) {
-        settings->setValue(xRipEncodeConfiguration_LLTag_Default, path);
-        settings->sync();
+        settings->setValue(xRipEncodeConfiguration_LLTag, path);
+        updateSettings();
+    }
+}
+
+void xRipEncodeConfiguration::setMovieFileDemux(bool demux) {
+    if (demux != getMovieFileDemux()) {
+        settings->setValue(xRipEncodeConfiguration_MovieFileDemux, demux);
+        updateSettings();
+    }
+}
+
+void xRipEncodeConfiguration::setMovieFilePassthrough(bool passthrough) {
+    if (passthrough != getMovieFilePassthrough()) {
+        settings->setValue(xRipEncodeConfiguration_MovieFilePassthrough, passthrough);
+        updateSettings();
+    }
+}
+
+void xRipEncodeConfiguration::setArchiveFileIntegrityScan(bool integrityScan) {
+    if (integrityScan != getArchiveFileIntegrityScan()) {
+        settings->setValue(xRipEncodeConfiguration_ArchiveFileIntegrityScan, integrityScan);
+        updateSettings();
+    }
+}
+
+void xRipEncodeConfiguration::setAudioCDMaxRetries(int retries) {
+    if (retries != getAudioCDMaxRetries()) {
+        settings->setValue(xRipEncodeConfiguration_AudioCDMaxRetries, retries);
+        updateSettings();
+    }
+}
+
+void xRipEncodeConfiguration::setDownMixLevels(const QVector<float>& levels) {
+    if ((levels.count() == 4) && (levels != getDownMixLevels())) {
+        QStringList levelStrings;
+        for (const auto& level : levels) {
+            levelStrings.push_back(QString::number(level));
+        }
+        settings->setValue(xRipEncodeConfiguration_DownMixLevels, levelStrings.join('|'));
+        updateSettings();
+    }
+}
+
+void xRipEncodeConfiguration::setDitherNoiseShaping(bool noiseShaping) {
+    if (noiseShaping != getDitherNoiseShaping()) {
+        settings->setValue(xRipEncodeConfiguration_DitherNoiseShaping, noiseShaping);
+        updateSettings();
+    }
+}
+
+void xRipEncodeConfiguration::setReplayGain(bool replayGain) {
+    if (replayGain != getReplayGain()) {
+        settings->setValue(xRipEncodeConfiguration_ReplayGain, replayGain);
+        updateSettings();
+    }
+}
+
+void xRipEncodeConfiguration::setVerify(bool verify) {
+    if (verify != getVerify()) {
+        settings->setValue(xRipEncodeConfiguration_Verify, verify);
+        updateSettings();
     }
 }
 
 void xRipEncodeConfiguration::setTags(const QStringList& tags) {
     if (tags != getTags()) {
         settings->setValue(xRipEncodeConfiguration_Tags, tags.join('|'));
-        settings->sync();
+        updateSettings();
+    }
+}
+
+void xRipEncodeConfiguration::setTagLookupSchemes(const QStringList& schemes) {
+    if (schemes != getTagLookupSchemes()) {
+        settings->setValue(xRipEncodeConfiguration_TagLookupSchemes, schemes);
+        updateSettings();
     }
 }
 
 QString xRipEncodeConfiguration::getTempDirectory() const {
-    return settings->value(xRipEncodeConfiguration_TempDirectory,
-                           xRipEncodeConfiguration_TempDirectory_Default).toString();
+    return snapshot()->tempDirectory;
+}
+
+int xRipEncodeConfiguration::getTempSpaceQuota() const {
+    return snapshot()->tempSpaceQuota;
 }
 
 QString xRipEncodeConfiguration::getBackupDirectory() const {
-    return settings->value(xRipEncodeConfiguration_BackupDirectory,
-                           xRipEncodeConfiguration_BackupDirectory_Default).toString();
+    return snapshot()->backupDirectory;
 }
 
 QString xRipEncodeConfiguration::getEncodingDirectory() const {
-    return settings->value(xRipEncodeConfiguration_EncodingDirectory,
-                           xRipEncodeConfiguration_EncodingDirectory_Default).toString();
+    return snapshot()->encodingDirectory;
 }
 
 QString xRipEncodeConfiguration::getFileNameFormat() const {
-    return settings->value(xRipEncodeConfiguration_FileNameFormat,
-                           xRipEncodeConfiguration_FileNameFormat_Default).toString();
+    return snapshot()->fileNameFormat;
 }
 
 QList<std::pair<QString,QString>> xRipEncodeConfiguration::getFileNameReplace() const {
-    // Retrieve current values.
-    auto replaceFrom = settings->value(xRipEncodeConfiguration_FileNameReplaceFrom,
-                                       xRipEncodeConfiguration_FileNameReplaceFrom_Default).toString();
-    auto replaceTo = settings->value(xRipEncodeConfiguration_FileNameReplaceTo,
-                                     xRipEncodeConfiguration_FileNameReplaceTo_Default).toString();
-    return xRipEncodeConfiguration::stringsToList(replaceFrom, replaceTo);
+    return snapshot()->fileNameReplace;
 }
 
 bool xRipEncodeConfiguration::getFileNameLowerCase() const {
-    return settings->value(xRipEncodeConfiguration_FileNameLowerCase,
-                           xRipEncodeConfiguration_FileNameLower_Default).toBool();
+    return snapshot()->fileNameLowerCase;
 }
 
 QString xRipEncodeConfiguration::getEncodingFormat() const {
-    return settings->value(xRipEncodeConfiguration_EncodingFormat,
-                           xRipEncodeConfiguration_EncodingFormat_Default).toString();
+    return snapshot()->encodingFormat;
 }
 
 QString xRipEncodeConfiguration::getFFMpeg() const {
-    return settings->value(xRipEncodeConfiguration_FFMpeg, xRipEncodeConfiguration_FFMpeg_Default).toString();
+    return snapshot()->ffmpeg;
 }
 
 QString xRipEncodeConfiguration::getFFProbe() const {
-    return settings->value(xRipEncodeConfiguration_FFProbe, xRipEncodeConfiguration_FFProbe_Default).toString();
+    return snapshot()->ffprobe;
 }
 
 QString xRipEncodeConfiguration::getMKVMerge() const {
-    return settings->value(xRipEncodeConfiguration_MKVMerge, xRipEncodeConfiguration_MKVMerge_Default).toString();
+    return snapshot()->mkvmerge;
 }
 
 QString xRipEncodeConfiguration::getMKVExtract() const {
-    return settings->value(xRipEncodeConfiguration_MKVExtract, xRipEncodeConfiguration_MKVExtract_Default).toString();
+    return snapshot()->mkvextract;
 }
 
 QString xRipEncodeConfiguration::getFlac() const {
-    return settings->value(xRipEncodeConfiguration_Flac, xRipEncodeConfiguration_Flac_Default).toString();
+    return snapshot()->flac;
 }
 
 QString xRipEncodeConfiguration::getWavPack() const {
-    return settings->value(xRipEncodeConfiguration_WavPack, xRipEncodeConfiguration_WavPack_Default).toString();
+    return snapshot()->wavpack;
 }
 
 QString xRipEncodeConfiguration::getLLTag() const {
-    return settings->value(xRipEncodeConfiguration_LLTag, xRipEncodeConfiguration_LLTag_Default).toString();
+    return snapshot()->lltag;
+}
+
+bool xRipEncodeConfiguration::getMovieFileDemux() const {
+    return snapshot()->movieFileDemux;
+}
+
+bool xRipEncodeConfiguration::getMovieFilePassthrough() const {
+    return snapshot()->movieFilePassthrough;
+}
+
+bool xRipEncodeConfiguration::getArchiveFileIntegrityScan() const {
+    return snapshot()->archiveFileIntegrityScan;
+}
+
+int xRipEncodeConfiguration::getAudioCDMaxRetries() const {
+    return snapshot()->audioCDMaxRetries;
+}
+
+QVector<float> xRipEncodeConfiguration::getDownMixLevels() const {
+    return snapshot()->downMixLevels;
+}
+
+bool xRipEncodeConfiguration::getDitherNoiseShaping() const {
+    return snapshot()->ditherNoiseShaping;
+}
+
+bool xRipEncodeConfiguration::getReplayGain() const {
+    return snapshot()->replayGain;
+}
+
+bool xRipEncodeConfiguration::getVerify() const {
+    return snapshot()->verify;
 }
 
 QStringList xRipEncodeConfiguration::getTags() const {
-    auto tags = settings->value(xRipEncodeConfiguration_Tags, xRipEncodeConfiguration_Tags_Default).toString();
-    return tags.split('|');
+    return snapshot()->tags;
 }
 
 QStringList xRipEncodeConfiguration::getTagInfos() const {
-    auto tagInfos = settings->value(xRipEncodeConfiguration_TagInfos, xRipEncodeConfiguration_TagInfos_Default).toString();
-    return tagInfos.split('|');
+    return snapshot()->tagInfos;
+}
+
+QStringList xRipEncodeConfiguration::getTagLookupSchemes() const {
+    return snapshot()->tagLookupSchemes;
 }
 
 void xRipEncodeConfiguration::updatedConfiguration() {
@@ -279,6 +476,23 @@ void xRipEncodeConfiguration::updatedConfiguration() {
     emit updatedFileNameLowerCase();
 }
 
+QVector<float> xRipEncodeConfiguration::stringToLevels(const QString& levels) {
+    QVector<float> levelValues;
+    for (const auto& level : levels.split('|')) {
+        bool valid = false;
+        auto value = level.toFloat(&valid);
+        if ((!valid) || (value < 0.0f) || (value > 1.0f)) {
+            break;
+        }
+        levelValues.push_back(value);
+    }
+    if (levelValues.count() != 4) {
+        qWarning() << "xRipEncodeConfiguration: invalid down mix levels: " << levels << ", using defaults.";
+        return xRipEncodeConfiguration::stringToLevels(xRipEncodeConfiguration_DownMixLevels_Default);
+    }
+    return levelValues;
+}
+
 QList<std::pair<QString,QString>> xRipEncodeConfiguration::stringsToList(const QString& replaceFrom,
                                                                          const QString& replaceTo) {
     QList<std::pair<QString,QString>> replace;
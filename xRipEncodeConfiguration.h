@@ -18,13 +18,50 @@
 #include <QSettings>
 #include <QString>
 #include <QList>
+#include <QVector>
 #include <QUrl>
+#include <QTimer>
+#include <QReadWriteLock>
 #include <QDebug>
 #include <filesystem>
+#include <memory>
 #include <list>
 
 const bool xRipEncodeUseFlatGroupBox = true;
 
+/**
+ * Immutable snapshot of the configuration. A new snapshot is created
+ * whenever the settings change. Snapshots can be read from any thread.
+ */
+struct xRipEncodeConfigurationSnapshot {
+    QString tempDirectory;
+    int tempSpaceQuota;
+    QString backupDirectory;
+    QString encodingDirectory;
+    QString fileNameFormat;
+    QList<std::pair<QString,QString>> fileNameReplace;
+    bool fileNameLowerCase;
+    QString encodingFormat;
+    QString ffmpeg;
+    QString ffprobe;
+    QString mkvmerge;
+    QString mkvextract;
+    QString flac;
+    QString wavpack;
+    QString lltag;
+    bool movieFileDemux;
+    bool movieFilePassthrough;
+    bool archiveFileIntegrityScan;
+    int audioCDMaxRetries;
+    QVector<float> downMixLevels;
+    bool ditherNoiseShaping;
+    bool replayGain;
+    bool verify;
+    QStringList tags;
+    QStringList tagInfos;
+    QStringList tagLookupSchemes;
+};
+
 class xRipEncodeConfiguration:public QObject {
     Q_OBJECT
 
@@ -35,12 +72,29 @@ public:
      * @return pointer to a singleton of the configuration.
      */
     static xRipEncodeConfiguration* configuration();
+    /**
+     * Retrieve the current configuration snapshot.
+     *
+     * The snapshot pointer is copied under a read lock and can therefore be
+     * used from worker threads. The lock is only held for the copy, the values
+     * are read without locking. Use the snapshot if several values are
+     * required at once.
+     *
+     * @return shared pointer to the immutable configuration snapshot.
+     */
+    [[nodiscard]] std::shared_ptr<const xRipEncodeConfigurationSnapshot> snapshot() const;
     /**
      * Set the temp directory for audio CD and movie file rip output.
      *
      * @param directory the absolute path as string.
      */
     void setTempDirectory(const QString& directory);
+    /**
+     * Set the quota for the temporary files in the temp directory.
+     *
+     * @param quota the quota in MB, 0 to use 90% of the free space.
+     */
+    void setTempSpaceQuota(int quota);
     /**
      * Set the backup directory for the wavpack encoded files.
      *
@@ -119,18 +173,80 @@ public:
      * @param path the absolute path as string.
      */
     void setLLTag(const QString& path);
+    /**
+     * Set the internal demuxer mode flag for movie files.
+     *
+     * @param demux extract chapters with libavformat if true, use mkvmerge and ffmpeg otherwise.
+     */
+    void setMovieFileDemux(bool demux);
+    /**
+     * Set the passthrough mode flag for FLAC and PCM movie file audio streams.
+     *
+     * @param passthrough rip into flac files without intermediate wav file if true.
+     */
+    void setMovieFilePassthrough(bool passthrough);
+    /**
+     * Set the flag for the integrity scan of archive files before extraction.
+     *
+     * @param integrityScan validate the CRC of all selected archived files if true.
+     */
+    void setArchiveFileIntegrityScan(bool integrityScan);
+    /**
+     * Set the maximal number of retries for a sector of an audio CD.
+     *
+     * @param retries the number of retries before paranoia skips the sector.
+     */
+    void setAudioCDMaxRetries(int retries);
+    /**
+     * Set the levels used to down mix multi-channel audio streams to stereo.
+     *
+     * @param levels vector of levels for center, lfe, surround and back channels.
+     */
+    void setDownMixLevels(const QVector<float>& levels);
+    /**
+     * Set the noise shaping flag for the dither used to reduce the bits per sample.
+     *
+     * @param noiseShaping use noise shaped dither if true, TPDF dither otherwise.
+     */
+    void setDitherNoiseShaping(bool noiseShaping);
+    /**
+     * Set the flag for the loudness analysis while encoding.
+     *
+     * @param replayGain add ReplayGain 2.0 tags to encoded flac files if true.
+     */
+    void setReplayGain(bool replayGain);
+    /**
+     * Set the flag for the verification of encoded flac files.
+     *
+     * @param verify decode and verify encoded flac files if true.
+     */
+    void setVerify(bool verify);
     /**
      * Set the tags for HD and multi-channel.
      *
      * @param tags list of strings with tags.
      */
     void setTags(const QStringList& tags);
+    /**
+     * Set the tag lookup schemes for archive files.
+     *
+     * Each scheme is defined as "name;bits per sample;quality markers;flags;pattern".
+     *
+     * @param schemes list of strings with scheme definitions.
+     */
+    void setTagLookupSchemes(const QStringList& schemes);
     /**
      * Get the temp directory for audio CD and movie file rip output.
      *
      * @return the temp directory as string.
      */
     [[nodiscard]] QString getTempDirectory() const;
+    /**
+     * Get the quota for the temporary files in the temp directory.
+     *
+     * @return the quota in MB, 0 if 90% of the free space are used.
+     */
+    [[nodiscard]] int getTempSpaceQuota() const;
     /**
      * Get the backup directory for the wavpack encoded files.
      *
@@ -209,6 +325,54 @@ public:
      * @return the absolute path as string.
      */
     [[nodiscard]] QString getLLTag() const;
+    /**
+     * Get the internal demuxer mode flag for movie files.
+     *
+     * @return true, if chapters are extracted with libavformat, false otherwise.
+     */
+    [[nodiscard]] bool getMovieFileDemux() const;
+    /**
+     * Get the passthrough mode flag for FLAC and PCM movie file audio streams.
+     *
+     * @return true, if these streams are ripped into flac files, false otherwise.
+     */
+    [[nodiscard]] bool getMovieFilePassthrough() const;
+    /**
+     * Get the flag for the integrity scan of archive files before extraction.
+     *
+     * @return true, if the CRC of all selected archived files is validated, false otherwise.
+     */
+    [[nodiscard]] bool getArchiveFileIntegrityScan() const;
+    /**
+     * Get the maximal number of retries for a sector of an audio CD.
+     *
+     * @return the number of retries before paranoia skips the sector.
+     */
+    [[nodiscard]] int getAudioCDMaxRetries() const;
+    /**
+     * Get the levels used to down mix multi-channel audio streams to stereo.
+     *
+     * @return vector of levels for center, lfe, surround and back channels.
+     */
+    [[nodiscard]] QVector<float> getDownMixLevels() const;
+    /**
+     * Get the noise shaping flag for the dither used to reduce the bits per sample.
+     *
+     * @return true, if noise shaped dither is used, false for TPDF dither.
+     */
+    [[nodiscard]] bool getDitherNoiseShaping() const;
+    /**
+     * Get the flag for the loudness analysis while encoding.
+     *
+     * @return true, if ReplayGain 2.0 tags are added to encoded flac files, false otherwise.
+     */
+    [[nodiscard]] bool getReplayGain() const;
+    /**
+     * Get the flag for the verification of encoded flac files.
+     *
+     * @return true, if encoded flac files are decoded and verified, false otherwise.
+     */
+    [[nodiscard]] bool getVerify() const;
     /**
      * Get the tags for HD and multi-channel.
      *
@@ -221,6 +385,12 @@ public:
      * @return the list of info strings.
      */
     [[nodiscard]] QStringList getTagInfos() const;
+    /**
+     * Get the tag lookup schemes for archive files.
+     *
+     * @return the list of strings with scheme definitions.
+     */
+    [[nodiscard]] QStringList getTagLookupSchemes() const;
     /**
      * Trigger all update configuration signals.
      *
@@ -274,6 +444,21 @@ private:
      * @return pair of serialized from/to strings.
      */
     static std::pair<QString,QString> listToString(const QList<std::pair<QString,QString>>& replace);
+    /**
+     * Convert the configuration string to down mix levels.
+     *
+     * @param levels serialized list of levels.
+     * @return vector of four levels, the default levels if invalid.
+     */
+    static QVector<float> stringToLevels(const QString& levels);
+    /**
+     * Create a new snapshot out of the current settings and swap it in.
+     */
+    void updateSnapshot();
+    /**
+     * Update the snapshot and schedule writing the settings to disk.
+     */
+    void updateSettings();
 
     xRipEncodeConfiguration();
     ~xRipEncodeConfiguration() override = default;
@@ -283,6 +468,10 @@ private:
 
     static xRipEncodeConfiguration* ripEncodeConfiguration;
     QSettings* settings;
+    QTimer* settingsSyncTimer;
+    // Guards the snapshot pointer, not the immutable snapshot itself.
+    mutable QReadWriteLock configurationSnapshotLock;
+    std::shared_ptr<const xRipEncodeConfigurationSnapshot> configurationSnapshot;
 };
 
 #endif
@@ -13,6 +13,7 @@
  */
 
 #include "xRipEncodeConfigurationDialog.h"
+#include "xFileNameTemplate.h"
 
 #include <QGridLayout>
 #include <QGroupBox>
@@ -38,6 +39,11 @@ xRipEncodeConfigurationDialog::xRipEncodeConfigurationDialog(QWidget* parent, Qt
     fileTempDirectoryLabel->setAlignment(Qt::AlignLeft);
     fileTempDirectoryInput = new QLineEdit(fileTab);
     auto fileTempDirectoryButton = new QPushButton("...", fileTab);
+    auto fileTempSpaceQuotaLabel = new QLabel(tr("Temp Space Quota in MB (0 = 90% of the free space)"), fileTab);
+    fileTempSpaceQuotaLabel->setAlignment(Qt::AlignLeft);
+    fileTempSpaceQuotaInput = new QSpinBox(fileTab);
+    fileTempSpaceQuotaInput->setRange(0, 16*1024*1024);
+    fileTempSpaceQuotaInput->setSingleStep(1024);
     auto fileBackupDirectoryLabel = new QLabel(tr("Backup Directory"), fileTab);
     fileBackupDirectoryLabel->setAlignment(Qt::AlignLeft);
     fileBackupDirectoryInput = new QLineEdit(fileTab);
@@ -57,8 +63,10 @@ xRipEncodeConfigurationDialog::xRipEncodeConfigurationDialog(QWidget* parent, Qt
     fileLayout->addWidget(fileEncodingDirectoryLabel, 4, 0, 1, 4);
     fileLayout->addWidget(fileEncodingDirectoryInput, 5, 0, 1, 3);
     fileLayout->addWidget(fileEncodingDirectoryButton, 5, 3, 1, 1);
-    fileLayout->setRowMinimumHeight(6, 0);
-    fileLayout->setRowStretch(6, 2);
+    fileLayout->addWidget(fileTempSpaceQuotaLabel, 6, 0, 1, 4);
+    fileLayout->addWidget(fileTempSpaceQuotaInput, 7, 0, 1, 1);
+    fileLayout->setRowMinimumHeight(8, 0);
+    fileLayout->setRowStretch(8, 2);
     fileTab->setLayout(fileLayout);
     // Required Programs programs.
     auto programsTab = new QGroupBox(tr("Progam Configuration"), configurationTab);
@@ -91,6 +99,14 @@ xRipEncodeConfigurationDialog::xRipEncodeConfigurationDialog(QWidget* parent, Qt
     fileLLTagLabel->setAlignment(Qt::AlignLeft);
     fileLLTagInput = new QLineEdit(programsTab);
     auto fileLLTagButton = new QPushButton("...", programsTab);
+    fileMovieFileDemux = new QCheckBox(tr("Extract movie file chapters with internal demuxer"), programsTab);
+    fileMovieFilePassthrough = new QCheckBox(tr("Rip FLAC and PCM movie file audio streams directly to flac"), programsTab);
+    fileMovieFilePassthrough->setToolTip(tr("Requires the internal demuxer. Backup to wavpack is not available for these files."));
+    fileArchiveFileIntegrityScan = new QCheckBox(tr("Validate the CRC of archived files before extraction"), programsTab);
+    auto fileAudioCDMaxRetriesLabel = new QLabel(tr("Audio CD retries per sector before skipping"), programsTab);
+    fileAudioCDMaxRetriesLabel->setAlignment(Qt::AlignLeft);
+    fileAudioCDMaxRetriesInput = new QSpinBox(programsTab);
+    fileAudioCDMaxRetriesInput->setRange(1, 1000);
     // Layout for programs configuration.
     auto programsLayout = new QGridLayout();
     programsLayout->addWidget(fileFFMpegLabel, 0, 0, 1, 4);
@@ -114,8 +130,13 @@ xRipEncodeConfigurationDialog::xRipEncodeConfigurationDialog(QWidget* parent, Qt
     programsLayout->addWidget(fileLLTagLabel, 12, 0, 1, 4);
     programsLayout->addWidget(fileLLTagInput, 13, 0, 1, 3);
     programsLayout->addWidget(fileLLTagButton, 13, 3, 1, 1);
-    programsLayout->setRowMinimumHeight(14, 0);
-    programsLayout->setRowStretch(14, 2);
+    programsLayout->addWidget(fileMovieFileDemux, 14, 0, 1, 4);
+    programsLayout->addWidget(fileMovieFilePassthrough, 15, 0, 1, 4);
+    programsLayout->addWidget(fileArchiveFileIntegrityScan, 16, 0, 1, 4);
+    programsLayout->addWidget(fileAudioCDMaxRetriesLabel, 17, 0, 1, 3);
+    programsLayout->addWidget(fileAudioCDMaxRetriesInput, 17, 3, 1, 1);
+    programsLayout->setRowMinimumHeight(18, 0);
+    programsLayout->setRowStretch(18, 2);
     programsTab->setLayout(programsLayout);
     // Create format configuration tab.
     auto formatTab = new QGroupBox(tr("Format Configuration"), configurationTab);
@@ -127,6 +148,13 @@ xRipEncodeConfigurationDialog::xRipEncodeConfigurationDialog(QWidget* parent, Qt
     formatFileNameFormatLabel->setAlignment(Qt::AlignLeft);
     formatFileNameFormatInput = new QLineEdit(formatTab);
     formatFileNameLowerCase = new QCheckBox(tr("Lowercase"), formatTab);
+    auto formatDownMixLevelsLabel = new QLabel(tr("Down Mix Levels (center|lfe|surround|back)"), formatTab);
+    formatDownMixLevelsLabel->setAlignment(Qt::AlignLeft);
+    formatDownMixLevelsInput = new QLineEdit(formatTab);
+    formatDitherNoiseShaping = new QCheckBox(tr("Noise shaped dither for CD quality derivatives"), formatTab);
+    formatDitherNoiseShaping->setToolTip(tr("Use TPDF dither if unchecked"));
+    formatReplayGain = new QCheckBox(tr("Add ReplayGain 2.0 tags (EBU R128) while encoding"), formatTab);
+    formatVerify = new QCheckBox(tr("Verify encoded flac files (STREAMINFO MD5)"), formatTab);
     // Layout for format configuration box.
     auto formatLayout = new QGridLayout();
     formatLayout->addWidget(formatEncodingFormatLabel, 0, 0, 1, 4);
@@ -136,8 +164,15 @@ xRipEncodeConfigurationDialog::xRipEncodeConfigurationDialog(QWidget* parent, Qt
     formatLayout->setRowMinimumHeight(4, 24);
     formatLayout->setRowStretch(4, 0);
     formatLayout->addWidget(formatFileNameLowerCase, 5, 0, 1, 4);
-    formatLayout->setRowMinimumHeight(6, 0);
-    formatLayout->setRowStretch(6, 2);
+    formatLayout->setRowMinimumHeight(6, 24);
+    formatLayout->setRowStretch(6, 0);
+    formatLayout->addWidget(formatDownMixLevelsLabel, 7, 0, 1, 4);
+    formatLayout->addWidget(formatDownMixLevelsInput, 8, 0, 1, 4);
+    formatLayout->addWidget(formatDitherNoiseShaping, 9, 0, 1, 4);
+    formatLayout->addWidget(formatReplayGain, 10, 0, 1, 4);
+    formatLayout->addWidget(formatVerify, 11, 0, 1, 4);
+    formatLayout->setRowMinimumHeight(12, 0);
+    formatLayout->setRowStretch(12, 2);
     formatTab->setLayout(formatLayout);
     // Create replace configuration box
     auto replaceTab = new QGroupBox(tr("Replace Configuration"), configurationTab);
@@ -190,6 +225,8 @@ xRipEncodeConfigurationDialog::xRipEncodeConfigurationDialog(QWidget* parent, Qt
     connect(fileFlacButton, &QPushButton::pressed, [=]() { openFile(tr("Open flac Binary"), fileFlacInput); });
     connect(fileWavPackButton, &QPushButton::pressed, [=]() { openFile(tr("Open wavpack Binary"), fileWavPackInput); });
     connect(fileLLTagButton, &QPushButton::pressed, [=]() { openFile(tr("Open lltag Binary"), fileLLTagInput); });
+    // Passthrough is only supported by the internal demuxer.
+    connect(fileMovieFileDemux, &QCheckBox::toggled, fileMovieFilePassthrough, &QCheckBox::setEnabled);
     // Connect movie library.
     connect(replaceButtons->button(QDialogButtonBox::Apply), &QPushButton::pressed, this, &xRipEncodeConfigurationDialog::replaceEntryAdd);
     connect(replaceButtons->button(QDialogButtonBox::Discard), &QPushButton::pressed, this, &xRipEncodeConfigurationDialog::replaceEntryRemove);
@@ -198,6 +235,16 @@ xRipEncodeConfigurationDialog::xRipEncodeConfigurationDialog(QWidget* parent, Qt
     connect(configurationButtons->button(QDialogButtonBox::Save), &QPushButton::pressed, this, &xRipEncodeConfigurationDialog::saveSettings);
     connect(configurationButtons->button(QDialogButtonBox::Reset), &QPushButton::pressed, this, &xRipEncodeConfigurationDialog::loadSettings);
     connect(configurationButtons->button(QDialogButtonBox::Cancel), &QPushButton::pressed, this, &QDialog::reject);
+    // Validate the formats. Only allow to save valid formats.
+    auto validateFormats = [=]() {
+        auto encodingFormat = xFileNameTemplate(formatEncodingFormatInput->text());
+        auto fileNameFormat = xFileNameTemplate(formatFileNameFormatInput->text());
+        formatEncodingFormatInput->setToolTip(encodingFormat.getError());
+        formatFileNameFormatInput->setToolTip(fileNameFormat.getError());
+        configurationButtons->button(QDialogButtonBox::Save)->setEnabled(encodingFormat.isValid() && fileNameFormat.isValid());
+    };
+    connect(formatEncodingFormatInput, &QLineEdit::textChanged, validateFormats);
+    connect(formatFileNameFormatInput, &QLineEdit::textChanged, validateFormats);
     // Load and resize.
     loadSettings();
     setMinimumWidth(static_cast<int>(sizeHint().height()*1.6));
@@ -207,6 +254,7 @@ xRipEncodeConfigurationDialog::xRipEncodeConfigurationDialog(QWidget* parent, Qt
 void xRipEncodeConfigurationDialog::loadSettings() {
     // Load settings.
     fileTempDirectoryInput->setText(xRipEncodeConfiguration::configuration()->getTempDirectory());
+    fileTempSpaceQuotaInput->setValue(xRipEncodeConfiguration::configuration()->getTempSpaceQuota());
     fileBackupDirectoryInput->setText(xRipEncodeConfiguration::configuration()->getBackupDirectory());
     fileEncodingDirectoryInput->setText(xRipEncodeConfiguration::configuration()->getEncodingDirectory());
     fileFFMpegInput->setText(xRipEncodeConfiguration::configuration()->getFFMpeg());
@@ -216,9 +264,22 @@ void xRipEncodeConfigurationDialog::loadSettings() {
     fileFlacInput->setText(xRipEncodeConfiguration::configuration()->getFlac());
     fileWavPackInput->setText(xRipEncodeConfiguration::configuration()->getWavPack());
     fileLLTagInput->setText(xRipEncodeConfiguration::configuration()->getLLTag());
+    fileMovieFileDemux->setChecked(xRipEncodeConfiguration::configuration()->getMovieFileDemux());
+    fileMovieFilePassthrough->setChecked(xRipEncodeConfiguration::configuration()->getMovieFilePassthrough());
+    fileMovieFilePassthrough->setEnabled(fileMovieFileDemux->isChecked());
+    fileArchiveFileIntegrityScan->setChecked(xRipEncodeConfiguration::configuration()->getArchiveFileIntegrityScan());
+    fileAudioCDMaxRetriesInput->setValue(xRipEncodeConfiguration::configuration()->getAudioCDMaxRetries());
     formatEncodingFormatInput->setText(xRipEncodeConfiguration::configuration()->getEncodingFormat());
     formatFileNameFormatInput->setText(xRipEncodeConfiguration::configuration()->getFileNameFormat());
     formatFileNameLowerCase->setChecked(xRipEncodeConfiguration::configuration()->getFileNameLowerCase());
+    QStringList downMixLevels;
+    for (const auto& level : xRipEncodeConfiguration::configuration()->getDownMixLevels()) {
+        downMixLevels.push_back(QString::number(level));
+    }
+    formatDownMixLevelsInput->setText(downMixLevels.join('|'));
+    formatDitherNoiseShaping->setChecked(xRipEncodeConfiguration::configuration()->getDitherNoiseShaping());
+    formatReplayGain->setChecked(xRipEncodeConfiguration::configuration()->getReplayGain());
+    formatVerify->setChecked(xRipEncodeConfiguration::configuration()->getVerify());
     replaceList->clear();
     auto replace = xRipEncodeConfiguration::configuration()->getFileNameReplace();
     for (const auto& replaceEntry : replace) {
@@ -229,6 +290,7 @@ void xRipEncodeConfigurationDialog::loadSettings() {
 void xRipEncodeConfigurationDialog::saveSettings() {
     // Read setting entries.
     xRipEncodeConfiguration::configuration()->setTempDirectory(fileTempDirectoryInput->text());
+    xRipEncodeConfiguration::configuration()->setTempSpaceQuota(fileTempSpaceQuotaInput->value());
     xRipEncodeConfiguration::configuration()->setBackupDirectory(fileBackupDirectoryInput->text());
     xRipEncodeConfiguration::configuration()->setEncodingDirectory(fileEncodingDirectoryInput->text());
     xRipEncodeConfiguration::configuration()->setFFMpeg(fileFFMpegInput->text());
@@ -238,9 +300,26 @@ void xRipEncodeConfigurationDialog::saveSettings() {
     xRipEncodeConfiguration::configuration()->setFlac(fileFlacInput->text());
     xRipEncodeConfiguration::configuration()->setWavPack(fileWavPackInput->text());
     xRipEncodeConfiguration::configuration()->setLLTag(fileLLTagInput->text());
+    xRipEncodeConfiguration::configuration()->setMovieFileDemux(fileMovieFileDemux->isChecked());
+    xRipEncodeConfiguration::configuration()->setMovieFilePassthrough(fileMovieFilePassthrough->isChecked());
+    xRipEncodeConfiguration::configuration()->setArchiveFileIntegrityScan(fileArchiveFileIntegrityScan->isChecked());
+    xRipEncodeConfiguration::configuration()->setAudioCDMaxRetries(fileAudioCDMaxRetriesInput->value());
     xRipEncodeConfiguration::configuration()->setEncodingFormat(formatEncodingFormatInput->text());
     xRipEncodeConfiguration::configuration()->setFileNameFormat(formatFileNameFormatInput->text());
     xRipEncodeConfiguration::configuration()->setFileNameLowerCase(formatFileNameLowerCase->isChecked());
+    QVector<float> downMixLevels;
+    for (const auto& level : formatDownMixLevelsInput->text().split('|')) {
+        bool valid = false;
+        auto value = level.trimmed().toFloat(&valid);
+        if ((valid) && (value >= 0.0f) && (value <= 1.0f)) {
+            downMixLevels.push_back(value);
+        }
+    }
+    // Invalid levels are ignored.
+    xRipEncodeConfiguration::configuration()->setDownMixLevels(downMixLevels);
+    xRipEncodeConfiguration::configuration()->setDitherNoiseShaping(formatDitherNoiseShaping->isChecked());
+    xRipEncodeConfiguration::configuration()->setReplayGain(formatReplayGain->isChecked());
+    xRipEncodeConfiguration::configuration()->setVerify(formatVerify->isChecked());
     QList<std::pair<QString,QString>> replace;
     for (auto index = 0; index < replaceList->count(); ++index) {
         auto replaceWidget = dynamic_cast<xReplaceItemWidget*>(replaceList->itemWidget(replaceList->item(index)));
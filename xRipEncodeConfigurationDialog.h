@@ -91,6 +91,7 @@ private:
     static std::pair<QString,QString> splitReplaceEntries(const QString& entry);
 
     QLineEdit* fileTempDirectoryInput;
+    QSpinBox* fileTempSpaceQuotaInput;
     QLineEdit* fileBackupDirectoryInput;
     QLineEdit* fileEncodingDirectoryInput;
     QLineEdit* fileFFMpegInput;
@@ -100,9 +101,17 @@ private:
     QLineEdit* fileFlacInput;
     QLineEdit* fileWavPackInput;
     QLineEdit* fileLLTagInput;
+    QCheckBox* fileMovieFileDemux;
+    QCheckBox* fileMovieFilePassthrough;
+    QCheckBox* fileArchiveFileIntegrityScan;
+    QSpinBox* fileAudioCDMaxRetriesInput;
     QLineEdit* formatEncodingFormatInput;
     QLineEdit* formatFileNameFormatInput;
     QCheckBox* formatFileNameLowerCase;
+    QLineEdit* formatDownMixLevelsInput;
+    QCheckBox* formatDitherNoiseShaping;
+    QCheckBox* formatReplayGain;
+    QCheckBox* formatVerify;
     QLineEdit* replaceFromInput;
     QLineEdit* replaceToInput;
     xReplaceWidget* replaceList;
@@ -0,0 +1,116 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "xTempSpace.h"
+#include "xRipEncodeConfiguration.h"
+#include <QStorageInfo>
+#include <QFileInfo>
+#include <QThread>
+#include <QMutexLocker>
+#include <QDebug>
+
+// Interval in ms to check for interruption and removed files while waiting.
+const unsigned long xTempSpace_WaitInterval { 1000 };
+
+xTempSpace::xTempSpace():
+        tempSpaceFiles(),
+        tempSpaceWritten(),
+        tempSpaceReserved(0) {
+}
+
+xTempSpace* xTempSpace::tempSpace() {
+    // Create and return singleton. The initialization of the local static is thread-safe.
+    static xTempSpace tempSpaceObject;
+    return &tempSpaceObject;
+}
+
+bool xTempSpace::available(qint64 bytes) {
+    QMutexLocker locker(&tempSpaceLock);
+    evict();
+    return (tempSpaceReserved == 0) || (tempSpaceReserved + bytes <= quota());
+}
+
+bool xTempSpace::reserve(const QList<std::pair<QString,qint64>>& files) {
+    qint64 bytes = 0;
+    for (const auto& file : files) {
+        bytes += file.second;
+    }
+    QMutexLocker locker(&tempSpaceLock);
+    evict();
+    // A job larger than the quota is run alone.
+    while ((tempSpaceReserved > 0) && (tempSpaceReserved + bytes > quota())) {
+        if (QThread::currentThread()->isInterruptionRequested()) {
+            return false;
+        }
+        tempSpaceReleased.wait(&tempSpaceLock, xTempSpace_WaitInterval);
+        evict();
+    }
+    for (const auto& file : files) {
+        // Replace a previous reservation for the same file.
+        tempSpaceReserved -= tempSpaceFiles.value(file.first, 0);
+        tempSpaceFiles[file.first] = file.second;
+        tempSpaceWritten.remove(file.first);
+        tempSpaceReserved += file.second;
+    }
+    qDebug() << "xTempSpace::reserve: " << bytes << " bytes, reserved: " << tempSpaceReserved;
+    return true;
+}
+
+void xTempSpace::release(const QString& fileName) {
+    QMutexLocker locker(&tempSpaceLock);
+    auto file = tempSpaceFiles.find(fileName);
+    if (file != tempSpaceFiles.end()) {
+        tempSpaceReserved -= file.value();
+        tempSpaceFiles.erase(file);
+        tempSpaceWritten.remove(fileName);
+        tempSpaceReleased.wakeAll();
+    }
+}
+
+qint64 xTempSpace::reserved() const {
+    QMutexLocker locker(&tempSpaceLock);
+    return tempSpaceReserved;
+}
+
+qint64 xTempSpace::quota() const {
+    auto quotaMB = xRipEncodeConfiguration::configuration()->getTempSpaceQuota();
+    if (quotaMB > 0) {
+        return static_cast<qint64>(quotaMB)*1024*1024;
+    }
+    // Use 90% of the space that is free or reserved, but not yet written.
+    QStorageInfo storage(xRipEncodeConfiguration::configuration()->getTempDirectory());
+    qint64 written = 0;
+    for (auto file = tempSpaceFiles.cbegin(); file != tempSpaceFiles.cend(); ++file) {
+        written += std::min(QFileInfo(file.key()).size(), file.value());
+    }
+    return (storage.bytesAvailable() + written)/10*9;
+}
+
+void xTempSpace::evict() {
+    // Files removed by the user or after an aborted encoding. Only evict files that
+    // have been seen before, otherwise reservations of pending jobs would be dropped.
+    for (auto file = tempSpaceFiles.begin(); file != tempSpaceFiles.end(); ) {
+        if (QFileInfo::exists(file.key())) {
+            tempSpaceWritten.insert(file.key());
+            ++file;
+        } else if (tempSpaceWritten.remove(file.key())) {
+            qDebug() << "xTempSpace::evict: " << file.key();
+            tempSpaceReserved -= file.value();
+            file = tempSpaceFiles.erase(file);
+            tempSpaceReleased.wakeAll();
+        } else {
+            ++file;
+        }
+    }
+}
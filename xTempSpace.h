@@ -0,0 +1,97 @@
+/*
+ * This file is part of xRipEncode.
+ *
+ * xRipEncode is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xRipEncode is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __XTEMPSPACE_H__
+#define __XTEMPSPACE_H__
+
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
+
+/**
+ * @class xTempSpace
+ *
+ * @note Bound the space used by the files in the temp directory. The producers
+ * (ripper, movie file and archive file extraction) reserve the space of all
+ * files of a job before writing them and wait while the quota is exceeded.
+ * The space is released once a file is encoded and removed. Files of manual
+ * jobs and failed batch tracks are released once they wait for the user, the
+ * quota only bounds the files written or queued for the batch encoding. A job
+ * larger than the quota is only started if no other files are reserved.
+ * Reservations can be made from any thread.
+ */
+class xTempSpace {
+
+public:
+    /**
+     * Return the temp space object.
+     *
+     * @return pointer to a singleton of the temp space.
+     */
+    static xTempSpace* tempSpace();
+    /**
+     * Check if the given number of bytes can be reserved without waiting.
+     *
+     * @param bytes the number of bytes to reserve.
+     * @return true if the space is available, false otherwise.
+     */
+    [[nodiscard]] bool available(qint64 bytes);
+    /**
+     * Reserve the space for all files of a job. Wait until enough space is released.
+     *
+     * The wait is aborted if an interruption of the current thread is requested.
+     *
+     * @param files list of pairs of file name and estimated size in bytes.
+     * @return true if the space was reserved, false if the wait was interrupted.
+     */
+    bool reserve(const QList<std::pair<QString,qint64>>& files);
+    /**
+     * Release the space reserved for the file.
+     *
+     * @param fileName the file name as string. Ignored if no space was reserved.
+     */
+    void release(const QString& fileName);
+    /**
+     * Return the space currently reserved.
+     *
+     * @return the reserved space in bytes.
+     */
+    [[nodiscard]] qint64 reserved() const;
+
+private:
+    xTempSpace();
+    ~xTempSpace() = default;
+    /**
+     * Determine the quota from the configuration or the free space of the temp directory.
+     *
+     * @return the quota in bytes.
+     */
+    [[nodiscard]] qint64 quota() const;
+    /**
+     * Release the reservations of files that were written and then removed
+     * without calling release.
+     */
+    void evict();
+
+    mutable QMutex tempSpaceLock;
+    QWaitCondition tempSpaceReleased;
+    QMap<QString,qint64> tempSpaceFiles;
+    QSet<QString> tempSpaceWritten;
+    qint64 tempSpaceReserved;
+};
+
+#endif